@@ -2,33 +2,466 @@
 
 namespace mgo
 {
-    Application::Application()
+#pragma mark - mgo::RenderSnapshot
+    RenderSnapshot::RenderSnapshot() noexcept
     :
-    window_("Mangos Eninge", 500, 500),
+    frame_(0)
+    {
+    }
+    
+    void RenderSnapshot::reset(std::uint64_t frame) noexcept
+    {
+        // Clearing keeps the capacity, so a snapshot stops allocating once it has seen a typical frame.
+        this->drawCommands_.clear();
+        this->firstInstances_.clear();
+        this->instances_.clear();
+        this->frustum_.reset();
+        this->frameData_.reset();
+        this->frame_ = frame;
+    }
+    
+    void RenderSnapshot::draw(const vk::DrawCommand& drawCommand)
+    {
+        this->drawCommands_.push_back(drawCommand);
+        this->firstInstances_.push_back(NO_INSTANCES);
+    }
+    
+    void RenderSnapshot::draw(const vk::DrawCommand& drawCommand, const std::vector<vk::InstanceData>& instances)
+    {
+        this->drawCommands_.push_back(drawCommand);
+        this->drawCommands_.back().instanceCount_ = static_cast<std::uint32_t>(instances.size());
+        this->firstInstances_.push_back(this->instances_.size());
+        this->instances_.insert(this->instances_.end(), instances.begin(), instances.end());
+    }
+    
+    void RenderSnapshot::setFrustum(const vk::IndirectRenderer::Frustum& frustum) noexcept
+    {
+        this->frustum_ = frustum;
+    }
+    
+    void RenderSnapshot::setFrameData(const vk::FrameData& frameData) noexcept
+    {
+        this->frameData_ = frameData;
+    }
+    
+    const std::vector<vk::DrawCommand>& RenderSnapshot::getDrawCommands() const noexcept
+    {
+        return this->drawCommands_;
+    }
+    
+    const std::vector<std::size_t>& RenderSnapshot::getFirstInstances() const noexcept
+    {
+        return this->firstInstances_;
+    }
+    
+    const std::vector<vk::InstanceData>& RenderSnapshot::getInstances() const noexcept
+    {
+        return this->instances_;
+    }
+    
+    const std::optional<vk::IndirectRenderer::Frustum>& RenderSnapshot::getFrustum() const noexcept
+    {
+        return this->frustum_;
+    }
+    
+    const std::optional<vk::FrameData>& RenderSnapshot::getFrameData() const noexcept
+    {
+        return this->frameData_;
+    }
+    
+    std::uint64_t RenderSnapshot::getFrame() const noexcept
+    {
+        return this->frame_;
+    }
+    
+#pragma mark - Application
+    Application::Application(const ApplicationSettings& settings)
+    :
+    window_("Mangos Eninge", settings.windowWidth_, settings.windowHeight_, settings.headless_),
     instance_("Mangos Enigne", "Mangos App", this->window_),
 #if MGO_DEBUG
     debugUtilsMessenger_(this->instance_),
 #endif
     surface_(this->instance_, this->window_),
-    physicalDevice_(this->instance_, this->surface_),
+    physicalDevice_(this->instance_, this->surface_, settings.allowCpuDevice_),
     device_(this->instance_, this->surface_, this->physicalDevice_),
-    swapchain_(this->surface_, this->physicalDevice_, this->device_),
-    imageViews_(this->device_, this->swapchain_),
+    queueTimelines_(this->device_),
+    memoryAllocator_(this->physicalDevice_, this->device_),
+    deletionQueue_(this->queueTimelines_),
+    swapchain_(this->surface_, this->physicalDevice_, this->device_, this->memoryAllocator_, this->deletionQueue_, settings.presentPolicy_, settings.swapchainImageCount_),
+    imageViews_(this->device_, this->deletionQueue_, this->swapchain_),
     renderPass_(this->device_, this->swapchain_),
-    framebuffers_(this->device_, this->swapchain_, this->imageViews_, this->renderPass_),
-    pipelineLayout_(this->device_),
-    pipeline_(this->device_, this->renderPass_, this->pipelineLayout_),
+    renderGraph_(this->physicalDevice_, this->device_, this->memoryAllocator_, this->deletionQueue_, this->swapchain_, this->imageViews_),
+    bindlessDescriptors_(this->physicalDevice_, this->device_, this->deletionQueue_),
+    frameAllocator_(this->physicalDevice_, this->device_, this->memoryAllocator_, this->queueTimelines_, settings.framesInFlight_),
+    pipelineLayout_(this->device_, this->bindlessDescriptors_, this->frameAllocator_),
+    pipelineCache_(this->physicalDevice_, this->device_, settings.pipelineCachePath_),
+    shaderLibrary_(this->device_),
+    fallbackPipeline_(this->device_, this->renderPass_, this->pipelineLayout_, this->pipelineCache_, this->shaderLibrary_, vk::PipelineDescription::getFallback()),
+    pipelineBuilder_(this->device_, this->renderPass_, this->pipelineLayout_, this->pipelineCache_, this->shaderLibrary_),
+    pipeline_(this->pipelineBuilder_.build(vk::PipelineDescription()), this->fallbackPipeline_),
+    cullPipeline_(this->device_, this->pipelineLayout_, this->pipelineCache_, this->shaderLibrary_, vk::IndirectRenderer::CULL_SHADER_PATH),
     commandPool_(this->physicalDevice_, this->device_),
-    commandBuffer_(this->window_, this->device_, this->swapchain_, this->renderPass_, this->framebuffers_, this->pipeline_, this->commandPool_)
-    {}
+    transferCommandPool_(this->physicalDevice_, this->device_, vk::PhysicalDevice::QueueType::TRANSFER),
+    stagingRing_(this->device_, this->memoryAllocator_, this->transferCommandPool_, this->queueTimelines_),
+    computeCommandPool_(this->physicalDevice_, this->device_, vk::PhysicalDevice::QueueType::COMPUTE),
+    asyncCompute_(this->device_, this->computeCommandPool_, this->queueTimelines_),
+    vertexBuffer_(this->device_, this->memoryAllocator_, this->stagingRing_, settings.vertices_),
+    indexBuffer_(this->device_, this->memoryAllocator_, this->stagingRing_, settings.indices_),
+    instanceBuffer_(this->device_, this->memoryAllocator_, this->stagingRing_, settings.instances_),
+    indirectRenderer_(this->device_,
+                      this->memoryAllocator_,
+                      this->deletionQueue_,
+                      this->stagingRing_,
+                      this->bindlessDescriptors_,
+                      this->pipelineLayout_,
+                      this->cullPipeline_),
+    commandBuffer_(this->window_,
+                   this->device_,
+                   this->queueTimelines_,
+                   this->deletionQueue_,
+                   this->swapchain_,
+                   this->renderGraph_,
+                   this->pipelineLayout_,
+                   this->pipeline_,
+                   this->commandPool_,
+                   this->vertexBuffer_,
+                   this->indexBuffer_,
+                   this->instanceBuffer_,
+                   settings.framesInFlight_,
+                   settings.recordingThreadCount_),
+    snapshots_(std::max(settings.renderSnapshotCount_, 2u)),
+    updatedFrames_(0),
+    renderedFrames_(0),
+    stopping_(false)
+    {
+        vk::RenderGraph::Attachment backbuffer{};
+        backbuffer.resource_ = vk::RenderGraph::BACKBUFFER;
+        backbuffer.loadOp_ = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        backbuffer.clearValue_.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+        
+        vk::RenderGraph::PassDescription scenePass{};
+        scenePass.colorAttachments_ = {backbuffer};
+        scenePass.subpassContents_ = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+        scenePass.prepare_ = [this](VkCommandBuffer commandBuffer)
+        {
+            this->indirectRenderer_.cull(commandBuffer);
+        };
+        scenePass.execute_ = [this](const vk::RenderGraph::PassContext& passContext)
+        {
+            this->commandBuffer_.recordScene(passContext);
+        };
+        this->renderGraph_.addPass("Scene", scenePass);
+        
+        this->commandBuffer_.setDrawCommands({{this->indexBuffer_.size(), 1, 0, 0, 0}});
+        this->commandBuffer_.setIndirectRenderer(&this->indirectRenderer_);
+        this->uploadPendingData();
+    }
+    
+    Application::~Application() noexcept
+    {
+        // Nothing may be destroyed while the GPU still uses it.
+        this->device_.wait();
+    }
             
     void Application::run()
     {
-        while (!this->window_.shouldClose())
+        this->runPipelined(std::numeric_limits<std::uint64_t>::max());
+    }
+    
+    void Application::run(std::uint64_t frameCount)
+    {
+        this->runPipelined(frameCount);
+    }
+    
+    void Application::runFrame()
+    {
+        // Lock-step frame: update and render one snapshot on the calling thread.
+        RenderSnapshot& snapshot = this->snapshots_[this->updatedFrames_ % this->snapshots_.size()];
+        this->window_.pollEvents();
+        this->update(snapshot);
+        this->updatedFrames_++;
+        this->render(snapshot);
+        this->renderedFrames_++;
+    }
+    
+    void Application::setUpdateFunction(const UpdateFunction& updateFunction)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        this->updateFunction_ = updateFunction;
+    }
+    
+    void Application::setDrawCommands(const std::vector<vk::DrawCommand>& drawCommands)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        this->commandBuffer_.setDrawCommands(drawCommands);
+    }
+    
+    vk::DrawCommand Application::pushInstances(const vk::DrawCommand& drawCommand, const std::vector<vk::InstanceData>& instances)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        auto [pInstances, instancedDrawCommand] = this->allocateInstances(drawCommand, instances.size());
+        std::memcpy(pInstances, instances.data(), sizeof(vk::InstanceData) * instances.size());
+        return instancedDrawCommand;
+    }
+    
+    vk::DrawCommand Application::pushInstances(const vk::DrawCommand& drawCommand,
+                                               const std::vector<std::array<float, 16>>& transforms,
+                                               const std::vector<std::array<float, 4>>& colors,
+                                               const std::vector<std::uint32_t>& materialIndices)
+    {
+        if (colors.size() != transforms.size() || materialIndices.size() != transforms.size())
+            throw std::runtime_error("Failed to push instances: attribute streams differ in length!");
+        
+        // The streams are interleaved straight into the frame's slice.
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        auto [pInstances, instancedDrawCommand] = this->allocateInstances(drawCommand, transforms.size());
+        for (std::size_t i = 0; i < transforms.size(); i++)
+            pInstances[i] = {transforms[i], colors[i], materialIndices[i]};
+        return instancedDrawCommand;
+    }
+    
+    std::pair<vk::InstanceData*, vk::DrawCommand> Application::allocateInstances(const vk::DrawCommand& drawCommand, std::size_t instanceCount)
+    {
+        vk::FrameAllocator::Allocation allocation = this->frameAllocator_.allocate(sizeof(vk::InstanceData) * instanceCount, vk::FrameAllocator::Usage::VERTEX);
+        
+        vk::DrawCommand instancedDrawCommand = drawCommand;
+        instancedDrawCommand.instanceCount_ = static_cast<std::uint32_t>(instanceCount);
+        instancedDrawCommand.firstInstance_ = 0;
+        instancedDrawCommand.instanceBuffer_ = this->frameAllocator_.getBuffer();
+        instancedDrawCommand.instanceOffset_ = allocation.dynamicOffset_;
+        return {static_cast<vk::InstanceData*>(allocation.pData_), instancedDrawCommand};
+    }
+    
+    const vk::AsyncPipeline& Application::buildPipeline(const vk::PipelineDescription& pipelineDescription)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        return this->scenePipelines_.emplace_back(this->pipelineBuilder_.build(pipelineDescription), this->fallbackPipeline_);
+    }
+    
+    void Application::setPresentPolicy(const vk::PresentPolicy& presentPolicy)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        this->swapchain_.setPresentPolicy(presentPolicy);
+    }
+    
+    void Application::setIndirectObjects(const std::vector<vk::IndirectRenderer::Object>& objects)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        this->indirectRenderer_.setObjects(objects);
+    }
+    
+    void Application::setIndirectFrustum(const vk::IndirectRenderer::Frustum& frustum)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        this->indirectRenderer_.setFrustum(frustum);
+    }
+    
+    void Application::setFrameData(const vk::FrameData& frameData)
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        this->frameData_ = frameData;
+    }
+    
+    vk::FrameAllocator::Allocation Application::allocateFrameData(VkDeviceSize size, vk::FrameAllocator::Usage usage)
+    {
+        // The slice belongs to the next frame rendered, endFrame cannot move the allocator past it meanwhile.
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        return this->frameAllocator_.allocate(size, usage);
+    }
+    
+    std::uint64_t Application::submitCompute(const vk::AsyncCompute::RecordFunction& record, VkPipelineStageFlags frameWaitStages)
+    {
+        std::uint64_t value = this->asyncCompute_.submit(record);
+        // A non-zero stage mask makes the next frame wait for the batch on the GPU.
+        if (frameWaitStages != 0)
+        {
+            std::lock_guard<std::mutex> lock(this->renderMutex_);
+            this->commandBuffer_.waitTimeline(this->asyncCompute_.getQueueType(), value, frameWaitStages);
+        }
+        return value;
+    }
+    
+    const vk::GpuProfiler& Application::getGpuProfiler() const noexcept
+    {
+        return this->commandBuffer_.getGpuProfiler();
+    }
+    
+    vk::RenderGraph& Application::getRenderGraph() noexcept
+    {
+        return this->renderGraph_;
+    }
+    
+    vk::QueueTimelines& Application::getQueueTimelines() noexcept
+    {
+        return this->queueTimelines_;
+    }
+    
+    vk::DeletionQueue& Application::getDeletionQueue() noexcept
+    {
+        return this->deletionQueue_;
+    }
+    
+    vk::BindlessDescriptors& Application::getBindlessDescriptors() noexcept
+    {
+        return this->bindlessDescriptors_;
+    }
+    
+    const vk::FrameAllocator& Application::getFrameAllocator() const noexcept
+    {
+        return this->frameAllocator_;
+    }
+    
+    const vk::IndirectRenderer& Application::getIndirectRenderer() const noexcept
+    {
+        return this->indirectRenderer_;
+    }
+    
+    void Application::runPipelined(std::uint64_t frameCount)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->snapshotMutex_);
+            this->updatedFrames_ = 0;
+            this->renderedFrames_ = 0;
+            this->stopping_ = false;
+            this->renderException_ = nullptr;
+        }
+        
+        // The main thread polls and updates frame N + 1 while the render thread records and submits frame N.
+        std::thread renderThread(&Application::renderLoop, this);
+        
+        std::exception_ptr updateException;
+        try
         {
-            this->window_.pollEvents();
-            this->commandBuffer_.draw();
+            for (std::uint64_t frame = 0; frame < frameCount && !this->window_.shouldClose(); frame++)
+            {
+                this->window_.pollEvents();
+                
+                RenderSnapshot* pSnapshot = nullptr;
+                {
+                    trace::Scope scope("Application::waitForSnapshot");
+                    std::unique_lock<std::mutex> lock(this->snapshotMutex_);
+                    this->snapshotCondition_.wait(lock, [this]()
+                    {
+                        return this->stopping_ || this->updatedFrames_ - this->renderedFrames_ < this->snapshots_.size();
+                    });
+                    if (this->stopping_)
+                        break;
+                    pSnapshot = &this->snapshots_[this->updatedFrames_ % this->snapshots_.size()];
+                }
+                
+                this->update(*pSnapshot);
+                
+                {
+                    std::lock_guard<std::mutex> lock(this->snapshotMutex_);
+                    this->updatedFrames_++;
+                }
+                this->snapshotCondition_.notify_all();
+            }
         }
+        catch (...)
+        {
+            updateException = std::current_exception();
+        }
+        
+        // The render thread drains the snapshots already published before it stops.
+        {
+            std::lock_guard<std::mutex> lock(this->snapshotMutex_);
+            this->stopping_ = true;
+        }
+        this->snapshotCondition_.notify_all();
+        renderThread.join();
         this->device_.wait();
+        
+        if (this->renderException_)
+            std::rethrow_exception(this->renderException_);
+        if (updateException)
+            std::rethrow_exception(updateException);
+    }
+    
+    void Application::renderLoop() noexcept
+    {
+        trace::Tracer::get().setThreadName("Render");
+        
+        while (true)
+        {
+            const RenderSnapshot* pSnapshot = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(this->snapshotMutex_);
+                this->snapshotCondition_.wait(lock, [this]() { return this->stopping_ || this->renderedFrames_ < this->updatedFrames_; });
+                if (this->renderedFrames_ == this->updatedFrames_ || this->renderException_)
+                    return;
+                pSnapshot = &this->snapshots_[this->renderedFrames_ % this->snapshots_.size()];
+            }
+            
+            try
+            {
+                this->render(*pSnapshot);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(this->snapshotMutex_);
+                this->renderException_ = std::current_exception();
+                this->stopping_ = true;
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(this->snapshotMutex_);
+                this->renderedFrames_++;
+            }
+            this->snapshotCondition_.notify_all();
+        }
+    }
+    
+    void Application::update(RenderSnapshot& snapshot)
+    {
+        trace::Scope scope("Application::update");
+        snapshot.reset(this->updatedFrames_);
+        // The copy runs unlocked, so the function may replace itself and render() is not held up meanwhile.
+        UpdateFunction updateFunction;
+        {
+            std::lock_guard<std::mutex> lock(this->renderMutex_);
+            updateFunction = this->updateFunction_;
+        }
+        if (updateFunction)
+            updateFunction(snapshot);
+    }
+    
+    void Application::render(const RenderSnapshot& snapshot)
+    {
+        trace::Scope scope("Application::render");
+        std::lock_guard<std::mutex> lock(this->renderMutex_);
+        // Without an update function the draw commands set before running are kept.
+        if (this->updateFunction_)
+        {
+            std::vector<vk::DrawCommand> drawCommands = snapshot.getDrawCommands();
+            for (std::size_t i = 0; i < drawCommands.size(); i++)
+                if (snapshot.getFirstInstances()[i] != RenderSnapshot::NO_INSTANCES)
+                {
+                    auto [pInstances, instancedDrawCommand] = this->allocateInstances(drawCommands[i], drawCommands[i].instanceCount_);
+                    std::memcpy(pInstances, snapshot.getInstances().data() + snapshot.getFirstInstances()[i], sizeof(vk::InstanceData) * drawCommands[i].instanceCount_);
+                    drawCommands[i] = instancedDrawCommand;
+                }
+            this->commandBuffer_.setDrawCommands(drawCommands);
+            
+            if (snapshot.getFrustum().has_value())
+                this->indirectRenderer_.setFrustum(snapshot.getFrustum().value());
+            if (snapshot.getFrameData().has_value())
+                this->frameData_ = snapshot.getFrameData().value();
+        }
+        
+        // Draws without a uniform slice of their own read this frame's FrameData.
+        this->commandBuffer_.setFrameUniformOffset(this->frameAllocator_.push(this->frameData_).dynamicOffset_);
+        this->uploadPendingData();
+        this->commandBuffer_.draw();
+        this->frameAllocator_.endFrame(this->queueTimelines_.getSubmittedValue(vk::PhysicalDevice::QueueType::GRAPHICS));
+    }
+    
+    void Application::uploadPendingData()
+    {
+        this->stagingRing_.collect();
+        std::uint64_t uploadValue = this->stagingRing_.flush();
+        if (uploadValue != 0)
+            this->commandBuffer_.waitTimeline(this->stagingRing_.getQueueType(), uploadValue, vk::StagingRing::WAIT_STAGES);
     }
 }
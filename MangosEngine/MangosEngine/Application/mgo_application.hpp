@@ -1,11 +1,78 @@
 #pragma once
 #define GLFW_INCLUDE_VULKAN
 #include "mgo_vulkan.hpp"
+#include <limits>
 namespace mgo
 {
+#pragma mark - mgo::ApplicationSettings
+    struct ApplicationSettings
+    {
+        std::uint32_t windowWidth_ = 500;
+        std::uint32_t windowHeight_ = 500;
+        bool headless_ = false;
+        bool allowCpuDevice_ = false;
+        std::uint32_t framesInFlight_ = vk::CommandBuffers::DEFAULT_FRAMES_IN_FLIGHT;
+        std::uint32_t swapchainImageCount_ = 0;
+        std::uint32_t recordingThreadCount_ = 0;
+        std::uint32_t renderSnapshotCount_ = 2;
+        vk::PresentPolicy presentPolicy_;
+        std::string pipelineCachePath_ = "MangosEngine.pipelinecache";
+        std::vector<vk::Vertex> vertices_ = {{{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}},
+                                             {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}},
+                                             {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}};
+        std::vector<std::uint32_t> indices_ = {0, 1, 2};
+        std::vector<vk::InstanceData> instances_ = {{{1.0f, 0.0f, 0.0f, 0.0f,
+                                                  0.0f, 1.0f, 0.0f, 0.0f,
+                                                  0.0f, 0.0f, 1.0f, 0.0f,
+                                                  0.0f, 0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}, vk::BindlessDescriptors::INVALID_HANDLE}};
+    };
+    
+#pragma mark - mgo::RenderSnapshot
+    class RenderSnapshot final
+    {
+    public:
+        static const std::size_t NO_INSTANCES = std::numeric_limits<std::size_t>::max();
+        
+    private:
+        std::vector<vk::DrawCommand> drawCommands_;
+        std::vector<std::size_t> firstInstances_;
+        std::vector<vk::InstanceData> instances_;
+        std::optional<vk::IndirectRenderer::Frustum> frustum_;
+        std::optional<vk::FrameData> frameData_;
+        std::uint64_t frame_;
+        
+    public:
+        RenderSnapshot() noexcept;
+        
+        void reset(std::uint64_t frame) noexcept;
+        
+        void draw(const vk::DrawCommand& drawCommand);
+        
+        void draw(const vk::DrawCommand& drawCommand, const std::vector<vk::InstanceData>& instances);
+        
+        void setFrustum(const vk::IndirectRenderer::Frustum& frustum) noexcept;
+        
+        void setFrameData(const vk::FrameData& frameData) noexcept;
+        
+        const std::vector<vk::DrawCommand>& getDrawCommands() const noexcept;
+        
+        const std::vector<std::size_t>& getFirstInstances() const noexcept;
+        
+        const std::vector<vk::InstanceData>& getInstances() const noexcept;
+        
+        const std::optional<vk::IndirectRenderer::Frustum>& getFrustum() const noexcept;
+        
+        const std::optional<vk::FrameData>& getFrameData() const noexcept;
+        
+        std::uint64_t getFrame() const noexcept;
+    };
+    
 #pragma mark - Application
     class Application final
     {
+    public:
+        using UpdateFunction = std::function<void(RenderSnapshot& snapshot)>;
+        
     private:
         glfw::Window window_;
         vk::Instance instance_;
@@ -15,18 +82,106 @@ namespace mgo
         vk::Surface surface_;
         vk::PhysicalDevice physicalDevice_;
         vk::Device device_;
+        vk::QueueTimelines queueTimelines_;
+        vk::MemoryAllocator memoryAllocator_;
+        vk::DeletionQueue deletionQueue_;
         vk::Swapchain swapchain_;
         vk::ImageViews imageViews_;
         vk::RenderPass renderPass_;
-        vk::Framebuffers framebuffers_;
+        vk::RenderGraph renderGraph_;
+        vk::BindlessDescriptors bindlessDescriptors_;
+        vk::FrameAllocator frameAllocator_;
         vk::PipelineLayout pipelineLayout_;
-        vk::Pipeline pipeline_;
+        vk::PipelineCache pipelineCache_;
+        vk::ShaderLibrary shaderLibrary_;
+        vk::Pipeline fallbackPipeline_;
+        vk::PipelineBuilder pipelineBuilder_;
+        vk::AsyncPipeline pipeline_;
+        vk::ComputePipeline cullPipeline_;
+        std::deque<vk::AsyncPipeline> scenePipelines_;
         vk::CommandPool commandPool_;
+        vk::CommandPool transferCommandPool_;
+        vk::StagingRing stagingRing_;
+        vk::CommandPool computeCommandPool_;
+        vk::AsyncCompute asyncCompute_;
+        vk::VertexBuffer vertexBuffer_;
+        vk::IndexBuffer indexBuffer_;
+        vk::InstanceBuffer instanceBuffer_;
+        vk::IndirectRenderer indirectRenderer_;
         vk::CommandBuffers commandBuffer_;
+        vk::FrameData frameData_;
+        std::vector<RenderSnapshot> snapshots_;
+        UpdateFunction updateFunction_;
+        std::mutex snapshotMutex_;
+        // Held by render() and by every public method that changes state the render thread reads.
+        std::mutex renderMutex_;
+        std::condition_variable snapshotCondition_;
+        std::uint64_t updatedFrames_;
+        std::uint64_t renderedFrames_;
+        bool stopping_;
+        std::exception_ptr renderException_;
         
     public:
-        Application();
+        Application(const ApplicationSettings& settings = ApplicationSettings());
+        
+        ~Application() noexcept;
                         
         void run();
+        
+        void run(std::uint64_t frameCount);
+        
+        void runFrame();
+        
+        void setUpdateFunction(const UpdateFunction& updateFunction);
+        
+        void setDrawCommands(const std::vector<vk::DrawCommand>& drawCommands);
+        
+        vk::DrawCommand pushInstances(const vk::DrawCommand& drawCommand, const std::vector<vk::InstanceData>& instances);
+        
+        vk::DrawCommand pushInstances(const vk::DrawCommand& drawCommand,
+                                      const std::vector<std::array<float, 16>>& transforms,
+                                      const std::vector<std::array<float, 4>>& colors,
+                                      const std::vector<std::uint32_t>& materialIndices);
+        
+        const vk::AsyncPipeline& buildPipeline(const vk::PipelineDescription& pipelineDescription);
+        
+        void setPresentPolicy(const vk::PresentPolicy& presentPolicy);
+        
+        void setIndirectObjects(const std::vector<vk::IndirectRenderer::Object>& objects);
+        
+        void setIndirectFrustum(const vk::IndirectRenderer::Frustum& frustum);
+        
+        void setFrameData(const vk::FrameData& frameData);
+        
+        vk::FrameAllocator::Allocation allocateFrameData(VkDeviceSize size, vk::FrameAllocator::Usage usage);
+        
+        std::uint64_t submitCompute(const vk::AsyncCompute::RecordFunction& record, VkPipelineStageFlags frameWaitStages = 0);
+        
+        const vk::GpuProfiler& getGpuProfiler() const noexcept;
+        
+        vk::RenderGraph& getRenderGraph() noexcept;
+        
+        vk::QueueTimelines& getQueueTimelines() noexcept;
+        
+        vk::DeletionQueue& getDeletionQueue() noexcept;
+        
+        vk::BindlessDescriptors& getBindlessDescriptors() noexcept;
+        
+        const vk::FrameAllocator& getFrameAllocator() const noexcept;
+        
+        const vk::IndirectRenderer& getIndirectRenderer() const noexcept;
+        
+    private:
+        void runPipelined(std::uint64_t frameCount);
+        
+        void renderLoop() noexcept;
+        
+        void update(RenderSnapshot& snapshot);
+        
+        void render(const RenderSnapshot& snapshot);
+        
+        std::pair<vk::InstanceData*, vk::DrawCommand> allocateInstances(const vk::DrawCommand& drawCommand, std::size_t instanceCount);
+        
+        void uploadPendingData();
     };
 }
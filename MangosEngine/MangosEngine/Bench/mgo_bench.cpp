@@ -0,0 +1,240 @@
+#include "mgo_application.hpp"
+#include <string_view>
+#include <random>
+#include <chrono>
+#include <sstream>
+#include <array>
+#include <numeric>
+namespace
+{
+#pragma mark - BenchScene
+    struct BenchScene
+    {
+        std::string name_;
+        std::uint32_t triangleCount_;
+        std::uint32_t drawCount_;
+        std::uint32_t pipelineCount_;
+    };
+    
+    // The triangles of a scene are split evenly across its draws, and draws cycle through its pipelines.
+    const std::vector<BenchScene> BENCH_SCENES = {
+        {"triangles-1k",    1000,   1,      1},
+        {"triangles-100k",  100000, 1,      1},
+        {"draws-1k",        1000,   1000,   1},
+        {"draws-10k",       10000,  10000,  1},
+        {"pipelines-8",     1000,   1000,   8},
+        {"pipelines-64",    1000,   1000,   64},
+    };
+    
+    const std::uint32_t BENCH_SEED = 1;
+    const std::chrono::seconds PIPELINE_TIMEOUT = std::chrono::seconds(60);
+    
+#pragma mark - BenchSettings
+    struct BenchSettings
+    {
+        std::uint64_t frameCount_ = 500;
+        std::uint64_t warmupFrameCount_ = 50;
+        std::uint32_t recordingThreadCount_ = 0;
+        std::vector<std::string> sceneNames_;
+        std::string outputPath_;
+    };
+    
+#pragma mark - BenchResult
+    struct BenchResult
+    {
+        const BenchScene& scene_;
+        std::vector<double> cpuMilliseconds_;
+        std::vector<double> gpuMilliseconds_;
+        double cpuDrawsPerSecond_;
+        double gpuDrawsPerSecond_;
+    };
+    
+    void generateScene(const BenchScene& scene, mgo::ApplicationSettings& settings)
+    {
+        std::mt19937 generator(BENCH_SEED);
+        std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> color(0.0f, 1.0f);
+        
+        settings.vertices_.clear();
+        settings.indices_.clear();
+        for (std::uint32_t triangle = 0; triangle < scene.triangleCount_; triangle++)
+        {
+            float x = position(generator);
+            float y = position(generator);
+            std::array<float, 3> triangleColor = {color(generator), color(generator), color(generator)};
+            
+            settings.vertices_.push_back({{x, y - 0.02f}, triangleColor});
+            settings.vertices_.push_back({{x + 0.02f, y + 0.02f}, triangleColor});
+            settings.vertices_.push_back({{x - 0.02f, y + 0.02f}, triangleColor});
+            for (std::uint32_t vertex = 0; vertex < 3; vertex++)
+                settings.indices_.push_back(3 * triangle + vertex);
+        }
+    }
+    
+    mgo::vk::PipelineDescription getPipelineDescription(std::uint32_t pipeline)
+    {
+        // Every pipeline of a scene differs in real fixed-function state: 15 write masks, 3 cull modes, blending on or off.
+        const std::array<VkCullModeFlags, 3> cullModes = {VK_CULL_MODE_NONE, VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_FRONT_BIT};
+        
+        mgo::vk::PipelineDescription description;
+        description.colorWriteMask_ = static_cast<VkColorComponentFlags>(1 + pipeline % 15);
+        description.cullMode_ = cullModes[(pipeline / 15) % cullModes.size()];
+        description.blendEnable_ = (pipeline / 45) % 2 == 1;
+        return description;
+    }
+    
+    double getDrawsPerSecond(const std::vector<double>& milliseconds, std::uint32_t drawCount)
+    {
+        double totalSeconds = std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0) / 1000.0;
+        return totalSeconds > 0.0 ? static_cast<double>(drawCount * milliseconds.size()) / totalSeconds : 0.0;
+    }
+    
+    void writeFrameTimes(std::ostream& stream, std::vector<double> milliseconds)
+    {
+        if (milliseconds.empty())
+        {
+            stream << "null";
+            return;
+        }
+        
+        std::sort(milliseconds.begin(), milliseconds.end());
+        std::size_t p99Rank = static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(milliseconds.size())));
+        stream << "{\"min\": " << milliseconds.front()
+               << ", \"mean\": " << std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0) / static_cast<double>(milliseconds.size())
+               << ", \"p99\": " << milliseconds[std::max(p99Rank, static_cast<std::size_t>(1)) - 1]
+               << ", \"samples\": " << milliseconds.size() << "}";
+    }
+    
+    BenchResult runScene(const BenchScene& scene, const BenchSettings& benchSettings)
+    {
+        mgo::ApplicationSettings settings;
+        settings.headless_ = true;
+        settings.allowCpuDevice_ = true;
+        settings.recordingThreadCount_ = benchSettings.recordingThreadCount_;
+        generateScene(scene, settings);
+        
+        mgo::Application application(settings);
+        
+        std::vector<const mgo::vk::AsyncPipeline*> pipelines;
+        for (std::uint32_t i = 0; i < scene.pipelineCount_; i++)
+            pipelines.push_back(&application.buildPipeline(getPipelineDescription(i)));
+        
+        // Frames drawn with fallback pipelines would not be comparable, so wait for every build.
+        auto deadline = std::chrono::steady_clock::now() + PIPELINE_TIMEOUT;
+        while (!std::all_of(pipelines.begin(), pipelines.end(), [](const mgo::vk::AsyncPipeline* pPipeline) { return pPipeline->isReady(); }))
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                throw std::runtime_error("Timed out building pipelines for bench scene " + scene.name_ + "!");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        
+        std::uint32_t trianglesPerDraw = scene.triangleCount_ / scene.drawCount_;
+        std::vector<mgo::vk::DrawCommand> drawCommands;
+        for (std::uint32_t draw = 0; draw < scene.drawCount_; draw++)
+            drawCommands.push_back({3 * trianglesPerDraw, 1, 3 * trianglesPerDraw * draw, 0, 0, pipelines[draw % pipelines.size()]});
+        application.setDrawCommands(drawCommands);
+        
+        BenchResult result{scene, {}, {}, 0.0, 0.0};
+        const mgo::vk::GpuProfiler& gpuProfiler = application.getGpuProfiler();
+        std::uint64_t gpuSampleCount = 0;
+        
+        for (std::uint64_t frame = 0; frame < benchSettings.warmupFrameCount_ + benchSettings.frameCount_; frame++)
+        {
+            auto frameBegin = std::chrono::steady_clock::now();
+            application.runFrame();
+            auto frameEnd = std::chrono::steady_clock::now();
+            
+            // GPU times arrive framesInFlight frames late, one sample per completed frame.
+            std::optional<mgo::vk::GpuProfiler::Statistics> gpuStatistics = gpuProfiler.getStatistics(mgo::vk::GpuProfiler::FRAME_SCOPE);
+            bool newGpuSample = gpuStatistics.has_value() && gpuStatistics->totalSampleCount_ > gpuSampleCount;
+            if (newGpuSample)
+                gpuSampleCount = gpuStatistics->totalSampleCount_;
+            
+            if (frame < benchSettings.warmupFrameCount_)
+                continue;
+            
+            result.cpuMilliseconds_.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameBegin).count());
+            if (newGpuSample)
+                result.gpuMilliseconds_.push_back(gpuStatistics->lastMilliseconds_);
+        }
+        
+        // CPU throughput covers recording and submission; GPU throughput covers execution of the same frames.
+        result.cpuDrawsPerSecond_ = getDrawsPerSecond(result.cpuMilliseconds_, scene.drawCount_);
+        result.gpuDrawsPerSecond_ = getDrawsPerSecond(result.gpuMilliseconds_, scene.drawCount_);
+        return result;
+    }
+    
+    void writeResults(std::ostream& stream, const BenchSettings& benchSettings, const std::vector<BenchResult>& results)
+    {
+        stream << "{\n  \"frames\": " << benchSettings.frameCount_ << ",\n  \"warmupFrames\": " << benchSettings.warmupFrameCount_ << ",\n  \"scenes\": [";
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            const BenchResult& result = results[i];
+            stream << (i == 0 ? "\n" : ",\n")
+                   << "    {\"name\": \"" << result.scene_.name_ << "\""
+                   << ", \"triangles\": " << result.scene_.triangleCount_
+                   << ", \"draws\": " << result.scene_.drawCount_
+                   << ", \"pipelines\": " << result.scene_.pipelineCount_
+                   << ",\n     \"cpuFrameMilliseconds\": ";
+            writeFrameTimes(stream, result.cpuMilliseconds_);
+            stream << ",\n     \"gpuFrameMilliseconds\": ";
+            writeFrameTimes(stream, result.gpuMilliseconds_);
+            stream << ",\n     \"cpuDrawsPerSecond\": " << result.cpuDrawsPerSecond_
+                   << ", \"gpuDrawsPerSecond\": " << result.gpuDrawsPerSecond_ << "}";
+        }
+        stream << "\n  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        BenchSettings benchSettings;
+        
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view argument(argv[i]);
+            if (argument == "--frames" && i + 1 < argc)
+                benchSettings.frameCount_ = std::stoull(argv[++i]);
+            else if (argument == "--warmup" && i + 1 < argc)
+                benchSettings.warmupFrameCount_ = std::stoull(argv[++i]);
+            else if (argument == "--recording-threads" && i + 1 < argc)
+                benchSettings.recordingThreadCount_ = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            else if (argument == "--scene" && i + 1 < argc)
+                benchSettings.sceneNames_.emplace_back(argv[++i]);
+            else if (argument == "--output" && i + 1 < argc)
+                benchSettings.outputPath_ = argv[++i];
+            else
+                throw std::runtime_error("Unknown argument: " + std::string(argument));
+        }
+        
+        for (const std::string& sceneName : benchSettings.sceneNames_)
+            if (std::none_of(BENCH_SCENES.begin(), BENCH_SCENES.end(), [&sceneName](const BenchScene& scene) { return scene.name_ == sceneName; }))
+                throw std::runtime_error("Unknown bench scene: " + sceneName);
+        
+        std::vector<BenchResult> results;
+        for (const BenchScene& scene : BENCH_SCENES)
+            if (benchSettings.sceneNames_.empty() ||
+                std::find(benchSettings.sceneNames_.begin(), benchSettings.sceneNames_.end(), scene.name_) != benchSettings.sceneNames_.end())
+                results.push_back(runScene(scene, benchSettings));
+        
+        std::ostringstream json;
+        writeResults(json, benchSettings, results);
+        
+        if (benchSettings.outputPath_.empty())
+            std::cout << json.str();
+        else
+        {
+            std::ofstream file(benchSettings.outputPath_, std::ios::trunc);
+            if (!(file << json.str()))
+                throw std::runtime_error("Failed to write bench results to " + benchSettings.outputPath_ + "!");
+        }
+    }
+    catch (const std::exception& errorMessage)
+    {
+        MGO_LOG_ERROR(errorMessage.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
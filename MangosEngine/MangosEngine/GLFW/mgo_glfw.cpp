@@ -1,16 +1,24 @@
 #include "mgo_glfw.hpp"
+#include "mgo_trace.hpp"
 namespace mgo
 {
     namespace glfw
     {
 #pragma mark - mgo::glfw::Window
-        Window::Window(const std::string& windowName, std::uint32_t windowWidth, std::uint32_t windowHeight)
+        Window::Window(const std::string& windowName, std::uint32_t windowWidth, std::uint32_t windowHeight, bool headless)
         :
+        pWindow_(nullptr),
         windowName_(windowName),
         windowHeight_(windowHeight),
         windowWidth_(windowWidth),
-        framebufferResized_(false)
+        headless_(headless),
+        framebufferResized_(false),
+        framebufferSize_((static_cast<std::uint64_t>(windowWidth) << 32) | windowHeight)
         {
+            // A headless window never touches GLFW so it can run on machines without a display.
+            if (this->headless_)
+                return;
+            
             glfwSetErrorCallback(this->errorCallback);
             
             if (!glfwInit())
@@ -25,10 +33,17 @@ namespace mgo
             
             glfwSetWindowUserPointer(this->pWindow_, this);
             glfwSetFramebufferSizeCallback(this->pWindow_, this->framebufferResizeCallback);
+            
+            int width, height;
+            glfwGetFramebufferSize(this->pWindow_, &width, &height);
+            this->storeFramebufferSize(width, height);
         }
         
         Window::~Window() noexcept
         {
+            if (this->headless_)
+                return;
+            
             glfwDestroyWindow(this->pWindow_);
             glfwTerminate();
         }
@@ -40,6 +55,9 @@ namespace mgo
         
         std::vector<const char*> Window::getExtensions() const noexcept
         {
+            if (this->headless_)
+                return {};
+            
             std::uint32_t extensionCount = 0;
             const char** requiredInstanceExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
             
@@ -48,38 +66,53 @@ namespace mgo
         
         VkResult Window::createSurface(VkInstance instance, VkSurfaceKHR* pSurface) const
         {
+            if (this->headless_)
+                return VK_ERROR_EXTENSION_NOT_PRESENT;
+            
             return glfwCreateWindowSurface(instance, this->pWindow_, nullptr, pSurface);
         }
         
         VkExtent2D Window::GetFramebufferSize() const noexcept
         {
-            int width, height;
+            if (this->headless_)
+                return {this->windowWidth_, this->windowHeight_};
             
-            glfwGetFramebufferSize(this->pWindow_, &width, &height);
+            // GLFW may only be queried on the main thread, so the size is cached for the render thread.
+            std::uint64_t framebufferSize = this->framebufferSize_.load(std::memory_order_acquire);
             
-            return {static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height)};
+            return {static_cast<std::uint32_t>(framebufferSize >> 32), static_cast<std::uint32_t>(framebufferSize)};
         }
         
         bool Window::shouldClose() const noexcept
         {
+            if (this->headless_)
+                return false;
+            
             return glfwWindowShouldClose(this->pWindow_);
         }
         
         void Window::pollEvents() noexcept
         {
-            glfwPollEvents();
+            trace::Scope scope("Window::pollEvents");
+            if (!this->headless_)
+                glfwPollEvents();
         }
         
         bool Window::hasResized() noexcept
         {
-            if (this->framebufferResized_)
-            {
-                this->framebufferResized_ = false;
-                return true;
-            }
-            return false;
+            return this->framebufferResized_.exchange(false);
+        }
+        
+        bool Window::isHeadless() const noexcept
+        {
+            return this->headless_;
         }
 
+        void Window::storeFramebufferSize(int width, int height) noexcept
+        {
+            this->framebufferSize_.store((static_cast<std::uint64_t>(width) << 32) | static_cast<std::uint32_t>(height), std::memory_order_release);
+        }
+        
         void Window::errorCallback(int error, const char* description) noexcept
         {
             MGO_DEBUG_LOG_ERROR("GLFW error: " << description);
@@ -88,6 +121,7 @@ namespace mgo
         void Window::framebufferResizeCallback(GLFWwindow* pWindow, int width, int height)
         {
             auto window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(pWindow));
+            window->storeFramebufferSize(width, height);
             window->framebufferResized_ = true;
         }
     }
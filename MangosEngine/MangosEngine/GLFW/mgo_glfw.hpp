@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 #include <exception>
+#include <atomic>
+#include <cstdint>
 namespace mgo
 {
     namespace glfw
@@ -17,10 +19,13 @@ namespace mgo
             const std::string windowName_;
             const std::uint32_t windowHeight_;
             const std::uint32_t windowWidth_;
-            bool framebufferResized_;
+            const bool headless_;
+            // Written by callbacks on the main thread, read by the thread that presents.
+            std::atomic<bool> framebufferResized_;
+            std::atomic<std::uint64_t> framebufferSize_;
             
         public:
-            Window(const std::string& windowName, std::uint32_t windowWidth, std::uint32_t windowHeight);
+            Window(const std::string& windowName, std::uint32_t windowWidth, std::uint32_t windowHeight, bool headless = false);
             
             ~Window() noexcept;
             
@@ -38,7 +43,11 @@ namespace mgo
             
             bool hasResized() noexcept;
             
+            bool isHeadless() const noexcept;
+            
         private:
+            void storeFramebufferSize(int width, int height) noexcept;
+            
             static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
             
             static void errorCallback(int error, const char* description) noexcept;
@@ -0,0 +1,363 @@
+#include "mgo_jobs.hpp"
+namespace mgo
+{
+    namespace jobs
+    {
+        namespace
+        {
+            // Index of the calling worker's deque, -1 on threads the scheduler does not own.
+            thread_local std::int32_t tWorkerIndex = -1;
+        }
+
+#pragma mark - mgo::jobs::Counter
+        Counter::Counter() noexcept
+        :
+        value_(0)
+        {
+        }
+
+        Counter::~Counter() noexcept
+        {
+            // Continuations of a counter that never reached zero can no longer run.
+            for (Job* pJob : this->continuations_)
+                delete pJob;
+        }
+
+        bool Counter::isDone() const noexcept
+        {
+            return this->value_.load(std::memory_order_acquire) == 0;
+        }
+
+        std::uint32_t Counter::getValue() const noexcept
+        {
+            return this->value_.load(std::memory_order_acquire);
+        }
+
+#pragma mark - mgo::jobs::WorkStealingDeque
+        WorkStealingDeque::WorkStealingDeque() noexcept
+        :
+        top_(0),
+        bottom_(0)
+        {
+            for (auto& job : this->jobs_)
+                job.store(nullptr, std::memory_order_relaxed);
+        }
+
+        bool WorkStealingDeque::push(Job* pJob) noexcept
+        {
+            std::int64_t bottom = this->bottom_.load(std::memory_order_relaxed);
+            std::int64_t top = this->top_.load(std::memory_order_acquire);
+            if (bottom - top >= static_cast<std::int64_t>(CAPACITY))
+                return false;
+
+            this->jobs_[static_cast<std::size_t>(bottom) % CAPACITY].store(pJob, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            this->bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        Job* WorkStealingDeque::pop() noexcept
+        {
+            std::int64_t bottom = this->bottom_.load(std::memory_order_relaxed) - 1;
+            this->bottom_.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t top = this->top_.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                this->bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Job* pJob = this->jobs_[static_cast<std::size_t>(bottom) % CAPACITY].load(std::memory_order_relaxed);
+            if (top == bottom)
+            {
+                // The last job may be stolen concurrently; whoever advances top owns it.
+                if (!this->top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    pJob = nullptr;
+                this->bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return pJob;
+        }
+
+        Job* WorkStealingDeque::steal() noexcept
+        {
+            std::int64_t top = this->top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t bottom = this->bottom_.load(std::memory_order_acquire);
+            if (top >= bottom)
+                return nullptr;
+
+            Job* pJob = this->jobs_[static_cast<std::size_t>(top) % CAPACITY].load(std::memory_order_relaxed);
+            if (!this->top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return pJob;
+        }
+
+#pragma mark - mgo::jobs::Scheduler
+        Scheduler::Scheduler()
+        :
+        injectedJobCount_(0),
+        queuedJobCount_(0),
+        sleepingWorkerCount_(0),
+        stopping_(false),
+        // The thread waiting on a counter runs jobs too, so one core is left to it.
+        workerCount_(std::max(std::thread::hardware_concurrency(), 2u) - 1)
+        {
+            // Workers name themselves in the tracer, which therefore has to outlive the scheduler.
+            trace::Tracer::get();
+
+            for (std::uint32_t worker = 0; worker < this->workerCount_; worker++)
+                this->deques_.push_back(std::make_unique<WorkStealingDeque>());
+            for (std::uint32_t worker = 0; worker < this->workerCount_; worker++)
+                this->workers_.emplace_back(&Scheduler::work, this, worker);
+        }
+
+        Scheduler::~Scheduler() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->sleepMutex_);
+                this->stopping_.store(true);
+            }
+            this->sleepCondition_.notify_all();
+
+            for (auto& worker : this->workers_)
+                worker.join();
+
+            for (Job* pJob : this->injectedJobs_)
+                delete pJob;
+            for (auto& deque : this->deques_)
+                while (Job* pJob = deque->pop())
+                    delete pJob;
+        }
+
+        Scheduler& Scheduler::get() noexcept
+        {
+            static Scheduler scheduler;
+            return scheduler;
+        }
+
+        void Scheduler::run(std::function<void()> function, Counter* pCounter)
+        {
+            if (pCounter != nullptr)
+                pCounter->value_.fetch_add(1, std::memory_order_relaxed);
+            this->submit({new Job{std::move(function), pCounter}});
+        }
+
+        void Scheduler::runAfter(Counter& dependency, std::function<void()> function, Counter* pCounter)
+        {
+            if (pCounter != nullptr)
+                pCounter->value_.fetch_add(1, std::memory_order_relaxed);
+            Job* pJob = new Job{std::move(function), pCounter};
+
+            {
+                std::lock_guard<std::mutex> lock(dependency.mutex_);
+                if (dependency.value_.load(std::memory_order_acquire) != 0)
+                {
+                    dependency.continuations_.push_back(pJob);
+                    return;
+                }
+            }
+            this->submit({pJob});
+        }
+
+        void Scheduler::wait(Counter& counter)
+        {
+            trace::Scope scope("Scheduler::wait");
+            // Waiting threads run other jobs instead of blocking, so nested waits cannot starve the workers.
+            while (!counter.isDone())
+            {
+                if (Job* pJob = this->findJob())
+                    this->execute(pJob);
+                else
+                    std::this_thread::yield();
+            }
+
+            // Taking the lock waits for the last job to leave complete(), after which the counter may be destroyed.
+            std::exception_ptr exception;
+            {
+                std::lock_guard<std::mutex> lock(counter.mutex_);
+                exception = std::exchange(counter.exception_, nullptr);
+            }
+            if (exception)
+                std::rethrow_exception(exception);
+        }
+
+        void Scheduler::parallelFor(std::size_t count, std::size_t minBatchSize, const RangeFunction& function)
+        {
+            if (count == 0)
+                return;
+
+            const std::size_t batchCount = std::clamp(count / std::max(minBatchSize, static_cast<std::size_t>(1)),
+                                                      static_cast<std::size_t>(1),
+                                                      BATCHES_PER_THREAD * this->getThreadCount());
+
+            Counter counter;
+            counter.value_.store(static_cast<std::uint32_t>(batchCount - 1), std::memory_order_relaxed);
+            std::vector<Job*> jobs;
+            for (std::size_t batch = 1; batch < batchCount; batch++)
+                jobs.push_back(new Job{[&function, count, batch, batchCount]()
+                {
+                    function(count * batch / batchCount, count * (batch + 1) / batchCount);
+                }, &counter});
+            this->submit(jobs);
+
+            // The caller takes the first batch, and must not leave before the others finish with the function.
+            std::exception_ptr exception;
+            try
+            {
+                function(0, count / batchCount);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+            this->wait(counter);
+            if (exception)
+                std::rethrow_exception(exception);
+        }
+
+        std::uint32_t Scheduler::getWorkerCount() const noexcept
+        {
+            return this->workerCount_;
+        }
+
+        std::uint32_t Scheduler::getThreadCount() const noexcept
+        {
+            return this->workerCount_ + 1;
+        }
+
+        void Scheduler::work(std::uint32_t workerIndex) noexcept
+        {
+            tWorkerIndex = static_cast<std::int32_t>(workerIndex);
+            trace::Tracer::get().setThreadName("Job worker " + std::to_string(workerIndex));
+
+            while (!this->stopping_.load(std::memory_order_relaxed))
+            {
+                if (Job* pJob = this->findJob())
+                {
+                    this->execute(pJob);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(this->sleepMutex_);
+                this->sleepingWorkerCount_.fetch_add(1);
+                this->sleepCondition_.wait(lock, [this]() { return this->stopping_.load() || this->queuedJobCount_.load() > 0; });
+                this->sleepingWorkerCount_.fetch_sub(1);
+            }
+        }
+
+        void Scheduler::submit(const std::vector<Job*>& jobs)
+        {
+            if (jobs.empty())
+                return;
+
+            this->queuedJobCount_.fetch_add(jobs.size());
+
+            // Workers push onto their own deque; other threads and overflow go through the shared queue.
+            std::size_t injectedFrom = 0;
+            if (tWorkerIndex >= 0)
+                while (injectedFrom < jobs.size() && this->deques_[static_cast<std::size_t>(tWorkerIndex)]->push(jobs[injectedFrom]))
+                    injectedFrom++;
+            if (injectedFrom < jobs.size())
+            {
+                std::lock_guard<std::mutex> lock(this->injectedMutex_);
+                this->injectedJobs_.insert(this->injectedJobs_.end(), jobs.begin() + static_cast<std::ptrdiff_t>(injectedFrom), jobs.end());
+                this->injectedJobCount_.store(this->injectedJobs_.size());
+            }
+
+            if (this->sleepingWorkerCount_.load() > 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(this->sleepMutex_);
+                }
+                if (jobs.size() == 1)
+                    this->sleepCondition_.notify_one();
+                else
+                    this->sleepCondition_.notify_all();
+            }
+        }
+
+        Job* Scheduler::findJob() noexcept
+        {
+            if (this->queuedJobCount_.load() == 0)
+                return nullptr;
+
+            Job* pJob = nullptr;
+            if (tWorkerIndex >= 0)
+                pJob = this->deques_[static_cast<std::size_t>(tWorkerIndex)]->pop();
+
+            if (pJob == nullptr && this->injectedJobCount_.load() > 0)
+            {
+                std::lock_guard<std::mutex> lock(this->injectedMutex_);
+                if (!this->injectedJobs_.empty())
+                {
+                    pJob = this->injectedJobs_.front();
+                    this->injectedJobs_.pop_front();
+                    this->injectedJobCount_.store(this->injectedJobs_.size());
+                }
+            }
+
+            // Victims are visited starting after the caller, so thieves spread over the deques.
+            for (std::uint32_t offset = 1; pJob == nullptr && offset <= this->workerCount_; offset++)
+            {
+                std::uint32_t victim = static_cast<std::uint32_t>(tWorkerIndex + static_cast<std::int32_t>(offset)) % this->workerCount_;
+                if (static_cast<std::int32_t>(victim) != tWorkerIndex)
+                    pJob = this->deques_[victim]->steal();
+            }
+
+            if (pJob != nullptr)
+                this->queuedJobCount_.fetch_sub(1);
+            return pJob;
+        }
+
+        void Scheduler::execute(Job* pJob) noexcept
+        {
+            std::exception_ptr exception;
+            try
+            {
+                pJob->function_();
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            Counter* pCounter = pJob->pCounter_;
+            delete pJob;
+            if (pCounter == nullptr)
+                return;
+
+            if (exception)
+            {
+                std::lock_guard<std::mutex> lock(pCounter->mutex_);
+                if (!pCounter->exception_)
+                    pCounter->exception_ = exception;
+            }
+            this->complete(pCounter);
+        }
+
+        void Scheduler::complete(Counter* pCounter) noexcept
+        {
+            std::vector<Job*> continuations;
+            {
+                // The decrement happens under the lock so a waiter cannot destroy the counter while it is held.
+                std::lock_guard<std::mutex> lock(pCounter->mutex_);
+                if (pCounter->value_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    return;
+                continuations.swap(pCounter->continuations_);
+            }
+
+            try
+            {
+                this->submit(continuations);
+            }
+            catch (...)
+            {
+                // Without memory for the queue the continuations run here instead.
+                for (Job* pJob : continuations)
+                    this->execute(pJob);
+            }
+        }
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "mgo_trace.hpp"
+#include <vector>
+#include <array>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+namespace mgo
+{
+    namespace jobs
+    {
+        struct Job;
+
+#pragma mark - mgo::jobs::Counter
+        class Counter final
+        {
+            friend class Scheduler;
+
+        private:
+            std::atomic<std::uint32_t> value_;
+            std::vector<Job*> continuations_;
+            std::exception_ptr exception_;
+            std::mutex mutex_;
+
+        public:
+            Counter() noexcept;
+
+            ~Counter() noexcept;
+
+            Counter(const Counter&) = delete;
+
+            Counter& operator=(const Counter&) = delete;
+
+            bool isDone() const noexcept;
+
+            std::uint32_t getValue() const noexcept;
+        };
+
+#pragma mark - mgo::jobs::Job
+        struct Job
+        {
+            std::function<void()> function_;
+            Counter* pCounter_;
+        };
+
+#pragma mark - mgo::jobs::WorkStealingDeque
+        class WorkStealingDeque final
+        {
+        public:
+            static const std::size_t CAPACITY = 4096;
+
+        private:
+            // Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from the top.
+            std::array<std::atomic<Job*>, CAPACITY> jobs_;
+            alignas(64) std::atomic<std::int64_t> top_;
+            alignas(64) std::atomic<std::int64_t> bottom_;
+
+        public:
+            WorkStealingDeque() noexcept;
+
+            bool push(Job* pJob) noexcept;
+
+            Job* pop() noexcept;
+
+            Job* steal() noexcept;
+        };
+
+#pragma mark - mgo::jobs::Scheduler
+        class Scheduler final
+        {
+        public:
+            using RangeFunction = std::function<void(std::size_t first, std::size_t last)>;
+
+            static const std::size_t BATCHES_PER_THREAD = 4;
+
+        private:
+            std::vector<std::unique_ptr<WorkStealingDeque>> deques_;
+            std::vector<std::thread> workers_;
+            std::deque<Job*> injectedJobs_;
+            std::mutex injectedMutex_;
+            std::atomic<std::size_t> injectedJobCount_;
+            std::atomic<std::size_t> queuedJobCount_;
+            std::atomic<std::uint32_t> sleepingWorkerCount_;
+            std::mutex sleepMutex_;
+            std::condition_variable sleepCondition_;
+            std::atomic<bool> stopping_;
+            const std::uint32_t workerCount_;
+
+            Scheduler();
+
+        public:
+            ~Scheduler() noexcept;
+
+            Scheduler(const Scheduler&) = delete;
+
+            Scheduler& operator=(const Scheduler&) = delete;
+
+            static Scheduler& get() noexcept;
+
+            void run(std::function<void()> function, Counter* pCounter = nullptr);
+
+            void runAfter(Counter& dependency, std::function<void()> function, Counter* pCounter = nullptr);
+
+            void wait(Counter& counter);
+
+            void parallelFor(std::size_t count, std::size_t minBatchSize, const RangeFunction& function);
+
+            std::uint32_t getWorkerCount() const noexcept;
+
+            std::uint32_t getThreadCount() const noexcept;
+
+        private:
+            void work(std::uint32_t workerIndex) noexcept;
+
+            void submit(const std::vector<Job*>& jobs);
+
+            Job* findJob() noexcept;
+
+            void execute(Job* pJob) noexcept;
+
+            void complete(Counter* pCounter) noexcept;
+        };
+    }
+}
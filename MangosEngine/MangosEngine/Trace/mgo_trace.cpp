@@ -0,0 +1,302 @@
+#include "mgo_trace.hpp"
+#include <iomanip>
+namespace mgo
+{
+    namespace trace
+    {
+#pragma mark - mgo::trace::ThreadBuffer
+        ThreadBuffer::ThreadBuffer(std::uint32_t threadID)
+        :
+        head_(0),
+        streamed_(0),
+        threadName_("Thread " + std::to_string(threadID)),
+        threadID_(threadID)
+        {
+        }
+        
+        void ThreadBuffer::push(const char* name, std::uint64_t beginNanoseconds, std::uint64_t endNanoseconds) noexcept
+        {
+            std::uint64_t index = this->head_.load(std::memory_order_relaxed);
+            Slot& slot = this->slots_[index % CAPACITY];
+            
+            // An odd sequence marks the slot as being written, readers discard it until it turns even again.
+            slot.sequence_.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.name_.store(name, std::memory_order_relaxed);
+            slot.beginNanoseconds_.store(beginNanoseconds, std::memory_order_relaxed);
+            slot.endNanoseconds_.store(endNanoseconds, std::memory_order_relaxed);
+            slot.sequence_.store(2 * index + 2, std::memory_order_release);
+            
+            this->head_.store(index + 1, std::memory_order_release);
+        }
+        
+        std::vector<ThreadBuffer::Event> ThreadBuffer::read(std::uint64_t first, std::uint64_t* pHead) const
+        {
+            std::uint64_t head = this->head_.load(std::memory_order_acquire);
+            first = std::max(first, head > CAPACITY ? head - CAPACITY : 0);
+            
+            std::vector<Event> events;
+            events.reserve(static_cast<std::size_t>(head - first));
+            for (std::uint64_t index = first; index < head; index++)
+            {
+                const Slot& slot = this->slots_[index % CAPACITY];
+                
+                std::uint64_t sequence = slot.sequence_.load(std::memory_order_acquire);
+                Event event{};
+                event.name_             = slot.name_.load(std::memory_order_relaxed);
+                event.beginNanoseconds_ = slot.beginNanoseconds_.load(std::memory_order_relaxed);
+                event.endNanoseconds_   = slot.endNanoseconds_.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                
+                if (sequence == 2 * index + 2 && slot.sequence_.load(std::memory_order_relaxed) == sequence)
+                    events.push_back(event);
+            }
+            
+            *pHead = head;
+            return events;
+        }
+        
+        std::vector<ThreadBuffer::Event> ThreadBuffer::readRecent() const
+        {
+            std::uint64_t head = 0;
+            return this->read(0, &head);
+        }
+        
+        std::vector<ThreadBuffer::Event> ThreadBuffer::readUnstreamed()
+        {
+            std::uint64_t head = 0;
+            std::vector<Event> events = this->read(this->streamed_, &head);
+            this->streamed_ = head;
+            return events;
+        }
+        
+        void ThreadBuffer::setThreadName(const std::string& threadName)
+        {
+            this->threadName_ = threadName;
+        }
+        
+        const std::string& ThreadBuffer::getThreadName() const noexcept
+        {
+            return this->threadName_;
+        }
+        
+        std::uint32_t ThreadBuffer::getThreadID() const noexcept
+        {
+            return this->threadID_;
+        }
+        
+#pragma mark - mgo::trace::Tracer
+        Tracer::Tracer()
+        :
+        streaming_(false),
+        firstStreamedEvent_(true),
+        enabled_(false),
+        epoch_(std::chrono::steady_clock::now())
+        {
+        }
+        
+        Tracer::~Tracer() noexcept
+        {
+            this->stopStreaming();
+        }
+        
+        Tracer& Tracer::get() noexcept
+        {
+            static Tracer tracer;
+            return tracer;
+        }
+        
+        void Tracer::setEnabled(bool enabled) noexcept
+        {
+            this->enabled_.store(enabled, std::memory_order_relaxed);
+        }
+        
+        bool Tracer::isEnabled() const noexcept
+        {
+            return this->enabled_.load(std::memory_order_relaxed);
+        }
+        
+        std::uint64_t Tracer::now() const noexcept
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->epoch_).count());
+        }
+        
+        void Tracer::record(const char* name, std::uint64_t beginNanoseconds, std::uint64_t endNanoseconds) noexcept
+        {
+            if (!this->isEnabled())
+                return;
+            
+            try
+            {
+                this->getThreadBuffer().push(name, beginNanoseconds, endNanoseconds);
+            }
+            catch (...)
+            {
+            }
+        }
+        
+        void Tracer::setThreadName(const std::string& threadName) noexcept
+        {
+            try
+            {
+                ThreadBuffer& threadBuffer = this->getThreadBuffer();
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                threadBuffer.setThreadName(threadName);
+            }
+            catch (...)
+            {
+            }
+        }
+        
+        void Tracer::writeChromeTrace(const std::filesystem::path& path)
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            
+            std::ofstream file(path, std::ios::trunc);
+            if (!file)
+                throw std::runtime_error("Failed to open trace file " + path.string() + "!");
+            
+            // Every thread's ring holds its most recent CAPACITY events, older ones have been overwritten.
+            file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+            bool firstEvent = true;
+            for (const auto& threadBuffer : this->threadBuffers_)
+            {
+                file << (firstEvent ? "" : ",\n");
+                this->writeThreadName(file, *threadBuffer);
+                firstEvent = false;
+                
+                for (const ThreadBuffer::Event& event : threadBuffer->readRecent())
+                {
+                    file << ",\n";
+                    this->writeEvent(file, event, threadBuffer->getThreadID());
+                }
+            }
+            file << "\n]}\n";
+            
+            if (!file)
+                throw std::runtime_error("Failed to write trace file " + path.string() + "!");
+        }
+        
+        void Tracer::startStreaming(const std::filesystem::path& path)
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            if (this->streaming_)
+                throw std::runtime_error("mgo::trace::Tracer is already streaming!");
+            
+            this->stream_.open(path, std::ios::trunc);
+            if (!this->stream_)
+                throw std::runtime_error("Failed to open trace file " + path.string() + "!");
+            
+            // The JSON array format lets Chrome and Perfetto load the file even if the process dies before closing it.
+            this->stream_ << "[\n";
+            this->firstStreamedEvent_ = true;
+            for (const auto& threadBuffer : this->threadBuffers_)
+                threadBuffer->readUnstreamed();
+            
+            this->streaming_ = true;
+            this->setEnabled(true);
+            this->streamThread_ = std::thread(&Tracer::stream, this);
+        }
+        
+        void Tracer::stopStreaming() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                if (!this->streaming_)
+                    return;
+                this->streaming_ = false;
+            }
+            this->streamCondition_.notify_all();
+            this->streamThread_.join();
+            
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            try
+            {
+                this->streamEvents();
+                for (const auto& threadBuffer : this->threadBuffers_)
+                {
+                    this->stream_ << (this->firstStreamedEvent_ ? "" : ",\n");
+                    this->writeThreadName(this->stream_, *threadBuffer);
+                    this->firstStreamedEvent_ = false;
+                }
+                this->stream_ << "\n]\n";
+            }
+            catch (const std::exception& errorMessage)
+            {
+                MGO_LOG_ERROR(errorMessage.what());
+            }
+            this->stream_.close();
+        }
+        
+        ThreadBuffer& Tracer::getThreadBuffer()
+        {
+            thread_local ThreadBuffer* pThreadBuffer = nullptr;
+            if (pThreadBuffer == nullptr)
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->threadBuffers_.emplace_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(this->threadBuffers_.size() + 1)));
+                pThreadBuffer = this->threadBuffers_.back().get();
+            }
+            return *pThreadBuffer;
+        }
+        
+        void Tracer::stream() noexcept
+        {
+            std::unique_lock<std::mutex> lock(this->mutex_);
+            while (this->streaming_)
+            {
+                this->streamCondition_.wait_for(lock, STREAM_INTERVAL, [this]() { return !this->streaming_; });
+                try
+                {
+                    this->streamEvents();
+                }
+                catch (const std::exception& errorMessage)
+                {
+                    MGO_LOG_ERROR(errorMessage.what());
+                }
+            }
+        }
+        
+        void Tracer::streamEvents()
+        {
+            for (const auto& threadBuffer : this->threadBuffers_)
+                for (const ThreadBuffer::Event& event : threadBuffer->readUnstreamed())
+                {
+                    this->stream_ << (this->firstStreamedEvent_ ? "" : ",\n");
+                    this->writeEvent(this->stream_, event, threadBuffer->getThreadID());
+                    this->firstStreamedEvent_ = false;
+                }
+            this->stream_.flush();
+        }
+        
+        void Tracer::writeEvent(std::ostream& stream, const ThreadBuffer::Event& event, std::uint32_t threadID)
+        {
+            std::uint64_t durationNanoseconds = event.endNanoseconds_ - event.beginNanoseconds_;
+            stream << "{\"name\":\"" << event.name_ << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadID
+                   << ",\"ts\":" << event.beginNanoseconds_ / 1000 << '.' << std::setw(3) << std::setfill('0') << event.beginNanoseconds_ % 1000
+                   << ",\"dur\":" << durationNanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << durationNanoseconds % 1000 << '}';
+        }
+        
+        void Tracer::writeThreadName(std::ostream& stream, const ThreadBuffer& threadBuffer)
+        {
+            stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadBuffer.getThreadID() << ",\"args\":{\"name\":\"";
+            for (char character : threadBuffer.getThreadName())
+                stream << (character == '"' || character == '\\' ? "\\" : "") << character;
+            stream << "\"}}";
+        }
+        
+#pragma mark - mgo::trace::Scope
+        Scope::Scope(const char* name) noexcept
+        :
+        name_(Tracer::get().isEnabled() ? name : nullptr),
+        beginNanoseconds_(this->name_ != nullptr ? Tracer::get().now() : 0)
+        {
+        }
+        
+        Scope::~Scope() noexcept
+        {
+            if (this->name_ != nullptr)
+                Tracer::get().record(this->name_, this->beginNanoseconds_, Tracer::get().now());
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+namespace mgo
+{
+    namespace trace
+    {
+#pragma mark - mgo::trace::ThreadBuffer
+        class ThreadBuffer final
+        {
+        public:
+            static const std::size_t CAPACITY = 4096;
+            
+            struct Event
+            {
+                const char* name_;
+                std::uint64_t beginNanoseconds_;
+                std::uint64_t endNanoseconds_;
+            };
+            
+        private:
+            // Every slot is a seqlock so the owning thread never waits on a reader.
+            struct Slot
+            {
+                std::atomic<std::uint64_t> sequence_;
+                std::atomic<const char*> name_;
+                std::atomic<std::uint64_t> beginNanoseconds_;
+                std::atomic<std::uint64_t> endNanoseconds_;
+            };
+            
+            std::array<Slot, CAPACITY> slots_;
+            std::atomic<std::uint64_t> head_;
+            std::uint64_t streamed_;
+            std::string threadName_;
+            const std::uint32_t threadID_;
+            
+        public:
+            explicit ThreadBuffer(std::uint32_t threadID);
+            
+            void push(const char* name, std::uint64_t beginNanoseconds, std::uint64_t endNanoseconds) noexcept;
+            
+            std::vector<Event> read(std::uint64_t first, std::uint64_t* pHead) const;
+            
+            std::vector<Event> readRecent() const;
+            
+            std::vector<Event> readUnstreamed();
+            
+            void setThreadName(const std::string& threadName);
+            
+            const std::string& getThreadName() const noexcept;
+            
+            std::uint32_t getThreadID() const noexcept;
+        };
+        
+#pragma mark - mgo::trace::Tracer
+        class Tracer final
+        {
+        public:
+            static constexpr std::chrono::milliseconds STREAM_INTERVAL = std::chrono::milliseconds(100);
+            
+        private:
+            std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers_;
+            std::mutex mutex_;
+            std::ofstream stream_;
+            std::thread streamThread_;
+            std::condition_variable streamCondition_;
+            bool streaming_;
+            bool firstStreamedEvent_;
+            std::atomic<bool> enabled_;
+            const std::chrono::steady_clock::time_point epoch_;
+            
+            Tracer();
+            
+        public:
+            ~Tracer() noexcept;
+            
+            Tracer(const Tracer&) = delete;
+            
+            Tracer& operator=(const Tracer&) = delete;
+            
+            static Tracer& get() noexcept;
+            
+            void setEnabled(bool enabled) noexcept;
+            
+            bool isEnabled() const noexcept;
+            
+            std::uint64_t now() const noexcept;
+            
+            void record(const char* name, std::uint64_t beginNanoseconds, std::uint64_t endNanoseconds) noexcept;
+            
+            void setThreadName(const std::string& threadName) noexcept;
+            
+            void writeChromeTrace(const std::filesystem::path& path);
+            
+            void startStreaming(const std::filesystem::path& path);
+            
+            void stopStreaming() noexcept;
+            
+        private:
+            ThreadBuffer& getThreadBuffer();
+            
+            void stream() noexcept;
+            
+            void streamEvents();
+            
+            static void writeEvent(std::ostream& stream, const ThreadBuffer::Event& event, std::uint32_t threadID);
+            
+            static void writeThreadName(std::ostream& stream, const ThreadBuffer& threadBuffer);
+        };
+        
+#pragma mark - mgo::trace::Scope
+        class Scope final
+        {
+        private:
+            const char* name_;
+            std::uint64_t beginNanoseconds_;
+            
+        public:
+            // The name must outlive the trace, in practice a string literal.
+            explicit Scope(const char* name) noexcept;
+            
+            ~Scope() noexcept;
+            
+            Scope(const Scope&) = delete;
+            
+            Scope& operator=(const Scope&) = delete;
+        };
+    }
+}
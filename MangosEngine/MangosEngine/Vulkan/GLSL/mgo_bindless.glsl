@@ -0,0 +1,14 @@
+// Matches mgo::vk::BindlessDescriptors and the push constant range of mgo::vk::PipelineLayout.
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) uniform texture2D mgoSampledImages[];
+layout(set = 0, binding = 1) uniform sampler mgoSamplers[];
+layout(set = 0, binding = 2) readonly buffer MgoStorageBuffer
+{
+    uint data[];
+} mgoStorageBuffers[];
+
+layout(push_constant) uniform MgoPushConstants
+{
+    uvec4 resourceIndices;
+} mgoPushConstants;
@@ -0,0 +1,10 @@
+// Matches mgo::vk::FrameAllocator, whose slices are bound with the draw's dynamic offsets.
+layout(set = 1, binding = 0) uniform MgoFrame
+{
+    mat4 viewProjection;
+} mgoFrame;
+
+layout(set = 1, binding = 1) readonly buffer MgoFrameStorage
+{
+    uint data[];
+} mgoFrameStorage;
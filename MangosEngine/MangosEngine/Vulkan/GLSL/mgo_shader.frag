@@ -1,10 +1,18 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+#include "mgo_bindless.glsl"
 
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) flat in uint fragMaterialIndex;
+layout(location = 2) in vec2 fragTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
 void main()
 {
     outColor = vec4(fragColor, 1.0);
+    // The material index names the slot of both the image and its sampler; UINT32_MAX draws untextured.
+    if (fragMaterialIndex != 0xFFFFFFFFu)
+        outColor *= texture(sampler2D(mgoSampledImages[nonuniformEXT(fragMaterialIndex)],
+                                      mgoSamplers[nonuniformEXT(fragMaterialIndex)]), fragTexCoord);
 }
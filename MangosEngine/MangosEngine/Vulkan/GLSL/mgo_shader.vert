@@ -1,23 +1,24 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+#include "mgo_bindless.glsl"
+#include "mgo_frame.glsl"
 
-layout(location = 0) out vec3 fragColor;
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
 
-vec2 positions[3] =
-{
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-};
+// Instance-rate stream, matches mgo::vk::InstanceData.
+layout(location = 2) in mat4 inTransform;
+layout(location = 6) in vec4 inInstanceColor;
+layout(location = 7) in uint inMaterialIndex;
 
-vec3 colors[3] =
-{
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-};
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) flat out uint fragMaterialIndex;
+layout(location = 2) out vec2 fragTexCoord;
 
 void main()
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    gl_Position = mgoFrame.viewProjection * inTransform * vec4(inPosition, 0.0, 1.0);
+    fragColor = inColor * inInstanceColor.rgb;
+    fragMaterialIndex = inMaterialIndex;
+    fragTexCoord = inPosition + 0.5;
 }
@@ -1,4 +1,8 @@
 #include "mgo_vulkan.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 namespace mgo
 {
     namespace vk
@@ -13,6 +17,17 @@ namespace mgo
 #define MGO_VK_ENABLED_LAYERS_NAME nullptr
 #endif
         
+#pragma mark - mgo::vk::hashBytes
+        std::uint64_t hashBytes(const void* pData, std::size_t size) noexcept
+        {
+            // 64-bit FNV-1a.
+            const std::uint8_t* pBytes = static_cast<const std::uint8_t*>(pData);
+            std::uint64_t value = 0xCBF29CE484222325ull;
+            for (std::size_t i = 0; i < size; i++)
+                value = (value ^ pBytes[i]) * 0x100000001B3ull;
+            return value;
+        }
+        
 #pragma mark - mgo::vk::Instance
         Instance::Instance(const std::string& engineName, const std::string& applicationName, const glfw::Window& window)
         :
@@ -32,13 +47,14 @@ namespace mgo
 #else
 #define MGO_VK_INSTANCE_NEXT nullptr
 #endif
-            //VkApplicationInfo applicationInfo = this->getVkApplicationInfo();
+            // Timeline semaphores and descriptor indexing are core from Vulkan 1.2, which the application info requests.
+            VkApplicationInfo applicationInfo = this->getVkApplicationInfo();
             
             VkInstanceCreateInfo instanceCreateInfo{};
             instanceCreateInfo.sType                    = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
             instanceCreateInfo.flags                    = MGO_VK_INSTANCE_FLAGS;
             instanceCreateInfo.pNext                    = MGO_VK_INSTANCE_NEXT;
-            instanceCreateInfo.pApplicationInfo         = nullptr;
+            instanceCreateInfo.pApplicationInfo         = &applicationInfo;
             instanceCreateInfo.enabledLayerCount        = MGO_VK_ENABLED_LAYERS_COUNT;
             instanceCreateInfo.ppEnabledLayerNames      = MGO_VK_ENABLED_LAYERS_NAME;
             instanceCreateInfo.enabledExtensionCount    = static_cast<std::uint32_t>(this->extensions_.size());
@@ -104,7 +120,7 @@ namespace mgo
             applicationInfo.applicationVersion  = VK_MAKE_VERSION(1, 0, 0);
             applicationInfo.pEngineName         = this->engineName_.c_str();
             applicationInfo.engineVersion       = VK_MAKE_VERSION(1, 0, 0);
-            applicationInfo.apiVersion          = VK_API_VERSION_1_3;
+            applicationInfo.apiVersion          = VK_API_VERSION_1_2;
             return applicationInfo;
         }
         
@@ -192,19 +208,76 @@ namespace mgo
             if (func != nullptr)
                 func(instance, debugMessenger, pAllocator);
         }
+#pragma mark - mgo::vk::PresentPolicy
+        PresentPolicy::PresentPolicy(Mode mode)
+        {
+            switch (mode)
+            {
+                case (Mode::UNCAPPED)       : {this->preferences_ = {Mode::UNCAPPED, Mode::MAILBOX}; break;}
+                case (Mode::RELAXED_VSYNC)  : {this->preferences_ = {Mode::RELAXED_VSYNC}; break;}
+                case (Mode::MAILBOX)        : {this->preferences_ = {Mode::MAILBOX}; break;}
+                default                     : {this->preferences_ = {Mode::VSYNC}; break;}
+            };
+        }
+        
+        PresentPolicy::PresentPolicy(const std::vector<Mode>& preferences)
+        :
+        preferences_(preferences)
+        {}
+        
+        const std::vector<PresentPolicy::Mode>& PresentPolicy::getPreferences() const noexcept
+        {
+            return this->preferences_;
+        }
+        
+        VkPresentModeKHR PresentPolicy::select(const std::vector<VkPresentModeKHR>& availablePresentModes) const noexcept
+        {
+            for (Mode preference : this->preferences_)
+                if (std::find(availablePresentModes.begin(),
+                              availablePresentModes.end(),
+                              getVkPresentModeKHR(preference)) != availablePresentModes.end())
+                    return getVkPresentModeKHR(preference);
+            
+            // FIFO is the only present mode every surface is required to support.
+            return VK_PRESENT_MODE_FIFO_KHR;
+        }
+        
+        bool PresentPolicy::operator==(const PresentPolicy& other) const noexcept
+        {
+            return this->preferences_ == other.preferences_;
+        }
+        
+        VkPresentModeKHR PresentPolicy::getVkPresentModeKHR(Mode mode) noexcept
+        {
+            switch (mode)
+            {
+                case (Mode::UNCAPPED)       : return VK_PRESENT_MODE_IMMEDIATE_KHR;
+                case (Mode::RELAXED_VSYNC)  : return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+                case (Mode::MAILBOX)        : return VK_PRESENT_MODE_MAILBOX_KHR;
+                default                     : return VK_PRESENT_MODE_FIFO_KHR;
+            };
+        }
+        
 #pragma mark - mgo::vk::Surface
         Surface::Surface(const Instance& instance, const glfw::Window& window)
         :
         instance_(instance),
         window_(window)
         {
+            if (this->window_.isHeadless())
+            {
+                this->surface_ = VK_NULL_HANDLE;
+                return;
+            }
+            
             if (this->window_.createSurface(this->instance_.get(), &this->surface_) != VK_SUCCESS)
                 throw std::runtime_error("Failed to create mgo::vk::Surface");
         }
         
         Surface::~Surface() noexcept
         {
-            vkDestroySurfaceKHR(this->instance_.get(), this->surface_, nullptr);
+            if (!this->isHeadless())
+                vkDestroySurfaceKHR(this->instance_.get(), this->surface_, nullptr);
         }
         
         const VkSurfaceKHR& Surface::get() const noexcept
@@ -214,13 +287,30 @@ namespace mgo
         
         VkSurfaceCapabilitiesKHR Surface::getVkSurfaceCapabilitiesKHR(const PhysicalDevice& physicalDevice) const noexcept
         {
-            VkSurfaceCapabilitiesKHR surfaceCapabilities;
+            VkSurfaceCapabilitiesKHR surfaceCapabilities{};
+            if (this->isHeadless())
+            {
+                surfaceCapabilities.minImageCount           = 1;
+                surfaceCapabilities.maxImageCount           = 0;
+                surfaceCapabilities.currentExtent           = this->window_.GetFramebufferSize();
+                surfaceCapabilities.minImageExtent          = {1, 1};
+                surfaceCapabilities.maxImageExtent          = this->window_.GetFramebufferSize();
+                surfaceCapabilities.maxImageArrayLayers     = 1;
+                surfaceCapabilities.supportedTransforms     = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+                surfaceCapabilities.currentTransform        = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+                surfaceCapabilities.supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+                surfaceCapabilities.supportedUsageFlags     = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                return surfaceCapabilities;
+            }
             vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice.get(), this->surface_, &surfaceCapabilities);
             return surfaceCapabilities;
         }
         
         VkSurfaceFormatKHR Surface::getVkSurfaceFormatKHR(const PhysicalDevice& physicalDevice) const noexcept
         {
+            if (this->isHeadless())
+                return {VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+            
             std::uint32_t formatCount;
             vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice.get(), this->surface_, &formatCount, nullptr);
             
@@ -234,18 +324,18 @@ namespace mgo
             return surfaceFormats[0];
         }
         
-        VkPresentModeKHR Surface::getVkPresentModeKHR(const PhysicalDevice& physicalDevice) const noexcept
+        VkPresentModeKHR Surface::getVkPresentModeKHR(const PhysicalDevice& physicalDevice, const PresentPolicy& presentPolicy) const noexcept
         {
+            if (this->isHeadless())
+                return VK_PRESENT_MODE_FIFO_KHR;
+            
             std::uint32_t presentModeCount;
             vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice.get(), this->surface_, &presentModeCount, nullptr);
             
             std::vector<VkPresentModeKHR> presentModes(static_cast<std::size_t>(presentModeCount));
             vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice.get(), this->surface_, &presentModeCount, presentModes.data());
             
-            for (const auto& availablePresentMode : presentModes)
-                if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-                    return availablePresentMode;
-            return VK_PRESENT_MODE_FIFO_KHR;
+            return presentPolicy.select(presentModes);
         }
         
         VkExtent2D Surface::getVkExtent2D(const PhysicalDevice& physicalDevice) const noexcept
@@ -260,9 +350,15 @@ namespace mgo
                            surfaceCapabilities.maxImageExtent.height)};
         }
         
+        bool Surface::isHeadless() const noexcept
+        {
+            return this->surface_ == VK_NULL_HANDLE;
+        }
+        
 #pragma mark - mgo::vk::PhysicalDevice
-        PhysicalDevice::PhysicalDevice(const Instance& instance, const Surface& surface)
+        PhysicalDevice::PhysicalDevice(const Instance& instance, const Surface& surface, bool allowCpuDevice)
         :
+        allowCpuDevice_(allowCpuDevice),
         instance_(instance),
         surface_(surface),
         extensions_(this->getExtensions())
@@ -299,7 +395,8 @@ namespace mgo
         std::vector<const char*> PhysicalDevice::getExtensions() const noexcept
         {
             std::vector<const char*> extensions;
-            extensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+            if (!this->surface_.isHeadless())
+                extensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 #ifdef __APPLE__
             extensions.emplace_back(VK_NV_GLSL_SHADER_EXTENSION_NAME);
             extensions.emplace_back("VK_KHR_portability_subset");
@@ -307,6 +404,29 @@ namespace mgo
             return extensions;
         }
         
+        std::vector<const char*> PhysicalDevice::getOptionalExtensions() const noexcept
+        {
+            std::vector<const char*> extensions;
+            for (const char* optionalExtension : {VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME})
+                if (this->isExtensionSupported(optionalExtension))
+                    extensions.emplace_back(optionalExtension);
+            return extensions;
+        }
+        
+        bool PhysicalDevice::isExtensionSupported(const char* extension) const noexcept
+        {
+            std::uint32_t propertyCount = 0;
+            vkEnumerateDeviceExtensionProperties(this->physicalDevice_, nullptr, &propertyCount, nullptr);
+            
+            std::vector<VkExtensionProperties> properties(propertyCount);
+            vkEnumerateDeviceExtensionProperties(this->physicalDevice_, nullptr, &propertyCount, properties.data());
+            
+            for (const auto& supportedProperty : properties)
+                if (std::strcmp(extension, supportedProperty.extensionName) == 0)
+                    return true;
+            return false;
+        }
+        
         PhysicalDevice::QueueFamilyIndices PhysicalDevice::getQueueFamilyIndices() const noexcept
         {
             return this->queueFamilyIndices_;
@@ -317,12 +437,27 @@ namespace mgo
             UniqueQueueFamilyIndices uniqueQueueFamilyIndices{};
             uniqueQueueFamilyIndices.families_.emplace(this->queueFamilyIndices_.graphicsFamily_.value());
             uniqueQueueFamilyIndices.families_.emplace(this->queueFamilyIndices_.presentFamily_.value());
+            uniqueQueueFamilyIndices.families_.emplace(this->queueFamilyIndices_.transferFamily_.value());
+            uniqueQueueFamilyIndices.families_.emplace(this->queueFamilyIndices_.computeFamily_.value());
             uniqueQueueFamilyIndices.priority_ = this->queueFamilyIndices_.priority_;
             return uniqueQueueFamilyIndices;
         }
         
+        std::uint32_t PhysicalDevice::getQueueFamilyIndex(QueueType queueType) const noexcept
+        {
+            switch (queueType)
+            {
+                case (QueueType::TRANSFER)  : return this->queueFamilyIndices_.transferFamily_.value();
+                case (QueueType::COMPUTE)   : return this->queueFamilyIndices_.computeFamily_.value();
+                default                     : return this->queueFamilyIndices_.graphicsFamily_.value();
+            };
+        }
+        
         VkPhysicalDeviceFeatures PhysicalDevice::getPhysicalDeviceFeatures() const noexcept
         {
+            VkPhysicalDeviceFeatures supportedFeatures;
+            vkGetPhysicalDeviceFeatures(this->physicalDevice_, &supportedFeatures);
+            
             VkPhysicalDeviceFeatures physicalDeviceFeatures{};
             physicalDeviceFeatures.robustBufferAccess                       = 0;
             physicalDeviceFeatures.fullDrawIndexUint32                      = 0;
@@ -333,8 +468,8 @@ namespace mgo
             physicalDeviceFeatures.sampleRateShading                        = 0;
             physicalDeviceFeatures.dualSrcBlend                             = 0;
             physicalDeviceFeatures.logicOp                                  = 0;
-            physicalDeviceFeatures.multiDrawIndirect                        = 0;
-            physicalDeviceFeatures.drawIndirectFirstInstance                = 0;
+            physicalDeviceFeatures.multiDrawIndirect                        = supportedFeatures.multiDrawIndirect;
+            physicalDeviceFeatures.drawIndirectFirstInstance                = supportedFeatures.drawIndirectFirstInstance;
             physicalDeviceFeatures.depthClamp                               = 0;
             physicalDeviceFeatures.depthBiasClamp                           = 0;
             physicalDeviceFeatures.fillModeNonSolid                         = 0;
@@ -348,7 +483,7 @@ namespace mgo
             physicalDeviceFeatures.textureCompressionASTC_LDR               = 0;
             physicalDeviceFeatures.textureCompressionBC                     = 0;
             physicalDeviceFeatures.occlusionQueryPrecise                    = 0;
-            physicalDeviceFeatures.pipelineStatisticsQuery                  = 0;
+            physicalDeviceFeatures.pipelineStatisticsQuery                  = supportedFeatures.pipelineStatisticsQuery;
             physicalDeviceFeatures.vertexPipelineStoresAndAtomics           = 0;
             physicalDeviceFeatures.fragmentStoresAndAtomics                 = 0;
             physicalDeviceFeatures.shaderTessellationAndGeometryPointSize   = 0;
@@ -378,10 +513,80 @@ namespace mgo
             physicalDeviceFeatures.sparseResidency16Samples                 = 0;
             physicalDeviceFeatures.sparseResidencyAliased                   = 0;
             physicalDeviceFeatures.variableMultisampleRate                  = 0;
-            physicalDeviceFeatures.inheritedQueries                         = 0;
+            physicalDeviceFeatures.inheritedQueries                         = supportedFeatures.inheritedQueries;
             return physicalDeviceFeatures;
         }
         
+        VkPhysicalDeviceTimelineSemaphoreFeatures PhysicalDevice::getTimelineSemaphoreFeatures() const noexcept
+        {
+            VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+            timelineSemaphoreFeatures.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+            timelineSemaphoreFeatures.pNext             = nullptr;
+            
+            VkPhysicalDeviceFeatures2 physicalDeviceFeatures2{};
+            physicalDeviceFeatures2.sType               = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            physicalDeviceFeatures2.pNext               = &timelineSemaphoreFeatures;
+            vkGetPhysicalDeviceFeatures2(this->physicalDevice_, &physicalDeviceFeatures2);
+            
+            timelineSemaphoreFeatures.pNext             = nullptr;
+            return timelineSemaphoreFeatures;
+        }
+        
+        VkPhysicalDeviceDescriptorIndexingFeatures PhysicalDevice::getDescriptorIndexingFeatures() const noexcept
+        {
+            VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
+            descriptorIndexingFeatures.sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+            descriptorIndexingFeatures.pNext            = nullptr;
+            
+            VkPhysicalDeviceFeatures2 physicalDeviceFeatures2{};
+            physicalDeviceFeatures2.sType               = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            physicalDeviceFeatures2.pNext               = &descriptorIndexingFeatures;
+            vkGetPhysicalDeviceFeatures2(this->physicalDevice_, &physicalDeviceFeatures2);
+            
+            descriptorIndexingFeatures.pNext            = nullptr;
+            return descriptorIndexingFeatures;
+        }
+        
+        std::uint32_t PhysicalDevice::findMemoryTypeIndex(std::uint32_t memoryTypeBits, VkMemoryPropertyFlags memoryPropertyFlags) const
+        {
+            VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties = this->getPhysicalDeviceMemoryProperties();
+            
+            for (std::uint32_t memoryTypeIndex = 0; memoryTypeIndex < physicalDeviceMemoryProperties.memoryTypeCount; memoryTypeIndex++)
+                if ((memoryTypeBits & (1u << memoryTypeIndex)) &&
+                    (physicalDeviceMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & memoryPropertyFlags) == memoryPropertyFlags)
+                    return memoryTypeIndex;
+            throw std::runtime_error("Failed to find a suitable memory type!");
+        }
+        
+        VkPhysicalDeviceProperties PhysicalDevice::getPhysicalDeviceProperties() const noexcept
+        {
+            VkPhysicalDeviceProperties physicalDeviceProperties;
+            vkGetPhysicalDeviceProperties(this->physicalDevice_, &physicalDeviceProperties);
+            return physicalDeviceProperties;
+        }
+        
+        VkPhysicalDeviceDescriptorIndexingProperties PhysicalDevice::getDescriptorIndexingProperties() const noexcept
+        {
+            VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{};
+            descriptorIndexingProperties.sType          = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+            descriptorIndexingProperties.pNext          = nullptr;
+            
+            VkPhysicalDeviceProperties2 physicalDeviceProperties2{};
+            physicalDeviceProperties2.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            physicalDeviceProperties2.pNext             = &descriptorIndexingProperties;
+            vkGetPhysicalDeviceProperties2(this->physicalDevice_, &physicalDeviceProperties2);
+            
+            descriptorIndexingProperties.pNext          = nullptr;
+            return descriptorIndexingProperties;
+        }
+        
+        VkPhysicalDeviceMemoryProperties PhysicalDevice::getPhysicalDeviceMemoryProperties() const noexcept
+        {
+            VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
+            vkGetPhysicalDeviceMemoryProperties(this->physicalDevice_, &physicalDeviceMemoryProperties);
+            return physicalDeviceMemoryProperties;
+        }
+        
         std::uint8_t PhysicalDevice::rankPhysicalDevices(VkPhysicalDevice physicalDevice) const noexcept
         {
             std::uint8_t value = 0;
@@ -392,22 +597,32 @@ namespace mgo
             VkPhysicalDeviceFeatures phyicalDevicesFeatures;
             vkGetPhysicalDeviceFeatures(physicalDevice, &phyicalDevicesFeatures);
             
-            std::uint32_t formatCount;
-            vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, this->surface_.get(), &formatCount, nullptr);
-            
-            std::uint32_t presentModeCount;
-            vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, this->surface_.get(), &presentModeCount, nullptr);
+            std::uint32_t formatCount = 0;
+            std::uint32_t presentModeCount = 0;
+            if (!this->surface_.isHeadless())
+            {
+                vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, this->surface_.get(), &formatCount, nullptr);
+                vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, this->surface_.get(), &presentModeCount, nullptr);
+            }
             
             QueueFamilyIndices queueFamilyindices = findQueueFamilyIndices(physicalDevice, this->surface_.get(), 1.0f);
             
             switch (phyicalDevicesProperties.deviceType)
             {
-                case (VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU)   : {value = 2; break;}
-                case (VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)     : {value = 1; break;}
+                case (VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU)   : {value = 3; break;}
+                case (VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)     : {value = 2; break;}
+                case (VK_PHYSICAL_DEVICE_TYPE_CPU)              : {value = this->allowCpuDevice_ ? 1 : 0; break;}
                 default : return 0;
             };
             
-            if (presentModeCount == 0 || formatCount == 0)
+            if (value == 0)
+                return 0;
+            
+            // The engine calls core 1.2 entry points, so older devices cannot be used even if the instance is newer.
+            if (phyicalDevicesProperties.apiVersion < VK_API_VERSION_1_2)
+                return 0;
+            
+            if (!this->surface_.isHeadless() && (presentModeCount == 0 || formatCount == 0))
                 return 0;
             
             if (!queueFamilyindices.graphicsFamily_.has_value() || !queueFamilyindices.presentFamily_.has_value())
@@ -416,9 +631,41 @@ namespace mgo
             if (!this->checkPhysicalDeviceExtensionSupport(physicalDevice, false))
                 return 0;
             
+            if (!this->checkPhysicalDeviceFeatureSupport(physicalDevice))
+                return 0;
+            
             return value;
         }
         
+        bool PhysicalDevice::checkPhysicalDeviceFeatureSupport(VkPhysicalDevice physicalDevice) const noexcept
+        {
+            VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
+            descriptorIndexingFeatures.sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+            descriptorIndexingFeatures.pNext    = nullptr;
+            
+            VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+            timelineSemaphoreFeatures.sType     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+            timelineSemaphoreFeatures.pNext     = &descriptorIndexingFeatures;
+            
+            VkPhysicalDeviceFeatures2 physicalDeviceFeatures2{};
+            physicalDeviceFeatures2.sType       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            physicalDeviceFeatures2.pNext       = &timelineSemaphoreFeatures;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &physicalDeviceFeatures2);
+            
+            // Frame synchronisation is built on timeline semaphores.
+            if (!timelineSemaphoreFeatures.timelineSemaphore)
+                return false;
+            
+            // BindlessDescriptors updates partially bound, runtime-sized arrays while frames are in flight.
+            return descriptorIndexingFeatures.runtimeDescriptorArray &&
+                   descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+                   descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+                   descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+                   descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+                   descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+                   descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing;
+        }
+        
         bool PhysicalDevice::checkPhysicalDeviceExtensionSupport(VkPhysicalDevice physicalDevice, bool logResults) const noexcept
         {
             std::uint32_t propertyCound = 0;
@@ -461,16 +708,40 @@ namespace mgo
             for (const auto& queueFamilyProperty : queueFamilyProperties)
             {
                 VkBool32 presentSupport = VK_FALSE;
-                vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamilyIndex, surface, &presentSupport);
+                if (surface != VK_NULL_HANDLE)
+                    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamilyIndex, surface, &presentSupport);
                 
                 if (queueFamilyProperty.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                {
                     queueFamilyIndices.graphicsFamily_ = queueFamilyIndex;
+                    // Headless rendering never presents, so the graphics queue stands in for the present queue.
+                    if (surface == VK_NULL_HANDLE)
+                        presentSupport = VK_TRUE;
+                }
                 
                 if (presentSupport)
                     queueFamilyIndices.presentFamily_ = queueFamilyIndex;
                 
+                if ((queueFamilyProperty.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+                    !(queueFamilyProperty.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+                    !queueFamilyIndices.computeFamily_.has_value())
+                    queueFamilyIndices.computeFamily_ = queueFamilyIndex;
+                
+                if ((queueFamilyProperty.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                    !(queueFamilyProperty.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) &&
+                    !queueFamilyIndices.transferFamily_.has_value())
+                    queueFamilyIndices.transferFamily_ = queueFamilyIndex;
+                
                 queueFamilyIndex++;
             }
+            
+            // Without dedicated families, transfers prefer the async compute queue and both fall back to graphics.
+            if (!queueFamilyIndices.computeFamily_.has_value())
+                queueFamilyIndices.computeFamily_ = queueFamilyIndices.graphicsFamily_;
+            
+            if (!queueFamilyIndices.transferFamily_.has_value())
+                queueFamilyIndices.transferFamily_ = queueFamilyIndices.computeFamily_;
+            
             return queueFamilyIndices;
         }
         
@@ -488,11 +759,16 @@ namespace mgo
                 deviceQueueCreateInfos.emplace_back(this->getDeviceQueueCreateInfo(uniqueQueueFamily, &uniqueQueueFamilyIndices.priority_));
             
             std::vector<const char*> extensions = this->physicalDevice_.getExtensions();
+            for (const char* optionalExtension : this->physicalDevice_.getOptionalExtensions())
+                extensions.emplace_back(optionalExtension);
             VkPhysicalDeviceFeatures physicalDeviceFeatures = this->physicalDevice_.getPhysicalDeviceFeatures();
+            VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = this->physicalDevice_.getTimelineSemaphoreFeatures();
+            VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = this->physicalDevice_.getDescriptorIndexingFeatures();
+            timelineSemaphoreFeatures.pNext = &descriptorIndexingFeatures;
             
             VkDeviceCreateInfo deviceCreateInfo{};
             deviceCreateInfo.sType                      = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-            deviceCreateInfo.pNext                      = nullptr;
+            deviceCreateInfo.pNext                      = &timelineSemaphoreFeatures;
             deviceCreateInfo.flags                      = 0;
             deviceCreateInfo.queueCreateInfoCount       = static_cast<std::uint32_t>(deviceQueueCreateInfos.size());
             deviceCreateInfo.pQueueCreateInfos          = deviceQueueCreateInfos.data();
@@ -507,6 +783,8 @@ namespace mgo
             
             vkGetDeviceQueue(this->device_, this->physicalDevice_.getQueueFamilyIndices().graphicsFamily_.value(), 0, &this->graphicsQueue_);
             vkGetDeviceQueue(this->device_, this->physicalDevice_.getQueueFamilyIndices().presentFamily_.value(), 0, &this->presentQueue_);
+            vkGetDeviceQueue(this->device_, this->physicalDevice_.getQueueFamilyIndices().transferFamily_.value(), 0, &this->transferQueue_);
+            vkGetDeviceQueue(this->device_, this->physicalDevice_.getQueueFamilyIndices().computeFamily_.value(), 0, &this->computeQueue_);
         }
         
         Device::~Device() noexcept
@@ -529,6 +807,31 @@ namespace mgo
             return this->presentQueue_;
         }
         
+        const VkQueue& Device::getTransferQueue() const noexcept
+        {
+            return this->transferQueue_;
+        }
+        
+        const VkQueue& Device::getComputeQueue() const noexcept
+        {
+            return this->computeQueue_;
+        }
+        
+        const VkQueue& Device::getQueue(PhysicalDevice::QueueType queueType) const noexcept
+        {
+            switch (queueType)
+            {
+                case (PhysicalDevice::QueueType::TRANSFER)  : return this->transferQueue_;
+                case (PhysicalDevice::QueueType::COMPUTE)   : return this->computeQueue_;
+                default                                     : return this->graphicsQueue_;
+            };
+        }
+        
+        const PhysicalDevice& Device::getPhysicalDevice() const noexcept
+        {
+            return this->physicalDevice_;
+        }
+        
         VkDeviceQueueCreateInfo Device::getDeviceQueueCreateInfo(std::uint32_t queueFamily, const float* pQueuePriority) const noexcept
         {
             VkDeviceQueueCreateInfo deviceQueueCreateInfo{};
@@ -546,465 +849,2287 @@ namespace mgo
             vkDeviceWaitIdle(this->device_);
         }
         
-#pragma mark - mgo::vk::Semaphore
-        Semaphore::Semaphore(const Device& device)
+#pragma mark - mgo::vk::MemoryAllocator::SubAllocator
+        MemoryAllocator::SubAllocator::SubAllocator(VkDeviceSize size) noexcept
         :
-        device_(device)
-        {
-            VkSemaphoreCreateInfo semaphoreCreateInfo{};
-            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-            semaphoreCreateInfo.pNext = nullptr;
-            semaphoreCreateInfo.flags = 0;
-            
-            if (vkCreateSemaphore(this->device_.get(), &semaphoreCreateInfo, nullptr, &this->semaphore_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::Semaphore!");
-        }
+        size_(size),
+        usedBytes_(0),
+        allocationCount_(0)
+        {}
         
-        Semaphore::~Semaphore() noexcept
+        VkDeviceSize MemoryAllocator::SubAllocator::getUsedBytes() const noexcept
         {
-            vkDestroySemaphore(this->device_.get(), this->semaphore_, nullptr);
+            return this->usedBytes_;
         }
         
-        const VkSemaphore& Semaphore::get() const noexcept
+        std::size_t MemoryAllocator::SubAllocator::getAllocationCount() const noexcept
         {
-            return this->semaphore_;
+            return this->allocationCount_;
         }
         
-#pragma mark - mgo::vk::Fence
-        Fence::Fence(const Device& device)
+#pragma mark - mgo::vk::MemoryAllocator::LinearSubAllocator
+        MemoryAllocator::LinearSubAllocator::LinearSubAllocator(VkDeviceSize size) noexcept
         :
-        device_(device)
-        {
-            VkFenceCreateInfo fenceCreateInfo{};
-            fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-            fenceCreateInfo.pNext = nullptr;
-            fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-            
-            if (vkCreateFence(this->device_.get(), &fenceCreateInfo, nullptr, &this->fence_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::Fence!");
-        }
+        SubAllocator(size),
+        head_(0)
+        {}
         
-        Fence::~Fence() noexcept
+        std::optional<VkDeviceSize> MemoryAllocator::LinearSubAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
         {
-            vkDestroyFence(this->device_.get(), this->fence_, nullptr);
+            VkDeviceSize offset = MemoryAllocator::alignUp(this->head_, alignment);
+            if (offset + size > this->size_)
+                return std::nullopt;
+            
+            this->head_ = offset + size;
+            this->allocations_.emplace(offset, size);
+            this->usedBytes_ += size;
+            this->allocationCount_++;
+            return offset;
         }
         
-        const VkFence& Fence::get() const noexcept
+        void MemoryAllocator::LinearSubAllocator::free(VkDeviceSize offset)
         {
-            return this->fence_;
+            auto allocation = this->allocations_.find(offset);
+            if (allocation == this->allocations_.end())
+                return;
+            
+            this->usedBytes_ -= allocation->second;
+            this->allocationCount_--;
+            this->allocations_.erase(allocation);
+            
+            // A linear block only reclaims space once every allocation in it has been released.
+            if (this->allocations_.empty())
+                this->head_ = 0;
         }
         
-        void Fence::wait() const noexcept
+        void MemoryAllocator::LinearSubAllocator::addFreeRanges(Statistics& statistics) const noexcept
         {
-            vkWaitForFences(this->device_.get(), 1, &this->fence_, VK_TRUE, UINT64_MAX);
+            VkDeviceSize freeRange = this->size_ - this->head_;
+            if (freeRange == 0)
+                return;
+            
+            statistics.freeRangeCount_++;
+            statistics.freeBytes_ += freeRange;
+            statistics.largestFreeRange_ = std::max(statistics.largestFreeRange_, freeRange);
         }
         
-        void Fence::reset() const noexcept
-        {
-            vkResetFences(this->device_.get(),  1, &this->fence_);
-        }
-
-#pragma mark - mgo::vk::Swapchain
-        Swapchain::Swapchain(const Surface& surface, const PhysicalDevice& physicalDevice, const Device& device)
+#pragma mark - mgo::vk::MemoryAllocator::BuddySubAllocator
+        MemoryAllocator::BuddySubAllocator::BuddySubAllocator(VkDeviceSize size)
         :
-        surface_(surface),
-        physicalDevice_(physicalDevice),
-        device_(device)
-        {
-            this->create();
-        }
-        
-        Swapchain::~Swapchain() noexcept
+        SubAllocator(size),
+        maxOrder_(0)
         {
-            this->destory();
+            if (size < MIN_NODE_SIZE || (size & (size - 1)) != 0)
+                throw std::runtime_error("mgo::vk::MemoryAllocator::BuddySubAllocator size must be a power of two!");
+            
+            while ((MIN_NODE_SIZE << this->maxOrder_) < size)
+                this->maxOrder_++;
+            
+            this->freeNodes_.resize(this->maxOrder_ + 1);
+            this->freeNodes_[this->maxOrder_].emplace(0);
         }
         
-        void Swapchain::create()
+        std::optional<VkDeviceSize> MemoryAllocator::BuddySubAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
         {
-            this->surfaceCapabilities_ = this->surface_.getVkSurfaceCapabilitiesKHR(this->physicalDevice_);
-            this->surfaceFormat_ = this->surface_.getVkSurfaceFormatKHR(this->physicalDevice_);
-            this->presentMode_ = this->surface_.getVkPresentModeKHR(this->physicalDevice_);
-            this->extent_ = this->surface_.getVkExtent2D(this->physicalDevice_);
+            // Buddy nodes are aligned to their own size, so rounding up to the alignment is enough to honour it.
+            VkDeviceSize nodeSize = std::max({size, alignment, MIN_NODE_SIZE});
             
-            std::uint32_t minImageCount =
-            this->surfaceCapabilities_.maxImageCount > 0 &&
-            this->surfaceCapabilities_.minImageCount + 1 > this->surfaceCapabilities_.maxImageCount ?
-            this->surfaceCapabilities_.maxImageCount : this->surfaceCapabilities_.minImageCount + 1;
+            std::size_t order = 0;
+            while ((MIN_NODE_SIZE << order) < nodeSize)
+                order++;
             
-            std::set<std::uint32_t> UniqueQueueFamilyIndices = this->physicalDevice_.getUniqueQueueFamilyIndices().families_;
-            std::vector<std::uint32_t> queueFamilyIndices(UniqueQueueFamilyIndices.begin(), UniqueQueueFamilyIndices.end());
+            if (order > this->maxOrder_)
+                return std::nullopt;
             
-            VkSwapchainCreateInfoKHR swapchainCreateInfo{};
-            swapchainCreateInfo.sType                    = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-            swapchainCreateInfo.pNext                    = nullptr;
-            swapchainCreateInfo.flags                    = 0;
-            swapchainCreateInfo.surface                  = this->surface_.get();
-            swapchainCreateInfo.minImageCount            = minImageCount;
-            swapchainCreateInfo.imageFormat              = this->surfaceFormat_.format;
-            swapchainCreateInfo.imageColorSpace          = this->surfaceFormat_.colorSpace;
-            swapchainCreateInfo.imageExtent              = this->extent_;
-            swapchainCreateInfo.imageArrayLayers         = 1;
-            swapchainCreateInfo.imageUsage               = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-            swapchainCreateInfo.imageSharingMode         = VK_SHARING_MODE_EXCLUSIVE;
-            swapchainCreateInfo.queueFamilyIndexCount    = queueFamilyIndices.size() > 1 ? static_cast<std::uint32_t>(queueFamilyIndices.size()) : 0;
-            swapchainCreateInfo.pQueueFamilyIndices      = queueFamilyIndices.size() > 1 ? queueFamilyIndices.data() : nullptr;
-            swapchainCreateInfo.preTransform             = this->surfaceCapabilities_.currentTransform;
-            swapchainCreateInfo.compositeAlpha           = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-            swapchainCreateInfo.presentMode              = this->presentMode_;
-            swapchainCreateInfo.clipped                  = VK_TRUE;
-            swapchainCreateInfo.oldSwapchain             = VK_NULL_HANDLE;
+            std::size_t freeOrder = order;
+            while (freeOrder <= this->maxOrder_ && this->freeNodes_[freeOrder].empty())
+                freeOrder++;
             
-            if (vkCreateSwapchainKHR(this->device_.get(), &swapchainCreateInfo, nullptr, &this->swapchain_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::Swapchain!");
+            if (freeOrder > this->maxOrder_)
+                return std::nullopt;
+            
+            VkDeviceSize offset = *this->freeNodes_[freeOrder].begin();
+            this->freeNodes_[freeOrder].erase(this->freeNodes_[freeOrder].begin());
+            
+            while (freeOrder > order)
+            {
+                freeOrder--;
+                this->freeNodes_[freeOrder].emplace(offset + (MIN_NODE_SIZE << freeOrder));
+            }
+            
+            this->allocations_.emplace(offset, order);
+            this->usedBytes_ += MIN_NODE_SIZE << order;
+            this->allocationCount_++;
+            return offset;
         }
         
-        void Swapchain::destory()
+        void MemoryAllocator::BuddySubAllocator::free(VkDeviceSize offset)
         {
-            vkDestroySwapchainKHR(this->device_.get(), this->swapchain_, nullptr);
+            auto allocation = this->allocations_.find(offset);
+            if (allocation == this->allocations_.end())
+                return;
+            
+            std::size_t order = allocation->second;
+            this->usedBytes_ -= MIN_NODE_SIZE << order;
+            this->allocationCount_--;
+            this->allocations_.erase(allocation);
+            
+            while (order < this->maxOrder_)
+            {
+                VkDeviceSize buddy = offset ^ (MIN_NODE_SIZE << order);
+                auto freeBuddy = this->freeNodes_[order].find(buddy);
+                if (freeBuddy == this->freeNodes_[order].end())
+                    break;
+                
+                this->freeNodes_[order].erase(freeBuddy);
+                offset = std::min(offset, buddy);
+                order++;
+            }
+            this->freeNodes_[order].emplace(offset);
         }
         
-        void Swapchain::recreate()
+        void MemoryAllocator::BuddySubAllocator::addFreeRanges(Statistics& statistics) const noexcept
         {
-            this->destory();
-            this->create();
+            for (std::size_t order = 0; order <= this->maxOrder_; order++)
+            {
+                if (this->freeNodes_[order].empty())
+                    continue;
+                
+                statistics.freeRangeCount_ += this->freeNodes_[order].size();
+                statistics.freeBytes_ += (MIN_NODE_SIZE << order) * this->freeNodes_[order].size();
+                statistics.largestFreeRange_ = std::max(statistics.largestFreeRange_, MIN_NODE_SIZE << order);
+            }
         }
         
-        const VkSwapchainKHR& Swapchain::get() const noexcept
-        {
-            return this->swapchain_;
-        }
-
-        VkSurfaceCapabilitiesKHR Swapchain::getVkSurfaceCapabilitiesKHR() const noexcept
+#pragma mark - mgo::vk::MemoryAllocator::FreeListSubAllocator
+        MemoryAllocator::FreeListSubAllocator::FreeListSubAllocator(VkDeviceSize size) noexcept
+        :
+        SubAllocator(size)
         {
-            return this->surfaceCapabilities_;
+            this->freeRanges_.emplace(0, size);
         }
         
-        VkSurfaceFormatKHR Swapchain::getVkSurfaceFormatKHR() const noexcept
+        std::optional<VkDeviceSize> MemoryAllocator::FreeListSubAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
         {
-            return this->surfaceFormat_;
+            auto bestFit = this->freeRanges_.end();
+            for (auto freeRange = this->freeRanges_.begin(); freeRange != this->freeRanges_.end(); freeRange++)
+            {
+                VkDeviceSize offset = MemoryAllocator::alignUp(freeRange->first, alignment);
+                if (offset + size > freeRange->first + freeRange->second)
+                    continue;
+                
+                if (bestFit == this->freeRanges_.end() || freeRange->second < bestFit->second)
+                    bestFit = freeRange;
+            }
+            
+            if (bestFit == this->freeRanges_.end())
+                return std::nullopt;
+            
+            VkDeviceSize rangeOffset = bestFit->first;
+            VkDeviceSize rangeEnd = bestFit->first + bestFit->second;
+            VkDeviceSize offset = MemoryAllocator::alignUp(rangeOffset, alignment);
+            this->freeRanges_.erase(bestFit);
+            
+            if (offset > rangeOffset)
+                this->freeRanges_.emplace(rangeOffset, offset - rangeOffset);
+            if (offset + size < rangeEnd)
+                this->freeRanges_.emplace(offset + size, rangeEnd - offset - size);
+            
+            this->allocations_.emplace(offset, size);
+            this->usedBytes_ += size;
+            this->allocationCount_++;
+            return offset;
         }
         
-        VkPresentModeKHR Swapchain::getVkPresentModeKHR() const noexcept
+        void MemoryAllocator::FreeListSubAllocator::free(VkDeviceSize offset)
         {
-            return this->presentMode_;
+            auto allocation = this->allocations_.find(offset);
+            if (allocation == this->allocations_.end())
+                return;
+            
+            VkDeviceSize size = allocation->second;
+            this->usedBytes_ -= size;
+            this->allocationCount_--;
+            this->allocations_.erase(allocation);
+            
+            auto next = this->freeRanges_.lower_bound(offset);
+            if (next != this->freeRanges_.end() && offset + size == next->first)
+            {
+                size += next->second;
+                next = this->freeRanges_.erase(next);
+            }
+            if (next != this->freeRanges_.begin())
+            {
+                auto previous = std::prev(next);
+                if (previous->first + previous->second == offset)
+                {
+                    offset = previous->first;
+                    size += previous->second;
+                    this->freeRanges_.erase(previous);
+                }
+            }
+            this->freeRanges_.emplace(offset, size);
         }
         
-        VkExtent2D Swapchain::getVkExtent2D() const noexcept
+        void MemoryAllocator::FreeListSubAllocator::addFreeRanges(Statistics& statistics) const noexcept
         {
-            return this->extent_;
+            for (const auto& freeRange : this->freeRanges_)
+            {
+                statistics.freeRangeCount_++;
+                statistics.freeBytes_ += freeRange.second;
+                statistics.largestFreeRange_ = std::max(statistics.largestFreeRange_, freeRange.second);
+            }
         }
- 
-#pragma mark - mgo::vk::ImageViews
-        ImageViews::ImageViews(const Device& device, const Swapchain& swapchain)
+        
+#pragma mark - mgo::vk::MemoryAllocator
+        MemoryAllocator::MemoryAllocator(const PhysicalDevice& physicalDevice,
+                                         const Device& device,
+                                         Strategy defaultStrategy,
+                                         VkDeviceSize blockSize)
         :
+        defaultStrategy_(defaultStrategy == Strategy::DEFAULT ? Strategy::FREE_LIST : defaultStrategy),
+        blockSize_(blockSize),
+        maxMemoryAllocationCount_(physicalDevice.getPhysicalDeviceProperties().limits.maxMemoryAllocationCount),
+        physicalDevice_(physicalDevice),
         device_(device)
-        {
-            this->create(swapchain);
-        }
+        {}
         
-        ImageViews::~ImageViews() noexcept
+        MemoryAllocator::~MemoryAllocator() noexcept
         {
-            this->destory();
+            for (auto& pool : this->pools_)
+                for (auto& block : pool.second)
+                    this->destroyBlock(block);
         }
         
-        void ImageViews::create(const Swapchain& swapchain)
+        MemoryAllocator::Allocation MemoryAllocator::allocate(const VkMemoryRequirements& memoryRequirements,
+                                                              VkMemoryPropertyFlags memoryPropertyFlags,
+                                                              ResourceType resourceType,
+                                                              Strategy strategy)
         {
-            std::uint32_t imageCount;
-            vkGetSwapchainImagesKHR(this->device_.get(), swapchain.get(), &imageCount, nullptr);
+            std::uint32_t memoryTypeIndex = this->physicalDevice_.findMemoryTypeIndex(memoryRequirements.memoryTypeBits, memoryPropertyFlags);
+            strategy = strategy == Strategy::DEFAULT ? this->defaultStrategy_ : strategy;
             
-            this->imageViews_.resize(static_cast<std::size_t>(imageCount));
-            this->images_.resize(static_cast<std::size_t>(imageCount));
-            vkGetSwapchainImagesKHR(this->device_.get(), swapchain.get(), &imageCount, this->images_.data());
+            std::lock_guard<std::mutex> lock(this->mutex_);
             
-            for (std::size_t i = 0; i < static_cast<std::size_t>(imageCount); i++)
+            // Buffers and images live in separate pools so bufferImageGranularity never has to be honoured between them.
+            const PoolKey poolKey{memoryTypeIndex, resourceType, strategy};
+            auto pool = this->pools_.find(poolKey);
+            
+            if (pool != this->pools_.end())
+                for (auto& block : pool->second)
+                    if (std::optional<VkDeviceSize> offset = block.subAllocator_->allocate(memoryRequirements.size, memoryRequirements.alignment))
+                        return {block.memory_,
+                            offset.value(),
+                            memoryRequirements.size,
+                            block.pMappedData_ ? static_cast<std::uint8_t*>(block.pMappedData_) + offset.value() : nullptr,
+                            memoryTypeIndex,
+                            resourceType,
+                            strategy};
+            
+            // The pool entry is only created once its first block exists, so a failed vkAllocateMemory leaves no empty pool behind.
+            Block newBlock = this->createBlock(memoryTypeIndex, strategy, memoryRequirements.size + memoryRequirements.alignment);
+            try
             {
-                VkImageViewCreateInfo imageViewCreateInfo{};
-                imageViewCreateInfo.sType                            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-                imageViewCreateInfo.pNext                            = nullptr;
-                imageViewCreateInfo.flags                            = 0;
-                imageViewCreateInfo.image                            = this->images_[i];
-                imageViewCreateInfo.viewType                         = VK_IMAGE_VIEW_TYPE_2D;
-                imageViewCreateInfo.format                           = swapchain.getVkSurfaceFormatKHR().format;
-                imageViewCreateInfo.components.r                     = VK_COMPONENT_SWIZZLE_IDENTITY;
-                imageViewCreateInfo.components.g                     = VK_COMPONENT_SWIZZLE_IDENTITY;
-                imageViewCreateInfo.components.b                     = VK_COMPONENT_SWIZZLE_IDENTITY;
-                imageViewCreateInfo.components.a                     = VK_COMPONENT_SWIZZLE_IDENTITY;
-                imageViewCreateInfo.subresourceRange.aspectMask      = VK_IMAGE_ASPECT_COLOR_BIT;
-                imageViewCreateInfo.subresourceRange.baseMipLevel    = 0;
-                imageViewCreateInfo.subresourceRange.levelCount      = 1;
-                imageViewCreateInfo.subresourceRange.baseArrayLayer  = 0;
-                imageViewCreateInfo.subresourceRange.layerCount      = 1;
-                
-                if (vkCreateImageView(this->device_.get(), &imageViewCreateInfo, nullptr, &this->imageViews_[i]) != VK_SUCCESS)
-                    throw std::runtime_error("Failed to create mgo::vk::ImageViews!");
+                this->pools_[poolKey].push_back(std::move(newBlock));
+            }
+            catch (...)
+            {
+                this->destroyBlock(newBlock);
+                throw;
             }
+            Block& block = this->pools_[poolKey].back();
+            
+            std::optional<VkDeviceSize> offset = block.subAllocator_->allocate(memoryRequirements.size, memoryRequirements.alignment);
+            if (!offset.has_value())
+                throw std::runtime_error("Failed to allocate from a new mgo::vk::MemoryAllocator block!");
+            
+            return {block.memory_,
+                offset.value(),
+                memoryRequirements.size,
+                block.pMappedData_ ? static_cast<std::uint8_t*>(block.pMappedData_) + offset.value() : nullptr,
+                memoryTypeIndex,
+                resourceType,
+                strategy};
         }
         
-        void ImageViews::destory()
+        MemoryAllocator::Allocation MemoryAllocator::allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags memoryPropertyFlags, Strategy strategy)
         {
-            for (auto& imageView : this->imageViews_)
-                vkDestroyImageView(this->device_.get(), imageView, nullptr);
+            VkMemoryRequirements memoryRequirements;
+            vkGetBufferMemoryRequirements(this->device_.get(), buffer, &memoryRequirements);
+            
+            Allocation allocation = this->allocate(memoryRequirements, memoryPropertyFlags, ResourceType::BUFFER, strategy);
+            
+            if (vkBindBufferMemory(this->device_.get(), buffer, allocation.memory_, allocation.offset_) != VK_SUCCESS)
+            {
+                this->free(allocation);
+                throw std::runtime_error("Failed to bind mgo::vk::MemoryAllocator buffer memory!");
+            }
+            return allocation;
         }
         
-        void ImageViews::recreate(const Swapchain& swapchain)
+        MemoryAllocator::Allocation MemoryAllocator::allocateImage(VkImage image, VkMemoryPropertyFlags memoryPropertyFlags, Strategy strategy)
         {
-            this->destory();
-            this->create(swapchain);
+            VkMemoryRequirements memoryRequirements;
+            vkGetImageMemoryRequirements(this->device_.get(), image, &memoryRequirements);
+            
+            Allocation allocation = this->allocate(memoryRequirements, memoryPropertyFlags, ResourceType::IMAGE, strategy);
+            
+            if (vkBindImageMemory(this->device_.get(), image, allocation.memory_, allocation.offset_) != VK_SUCCESS)
+            {
+                this->free(allocation);
+                throw std::runtime_error("Failed to bind mgo::vk::MemoryAllocator image memory!");
+            }
+            return allocation;
         }
         
-        const std::vector<VkImageView>& ImageViews::get() const noexcept
+        void MemoryAllocator::free(const Allocation& allocation) noexcept
         {
-            return this->imageViews_;
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            
+            auto pool = this->pools_.find({allocation.memoryTypeIndex_, allocation.resourceType_, allocation.strategy_});
+            if (pool == this->pools_.end())
+                return;
+            
+            std::vector<Block>& blocks = pool->second;
+            for (auto block = blocks.begin(); block != blocks.end(); block++)
+            {
+                if (block->memory_ != allocation.memory_)
+                    continue;
+                
+                block->subAllocator_->free(allocation.offset_);
+                
+                // Keep one empty block per pool around so allocation churn does not thrash vkAllocateMemory.
+                if (block->subAllocator_->getAllocationCount() == 0 && blocks.size() > 1)
+                {
+                    this->destroyBlock(*block);
+                    blocks.erase(block);
+                }
+                return;
+            }
         }
         
-        std::size_t ImageViews::size() const noexcept
+        MemoryAllocator::Statistics MemoryAllocator::getStatistics() const noexcept
         {
-            return this->imageViews_.size();
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            
+            Statistics statistics{};
+            for (const auto& pool : this->pools_)
+                for (const auto& block : pool.second)
+                {
+                    statistics.blockCount_++;
+                    statistics.allocationCount_ += block.subAllocator_->getAllocationCount();
+                    statistics.blockBytes_ += block.size_;
+                    statistics.usedBytes_ += block.subAllocator_->getUsedBytes();
+                    block.subAllocator_->addFreeRanges(statistics);
+                }
+            
+            statistics.fragmentation_ = statistics.freeBytes_ > 0 ?
+            1.0f - static_cast<float>(statistics.largestFreeRange_) / static_cast<float>(statistics.freeBytes_) : 0.0f;
+            return statistics;
         }
         
-#pragma mark - mgo::vk::RenderPass
-        RenderPass::RenderPass(const Device& device, const Swapchain& swapchain)
-        :
-        device_(device),
-        swapchain_(swapchain)
+        MemoryAllocator::Block MemoryAllocator::createBlock(std::uint32_t memoryTypeIndex, Strategy strategy, VkDeviceSize minimumSize)
         {
-            std::vector<VkAttachmentDescription> attachmentDescriptions = {this->getVkAttachmentDescription()};
-            VkAttachmentReference attachmentReference = this->getVkAttachmentReference();
-            std::vector<VkSubpassDescription> subpassDescriptions = {this->getVkSubpassDescription(&attachmentReference)};
+            if (this->getBlockCount() >= this->maxMemoryAllocationCount_)
+                throw std::runtime_error("mgo::vk::MemoryAllocator exceeded maxMemoryAllocationCount!");
             
-            VkRenderPassCreateInfo renderPassCreateInfo{};
-            renderPassCreateInfo.sType              = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-            renderPassCreateInfo.pNext              = nullptr;
-            renderPassCreateInfo.flags              = 0;
-            renderPassCreateInfo.attachmentCount    = static_cast<std::uint32_t>(attachmentDescriptions.size());
-            renderPassCreateInfo.pAttachments       = attachmentDescriptions.data();
-            renderPassCreateInfo.subpassCount       = static_cast<std::uint32_t>(subpassDescriptions.size());
-            renderPassCreateInfo.pSubpasses         = subpassDescriptions.data();
-            renderPassCreateInfo.dependencyCount    = 0;
-            renderPassCreateInfo.pDependencies      = nullptr;
+            Block block{};
+            block.size_ = std::max(this->blockSize_, minimumSize);
+            if (strategy == Strategy::BUDDY)
+                block.size_ = std::bit_ceil(std::max(block.size_, BuddySubAllocator::MIN_NODE_SIZE));
             
-            if (vkCreateRenderPass(this->device_.get(), &renderPassCreateInfo, nullptr, &this->renderPass_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::RenderPass!");
+            VkMemoryAllocateInfo memoryAllocateInfo{};
+            memoryAllocateInfo.sType            = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            memoryAllocateInfo.pNext            = nullptr;
+            memoryAllocateInfo.allocationSize   = block.size_;
+            memoryAllocateInfo.memoryTypeIndex  = memoryTypeIndex;
+            
+            if (vkAllocateMemory(this->device_.get(), &memoryAllocateInfo, nullptr, &block.memory_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to allocate mgo::vk::MemoryAllocator block!");
+            
+            // Host visible blocks stay mapped for their whole lifetime so suballocations can be written without vkMapMemory.
+            VkMemoryPropertyFlags memoryPropertyFlags =
+            this->physicalDevice_.getPhysicalDeviceMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags;
+            if (memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+                if (vkMapMemory(this->device_.get(), block.memory_, 0, VK_WHOLE_SIZE, 0, &block.pMappedData_) != VK_SUCCESS)
+                {
+                    vkFreeMemory(this->device_.get(), block.memory_, nullptr);
+                    throw std::runtime_error("Failed to map mgo::vk::MemoryAllocator block!");
+                }
+            
+            switch (strategy)
+            {
+                case (Strategy::LINEAR) : {block.subAllocator_ = std::make_unique<LinearSubAllocator>(block.size_); break;}
+                case (Strategy::BUDDY)  : {block.subAllocator_ = std::make_unique<BuddySubAllocator>(block.size_); break;}
+                default                 : {block.subAllocator_ = std::make_unique<FreeListSubAllocator>(block.size_); break;}
+            };
+            return block;
         }
         
-        RenderPass::~RenderPass() noexcept
+        void MemoryAllocator::destroyBlock(Block& block) const noexcept
         {
-            vkDestroyRenderPass(this->device_.get(), this->renderPass_, nullptr);
+            if (block.pMappedData_)
+                vkUnmapMemory(this->device_.get(), block.memory_);
+            vkFreeMemory(this->device_.get(), block.memory_, nullptr);
         }
         
-        const VkRenderPass& RenderPass::get() const noexcept
+        std::size_t MemoryAllocator::getBlockCount() const noexcept
         {
-            return this->renderPass_;
+            std::size_t blockCount = 0;
+            for (const auto& pool : this->pools_)
+                blockCount += pool.second.size();
+            return blockCount;
         }
         
-        VkAttachmentDescription RenderPass::getVkAttachmentDescription() const noexcept
+        VkDeviceSize MemoryAllocator::alignUp(VkDeviceSize value, VkDeviceSize alignment) noexcept
         {
-            VkAttachmentDescription attachmentDescription{};
-            attachmentDescription.flags           = 0;
-            attachmentDescription.format          = this->swapchain_.getVkSurfaceFormatKHR().format;
-            attachmentDescription.samples         = VK_SAMPLE_COUNT_1_BIT;
-            attachmentDescription.loadOp          = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachmentDescription.storeOp         = VK_ATTACHMENT_STORE_OP_STORE;
-            attachmentDescription.stencilLoadOp   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            attachmentDescription.stencilStoreOp  = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachmentDescription.initialLayout   = VK_IMAGE_LAYOUT_UNDEFINED;
-            attachmentDescription.finalLayout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-            return attachmentDescription;
+            return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+        }
+        
+#pragma mark - mgo::vk::Semaphore
+        Semaphore::Semaphore(const Device& device)
+        :
+        device_(device)
+        {
+            VkSemaphoreCreateInfo semaphoreCreateInfo{};
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphoreCreateInfo.pNext = nullptr;
+            semaphoreCreateInfo.flags = 0;
+            
+            if (vkCreateSemaphore(this->device_.get(), &semaphoreCreateInfo, nullptr, &this->semaphore_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::Semaphore!");
         }
         
-        VkAttachmentReference RenderPass::getVkAttachmentReference() const noexcept
+        Semaphore::~Semaphore() noexcept
         {
-            VkAttachmentReference attachmentReference;
-            attachmentReference.attachment  = 0;
-            attachmentReference.layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-            return attachmentReference;
+            vkDestroySemaphore(this->device_.get(), this->semaphore_, nullptr);
         }
         
-        VkSubpassDescription RenderPass::getVkSubpassDescription(const VkAttachmentReference* pColorAttachmentReference) const noexcept
+        const VkSemaphore& Semaphore::get() const noexcept
         {
-            VkSubpassDescription subpassDescription{};
-            subpassDescription.flags                    = 0;
-            subpassDescription.pipelineBindPoint        = VK_PIPELINE_BIND_POINT_GRAPHICS;
-            subpassDescription.inputAttachmentCount     = 0;
-            subpassDescription.pInputAttachments        = nullptr;
-            subpassDescription.colorAttachmentCount     = 1;
-            subpassDescription.pColorAttachments        = pColorAttachmentReference;
-            subpassDescription.pResolveAttachments      = nullptr;
-            subpassDescription.pDepthStencilAttachment  = nullptr;
-            subpassDescription.preserveAttachmentCount  = 0;
-            subpassDescription.pPreserveAttachments     = nullptr;
-            return subpassDescription;
+            return this->semaphore_;
         }
         
-#pragma mark - mgo::vk::Framebuffers
-        Framebuffers::Framebuffers(const Device& device, const Swapchain& swapchain, ImageViews& imageViews, const RenderPass& renderPass)
+#pragma mark - mgo::vk::TimelineSemaphore
+        TimelineSemaphore::TimelineSemaphore(const Device& device, std::uint64_t initialValue)
         :
-        device_(device),
-        imageViews_(imageViews)
+        device_(device)
         {
-            this->create(swapchain, renderPass);
+            VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{};
+            semaphoreTypeCreateInfo.sType           = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            semaphoreTypeCreateInfo.pNext           = nullptr;
+            semaphoreTypeCreateInfo.semaphoreType   = VK_SEMAPHORE_TYPE_TIMELINE;
+            semaphoreTypeCreateInfo.initialValue    = initialValue;
+            
+            VkSemaphoreCreateInfo semaphoreCreateInfo{};
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+            semaphoreCreateInfo.flags = 0;
+            
+            if (vkCreateSemaphore(this->device_.get(), &semaphoreCreateInfo, nullptr, &this->semaphore_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::TimelineSemaphore!");
         }
         
-        Framebuffers::~Framebuffers() noexcept
+        TimelineSemaphore::~TimelineSemaphore() noexcept
         {
-            this->destory();
+            vkDestroySemaphore(this->device_.get(), this->semaphore_, nullptr);
+        }
+        
+        const VkSemaphore& TimelineSemaphore::get() const noexcept
+        {
+            return this->semaphore_;
+        }
+        
+        std::uint64_t TimelineSemaphore::getValue() const noexcept
+        {
+            std::uint64_t value = 0;
+            vkGetSemaphoreCounterValue(this->device_.get(), this->semaphore_, &value);
+            return value;
         }
         
-        void Framebuffers::create(const Swapchain& swapchain, const RenderPass& renderPass)
+        bool TimelineSemaphore::wait(std::uint64_t value, std::uint64_t timeout) const noexcept
         {
-            this->framebuffers_.resize(this->imageViews_.size());
+            VkSemaphoreWaitInfo semaphoreWaitInfo{};
+            semaphoreWaitInfo.sType             = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            semaphoreWaitInfo.pNext             = nullptr;
+            semaphoreWaitInfo.flags             = 0;
+            semaphoreWaitInfo.semaphoreCount    = 1;
+            semaphoreWaitInfo.pSemaphores       = &this->semaphore_;
+            semaphoreWaitInfo.pValues           = &value;
             
-            for (std::size_t i = 0; i < this->imageViews_.size(); i++)
-            {
-                VkFramebufferCreateInfo framebufferCreateInfo{};
-                framebufferCreateInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-                framebufferCreateInfo.pNext           = nullptr;
-                framebufferCreateInfo.flags           = 0;
-                framebufferCreateInfo.renderPass      = renderPass.get();
-                framebufferCreateInfo.attachmentCount = 1;
-                framebufferCreateInfo.pAttachments    = &this->imageViews_.get()[i];
-                framebufferCreateInfo.width           = swapchain.getVkExtent2D().width;
-                framebufferCreateInfo.height          = swapchain.getVkExtent2D().height;
-                framebufferCreateInfo.layers          = 1;
-                
-                if (vkCreateFramebuffer(this->device_.get(), &framebufferCreateInfo, nullptr, &this->framebuffers_[i]) != VK_SUCCESS)
-                    throw std::runtime_error("Failed to create mgo::vk::Framebuffers!");
-            }
+            return vkWaitSemaphores(this->device_.get(), &semaphoreWaitInfo, timeout) == VK_SUCCESS;
         }
         
-        void Framebuffers::destory()
+        void TimelineSemaphore::signal(std::uint64_t value) const
         {
-            for (auto& framebuffer : this->framebuffers_)
-                vkDestroyFramebuffer(this->device_.get(), framebuffer, nullptr);
+            VkSemaphoreSignalInfo semaphoreSignalInfo{};
+            semaphoreSignalInfo.sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+            semaphoreSignalInfo.pNext       = nullptr;
+            semaphoreSignalInfo.semaphore   = this->semaphore_;
+            semaphoreSignalInfo.value       = value;
+            
+            if (vkSignalSemaphore(this->device_.get(), &semaphoreSignalInfo) != VK_SUCCESS)
+                throw std::runtime_error("Failed to signal mgo::vk::TimelineSemaphore!");
         }
         
-        void Framebuffers::recreate(const Swapchain& swapchain, const RenderPass& renderPass)
+#pragma mark - mgo::vk::QueueTimelines
+        QueueTimelines::QueueTimelines(const Device& device)
+        :
+        submittedValues_{},
+        completedValues_{}
         {
-            this->destory();
-            this->imageViews_.recreate(swapchain);
-            this->create(swapchain, renderPass);
+            for (std::unique_ptr<TimelineSemaphore>& semaphore : this->semaphores_)
+                semaphore = std::make_unique<TimelineSemaphore>(device);
         }
         
-        const std::vector<VkFramebuffer>& Framebuffers::get() const noexcept
+        std::uint64_t QueueTimelines::getNextValue(PhysicalDevice::QueueType queueType) const noexcept
         {
-            return this->framebuffers_;
+            return this->submittedValues_[static_cast<std::size_t>(queueType)] + 1;
         }
         
-        std::size_t Framebuffers::size() const noexcept
+        std::uint64_t QueueTimelines::advance(PhysicalDevice::QueueType queueType) noexcept
         {
-            return this->framebuffers_.size();
+            // Called once the submission signalling the next value was accepted, so a failed submit leaves no gap.
+            return ++this->submittedValues_[static_cast<std::size_t>(queueType)];
         }
         
+        std::uint64_t QueueTimelines::getSubmittedValue(PhysicalDevice::QueueType queueType) const noexcept
+        {
+            return this->submittedValues_[static_cast<std::size_t>(queueType)];
+        }
         
-#pragma mark - mgo::vk::PipelineLayout
-        PipelineLayout::PipelineLayout(const Device& device)
-        :
-        device_(device)
+        std::uint64_t QueueTimelines::getCompletedValue(PhysicalDevice::QueueType queueType) const noexcept
         {
-            VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-            pipelineLayoutCreateInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-            pipelineLayoutCreateInfo.pNext                   = nullptr;
-            pipelineLayoutCreateInfo.flags                   = 0;
-            pipelineLayoutCreateInfo.setLayoutCount          = 0;
-            pipelineLayoutCreateInfo.pSetLayouts             = nullptr;
-            pipelineLayoutCreateInfo.pushConstantRangeCount  = 0;
-            pipelineLayoutCreateInfo.pPushConstantRanges     = nullptr;
+            std::atomic<std::uint64_t>& completedValue = this->completedValues_[static_cast<std::size_t>(queueType)];
+            const std::uint64_t value = this->semaphores_[static_cast<std::size_t>(queueType)]->getValue();
             
-            if (vkCreatePipelineLayout(this->device_.get(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::PipelineLayout!");
+            // Concurrent pollers may race, so the cached value only ever moves forward.
+            std::uint64_t cachedValue = completedValue.load();
+            while (cachedValue < value && !completedValue.compare_exchange_weak(cachedValue, value)) {}
+            return std::max(cachedValue, value);
         }
         
-        PipelineLayout::~PipelineLayout() noexcept
+        bool QueueTimelines::isComplete(PhysicalDevice::QueueType queueType, std::uint64_t value) const noexcept
         {
-            vkDestroyPipelineLayout(this->device_.get(), this->pipelineLayout_, nullptr);
+            // The cached value answers most polls without a driver call.
+            return value <= this->completedValues_[static_cast<std::size_t>(queueType)] || value <= this->getCompletedValue(queueType);
         }
         
-        const VkPipelineLayout& PipelineLayout::get() const noexcept
+        bool QueueTimelines::wait(PhysicalDevice::QueueType queueType, std::uint64_t value, std::uint64_t timeout) const noexcept
         {
-            return pipelineLayout_;
+            if (this->isComplete(queueType, value))
+                return true;
+            return this->semaphores_[static_cast<std::size_t>(queueType)]->wait(value, timeout);
+        }
+        
+        VkSemaphore QueueTimelines::getSemaphore(PhysicalDevice::QueueType queueType) const noexcept
+        {
+            return this->semaphores_[static_cast<std::size_t>(queueType)]->get();
         }
         
-#pragma mark - mgo::vk::Pipeline::ShaderModule
-        Pipeline::ShaderModule::ShaderModule(const std::string& path, const Device& device)
+#pragma mark - mgo::vk::DeletionQueue
+        DeletionQueue::DeletionQueue(const QueueTimelines& queueTimelines)
         :
-        device_(device)
+        queueTimelines_(queueTimelines)
+        {}
+        
+        DeletionQueue::~DeletionQueue() noexcept
+        {
+            // The owner drains the device first, so everything left can go.
+            this->release(UINT64_MAX);
+        }
+        
+        void DeletionQueue::push(std::function<void()> deletion)
+        {
+            // Without an explicit frame, the handle may still be used by the frame being recorded, which signals the next value.
+            this->push(std::move(deletion), this->queueTimelines_.getNextValue(PhysicalDevice::QueueType::GRAPHICS));
+        }
+        
+        void DeletionQueue::push(std::function<void()> deletion, std::uint64_t retireFrame)
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->deletions_.emplace_back(std::move(deletion), retireFrame);
+        }
+        
+        void DeletionQueue::release(std::uint64_t completedFrame) noexcept
         {
-            std::ifstream fileStream(path, std::ios::ate | std::ios::binary);
+            std::vector<std::function<void()>> deletions;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                std::erase_if(this->deletions_, [&](std::pair<std::function<void()>, std::uint64_t>& deletion)
+                {
+                    if (deletion.second > completedFrame)
+                        return false;
+                    deletions.emplace_back(std::move(deletion.first));
+                    return true;
+                });
+            }
             
-            if (!fileStream.is_open())
-                throw std::runtime_error("Failed to open shader: " + path);
+            // Deletions run outside the lock so they may push further deletions.
+            for (const std::function<void()>& deletion : deletions)
+                deletion();
+        }
+        
+        void DeletionQueue::collect() noexcept
+        {
+            this->release(this->queueTimelines_.getCompletedValue(PhysicalDevice::QueueType::GRAPHICS));
+        }
+        
+        std::size_t DeletionQueue::size() const noexcept
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            return this->deletions_.size();
+        }
+        
+#pragma mark - mgo::vk::Buffer
+        Buffer::Buffer(const Device& device,
+                       MemoryAllocator& memoryAllocator,
+                       VkDeviceSize size,
+                       VkBufferUsageFlags usage,
+                       VkMemoryPropertyFlags memoryPropertyFlags,
+                       DeletionQueue* pDeletionQueue)
+        :
+        size_(size),
+        device_(device),
+        memoryAllocator_(memoryAllocator),
+        pDeletionQueue_(pDeletionQueue)
+        {
+            // Buffers are shared between the graphics, transfer and compute families to avoid ownership transfers.
+            PhysicalDevice::UniqueQueueFamilyIndices uniqueQueueFamilyIndices = this->device_.getPhysicalDevice().getUniqueQueueFamilyIndices();
+            std::vector<std::uint32_t> queueFamilies(uniqueQueueFamilyIndices.families_.begin(), uniqueQueueFamilyIndices.families_.end());
             
-            std::size_t fileSize = static_cast<std::size_t>(fileStream.tellg());
-            std::vector<char> code(fileSize);
+            VkBufferCreateInfo bufferCreateInfo{};
+            bufferCreateInfo.sType                  = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferCreateInfo.pNext                  = nullptr;
+            bufferCreateInfo.flags                  = 0;
+            bufferCreateInfo.size                   = this->size_;
+            bufferCreateInfo.usage                  = usage;
+            bufferCreateInfo.sharingMode            = queueFamilies.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+            bufferCreateInfo.queueFamilyIndexCount  = queueFamilies.size() > 1 ? static_cast<std::uint32_t>(queueFamilies.size()) : 0;
+            bufferCreateInfo.pQueueFamilyIndices    = queueFamilies.size() > 1 ? queueFamilies.data() : nullptr;
             
-            fileStream.seekg(0);
-            fileStream.read(code.data(), fileSize);
-            fileStream.close();
+            if (vkCreateBuffer(this->device_.get(), &bufferCreateInfo, nullptr, &this->buffer_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::Buffer!");
             
-            VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-            shaderModuleCreateInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            shaderModuleCreateInfo.pNext    = nullptr;
-            shaderModuleCreateInfo.flags    = 0;
-            shaderModuleCreateInfo.codeSize = code.size();
-            shaderModuleCreateInfo.pCode    = reinterpret_cast<const uint32_t*>(code.data());
+            try
+            {
+                this->allocation_ = this->memoryAllocator_.allocateBuffer(this->buffer_, memoryPropertyFlags);
+            }
+            catch (...)
+            {
+                vkDestroyBuffer(this->device_.get(), this->buffer_, nullptr);
+                throw;
+            }
+        }
+        
+        Buffer::~Buffer() noexcept
+        {
+            if (this->pDeletionQueue_ != nullptr)
+            {
+                this->pDeletionQueue_->push([&device = this->device_, &memoryAllocator = this->memoryAllocator_, buffer = this->buffer_, allocation = this->allocation_]()
+                {
+                    vkDestroyBuffer(device.get(), buffer, nullptr);
+                    memoryAllocator.free(allocation);
+                });
+                return;
+            }
             
-            if (vkCreateShaderModule(this->device_.get(), &shaderModuleCreateInfo, nullptr, &this->shaderModule_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::Pipeline::ShaderModule!");
+            vkDestroyBuffer(this->device_.get(), this->buffer_, nullptr);
+            this->memoryAllocator_.free(this->allocation_);
         }
         
-        Pipeline::ShaderModule::~ShaderModule() noexcept
+        const VkBuffer& Buffer::get() const noexcept
         {
-            vkDestroyShaderModule(this->device_.get(), this->shaderModule_, nullptr);
+            return this->buffer_;
         }
         
-        const VkShaderModule& Pipeline::ShaderModule::get() const noexcept
+        VkDeviceSize Buffer::size() const noexcept
         {
-            return this->shaderModule_;
+            return this->size_;
         }
         
-#pragma mark - mgo::vk::Pipeline
-        Pipeline::Pipeline(const Device& device, const RenderPass& renderPass, const PipelineLayout& pipelineLayout)
+        void* Buffer::getMappedData() const noexcept
+        {
+            return this->allocation_.pMappedData_;
+        }
+
+#pragma mark - mgo::vk::Swapchain
+        Swapchain::Swapchain(const Surface& surface,
+                             const PhysicalDevice& physicalDevice,
+                             const Device& device,
+                             MemoryAllocator& memoryAllocator,
+                             DeletionQueue& deletionQueue,
+                             const PresentPolicy& presentPolicy,
+                             std::uint32_t requestedImageCount)
         :
+        presentPolicy_(presentPolicy),
+        outOfDate_(false),
+        requestedImageCount_(requestedImageCount),
+        surface_(surface),
+        physicalDevice_(physicalDevice),
         device_(device),
-        renderPass_(renderPass),
-        pipelineLayout_(pipelineLayout)
+        memoryAllocator_(memoryAllocator),
+        deletionQueue_(deletionQueue)
         {
-            ShaderModule vertShaderModule("MangosEngine/Vulkan/SPIR-V/vert.spv", this->device_);
-            VkPipelineShaderStageCreateInfo vertPipelineShaderStageCreateInfo =
-            this->getVkPipelineShaderStageCreateInfo(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT);
-            
-            ShaderModule fragShaderModule("MangosEngine/Vulkan/SPIR-V/frag.spv", this->device_);
-            VkPipelineShaderStageCreateInfo fragPipelineShaderStageCreateInfo =
-            this->getVkPipelineShaderStageCreateInfo(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT);
-            
-            std::vector<VkPipelineShaderStageCreateInfo> stages = {vertPipelineShaderStageCreateInfo, fragPipelineShaderStageCreateInfo};
+            this->create();
+        }
+        
+        Swapchain::~Swapchain() noexcept
+        {
+            this->destory();
+        }
+        
+        void Swapchain::create(VkSwapchainKHR oldSwapchain)
+        {
+            this->surfaceCapabilities_ = this->surface_.getVkSurfaceCapabilitiesKHR(this->physicalDevice_);
+            this->surfaceFormat_ = this->surface_.getVkSurfaceFormatKHR(this->physicalDevice_);
+            this->presentMode_ = this->surface_.getVkPresentModeKHR(this->physicalDevice_, this->presentPolicy_);
+            this->outOfDate_ = false;
+            this->extent_ = this->surface_.getVkExtent2D(this->physicalDevice_);
             
-            VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo =
-            this->getVkPipelineVertexInputStateCreateInfo();
+            std::uint32_t minImageCount = this->getMinImageCount();
             
-            VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo =
-            this->getVkPipelineInputAssemblyStateCreateInfo();
+            if (this->surface_.isHeadless())
+            {
+                this->swapchain_ = VK_NULL_HANDLE;
+                this->createOffscreenImages(minImageCount);
+                return;
+            }
             
-            VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo =
-            this->getVkPipelineViewportStateCreateInfo();
+            std::set<std::uint32_t> UniqueQueueFamilyIndices = this->physicalDevice_.getUniqueQueueFamilyIndices().families_;
+            std::vector<std::uint32_t> queueFamilyIndices(UniqueQueueFamilyIndices.begin(), UniqueQueueFamilyIndices.end());
             
-            VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo =
-            this->getVkPipelineRasterizationStateCreateInfo();
+            VkSwapchainCreateInfoKHR swapchainCreateInfo{};
+            swapchainCreateInfo.sType                    = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+            swapchainCreateInfo.pNext                    = nullptr;
+            swapchainCreateInfo.flags                    = 0;
+            swapchainCreateInfo.surface                  = this->surface_.get();
+            swapchainCreateInfo.minImageCount            = minImageCount;
+            swapchainCreateInfo.imageFormat              = this->surfaceFormat_.format;
+            swapchainCreateInfo.imageColorSpace          = this->surfaceFormat_.colorSpace;
+            swapchainCreateInfo.imageExtent              = this->extent_;
+            swapchainCreateInfo.imageArrayLayers         = 1;
+            swapchainCreateInfo.imageUsage               = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            swapchainCreateInfo.imageSharingMode         = VK_SHARING_MODE_EXCLUSIVE;
+            swapchainCreateInfo.queueFamilyIndexCount    = queueFamilyIndices.size() > 1 ? static_cast<std::uint32_t>(queueFamilyIndices.size()) : 0;
+            swapchainCreateInfo.pQueueFamilyIndices      = queueFamilyIndices.size() > 1 ? queueFamilyIndices.data() : nullptr;
+            swapchainCreateInfo.preTransform             = this->surfaceCapabilities_.currentTransform;
+            swapchainCreateInfo.compositeAlpha           = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+            swapchainCreateInfo.presentMode              = this->presentMode_;
+            swapchainCreateInfo.clipped                  = VK_TRUE;
+            swapchainCreateInfo.oldSwapchain             = oldSwapchain;
             
-            VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo =
-            this->getVkPipelineMultisampleStateCreateInfo();
+            if (vkCreateSwapchainKHR(this->device_.get(), &swapchainCreateInfo, nullptr, &this->swapchain_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::Swapchain!");
             
-            std::vector<VkPipelineColorBlendAttachmentState> attachments = {this->getVkPipelineColorBlendAttachmentState()};
-            VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo =
-            this->getVkPipelineColorBlendStateCreateInfo(attachments);
+            std::uint32_t imageCount;
+            vkGetSwapchainImagesKHR(this->device_.get(), this->swapchain_, &imageCount, nullptr);
             
-            std::vector<VkDynamicState> dynamicStates ={VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
-            VkPipelineDynamicStateCreateInfo pipelineDynamicStateCreateInfo =
-            this->getVkPipelineDynamicStateCreateInfo(dynamicStates);
+            this->images_.resize(static_cast<std::size_t>(imageCount));
+            vkGetSwapchainImagesKHR(this->device_.get(), this->swapchain_, &imageCount, this->images_.data());
+        }
+        
+        void Swapchain::createOffscreenImages(std::uint32_t imageCount)
+        {
+            this->images_.resize(static_cast<std::size_t>(imageCount));
             
+            for (std::size_t i = 0; i < static_cast<std::size_t>(imageCount); i++)
+            {
+                VkImageCreateInfo imageCreateInfo{};
+                imageCreateInfo.sType                  = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                imageCreateInfo.pNext                  = nullptr;
+                imageCreateInfo.flags                  = 0;
+                imageCreateInfo.imageType              = VK_IMAGE_TYPE_2D;
+                imageCreateInfo.format                 = this->surfaceFormat_.format;
+                imageCreateInfo.extent                 = {this->extent_.width, this->extent_.height, 1};
+                imageCreateInfo.mipLevels              = 1;
+                imageCreateInfo.arrayLayers            = 1;
+                imageCreateInfo.samples                = VK_SAMPLE_COUNT_1_BIT;
+                imageCreateInfo.tiling                 = VK_IMAGE_TILING_OPTIMAL;
+                imageCreateInfo.usage                  = this->surfaceCapabilities_.supportedUsageFlags;
+                imageCreateInfo.sharingMode            = VK_SHARING_MODE_EXCLUSIVE;
+                imageCreateInfo.queueFamilyIndexCount  = 0;
+                imageCreateInfo.pQueueFamilyIndices    = nullptr;
+                imageCreateInfo.initialLayout          = VK_IMAGE_LAYOUT_UNDEFINED;
+                
+                if (vkCreateImage(this->device_.get(), &imageCreateInfo, nullptr, &this->images_[i]) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to create mgo::vk::Swapchain offscreen image!");
+                
+                this->imageAllocations_.emplace_back(this->memoryAllocator_.allocateImage(this->images_[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+            }
+        }
+        
+        void Swapchain::destory()
+        {
+            if (this->swapchain_ != VK_NULL_HANDLE)
+                vkDestroySwapchainKHR(this->device_.get(), this->swapchain_, nullptr);
             
-            VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
-            graphicsPipelineCreateInfo.sType                = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            for (std::size_t i = 0; i < this->imageAllocations_.size(); i++)
+            {
+                vkDestroyImage(this->device_.get(), this->images_[i], nullptr);
+                this->memoryAllocator_.free(this->imageAllocations_[i]);
+            }
+            this->imageAllocations_.clear();
+            this->images_.clear();
+        }
+        
+        std::uint32_t Swapchain::getMinImageCount() const noexcept
+        {
+            // A requested count of 0 keeps one image more than the surface minimum.
+            std::uint32_t imageCount = this->requestedImageCount_ > 0 ? this->requestedImageCount_ : this->surfaceCapabilities_.minImageCount + 1;
+            imageCount = std::max(imageCount, this->surfaceCapabilities_.minImageCount);
+            if (this->surfaceCapabilities_.maxImageCount > 0)
+                imageCount = std::min(imageCount, this->surfaceCapabilities_.maxImageCount);
+            return imageCount;
+        }
+        
+        void Swapchain::recreate(std::uint64_t retireFrame)
+        {
+            // Offscreen images are never invalidated by the surface, so headless recreation may simply drain the device.
+            if (this->surface_.isHeadless())
+            {
+                this->device_.wait();
+                this->destory();
+                this->create();
+                return;
+            }
+            
+            // The old swapchain keeps presenting its queued images until the frames that used them have finished.
+            VkSwapchainKHR oldSwapchain = this->swapchain_;
+            this->create(oldSwapchain);
+            this->deletionQueue_.push([&device = this->device_, oldSwapchain]()
+            {
+                vkDestroySwapchainKHR(device.get(), oldSwapchain, nullptr);
+            }, retireFrame);
+        }
+        
+        void Swapchain::setPresentPolicy(const PresentPolicy& presentPolicy) noexcept
+        {
+            if (this->presentPolicy_ == presentPolicy)
+                return;
+            
+            // The swapchain is rebuilt at the next acquire, on the same device.
+            this->presentPolicy_ = presentPolicy;
+            this->outOfDate_ = this->presentMode_ != this->surface_.getVkPresentModeKHR(this->physicalDevice_, this->presentPolicy_);
+        }
+        
+        const PresentPolicy& Swapchain::getPresentPolicy() const noexcept
+        {
+            return this->presentPolicy_;
+        }
+        
+        bool Swapchain::isOutOfDate() const noexcept
+        {
+            return this->outOfDate_;
+        }
+        
+        const VkSwapchainKHR& Swapchain::get() const noexcept
+        {
+            return this->swapchain_;
+        }
+        
+        const std::vector<VkImage>& Swapchain::getImages() const noexcept
+        {
+            return this->images_;
+        }
+        
+        bool Swapchain::isHeadless() const noexcept
+        {
+            return this->surface_.isHeadless();
+        }
+
+        VkSurfaceCapabilitiesKHR Swapchain::getVkSurfaceCapabilitiesKHR() const noexcept
+        {
+            return this->surfaceCapabilities_;
+        }
+        
+        VkSurfaceFormatKHR Swapchain::getVkSurfaceFormatKHR() const noexcept
+        {
+            return this->surfaceFormat_;
+        }
+        
+        VkPresentModeKHR Swapchain::getVkPresentModeKHR() const noexcept
+        {
+            return this->presentMode_;
+        }
+        
+        VkExtent2D Swapchain::getVkExtent2D() const noexcept
+        {
+            return this->extent_;
+        }
+ 
+#pragma mark - mgo::vk::ImageViews
+        ImageViews::ImageViews(const Device& device, DeletionQueue& deletionQueue, const Swapchain& swapchain)
+        :
+        device_(device),
+        deletionQueue_(deletionQueue)
+        {
+            this->create(swapchain);
+        }
+        
+        ImageViews::~ImageViews() noexcept
+        {
+            this->destory();
+        }
+        
+        void ImageViews::create(const Swapchain& swapchain)
+        {
+            this->images_ = swapchain.getImages();
+            this->format_ = swapchain.getVkSurfaceFormatKHR().format;
+            this->imageViews_.resize(this->images_.size());
+            
+            for (std::size_t i = 0; i < this->images_.size(); i++)
+                this->imageViews_[i] = this->createImageView(this->images_[i]);
+        }
+        
+        VkImageView ImageViews::createImageView(VkImage image) const
+        {
+            VkImageView imageView;
+            
+            VkImageViewCreateInfo imageViewCreateInfo{};
+            imageViewCreateInfo.sType                            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            imageViewCreateInfo.pNext                            = nullptr;
+            imageViewCreateInfo.flags                            = 0;
+            imageViewCreateInfo.image                            = image;
+            imageViewCreateInfo.viewType                         = VK_IMAGE_VIEW_TYPE_2D;
+            imageViewCreateInfo.format                           = this->format_;
+            imageViewCreateInfo.components.r                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.components.g                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.components.b                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.components.a                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.subresourceRange.aspectMask      = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageViewCreateInfo.subresourceRange.baseMipLevel    = 0;
+            imageViewCreateInfo.subresourceRange.levelCount      = 1;
+            imageViewCreateInfo.subresourceRange.baseArrayLayer  = 0;
+            imageViewCreateInfo.subresourceRange.layerCount      = 1;
+            
+            if (vkCreateImageView(this->device_.get(), &imageViewCreateInfo, nullptr, &imageView) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::ImageViews!");
+            return imageView;
+        }
+        
+        void ImageViews::destory()
+        {
+            for (auto& imageView : this->imageViews_)
+                vkDestroyImageView(this->device_.get(), imageView, nullptr);
+        }
+        
+        void ImageViews::recreate(const Swapchain& swapchain, std::uint64_t retireFrame)
+        {
+            // A new swapchain hands out new images, so every view is retired and rebuilt.
+            for (VkImageView imageView : this->imageViews_)
+                this->deletionQueue_.push([&device = this->device_, imageView]()
+                {
+                    vkDestroyImageView(device.get(), imageView, nullptr);
+                }, retireFrame);
+            
+            this->imageViews_.clear();
+            this->create(swapchain);
+        }
+        
+        const std::vector<VkImageView>& ImageViews::get() const noexcept
+        {
+            return this->imageViews_;
+        }
+        
+        std::size_t ImageViews::size() const noexcept
+        {
+            return this->imageViews_.size();
+        }
+        
+#pragma mark - mgo::vk::RenderPass
+        RenderPass::RenderPass(const Device& device, const Swapchain& swapchain)
+        :
+        RenderPass(device, getRenderPassDescription(swapchain))
+        {}
+        
+        RenderPass::RenderPass(const Device& device, const RenderPassDescription& renderPassDescription)
+        :
+        device_(device)
+        {
+            std::vector<VkAttachmentDescription> attachmentDescriptions = renderPassDescription.colorAttachments_;
+            std::vector<VkAttachmentReference> colorAttachmentReferences;
+            for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(renderPassDescription.colorAttachments_.size()); i++)
+                colorAttachmentReferences.push_back({i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+            
+            VkAttachmentReference depthAttachmentReference{};
+            if (renderPassDescription.depthAttachment_.has_value())
+            {
+                depthAttachmentReference.attachment = static_cast<std::uint32_t>(attachmentDescriptions.size());
+                depthAttachmentReference.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                attachmentDescriptions.push_back(renderPassDescription.depthAttachment_.value());
+            }
+            
+            std::vector<VkSubpassDescription> subpassDescriptions = {this->getVkSubpassDescription(colorAttachmentReferences,
+                                                                                                   renderPassDescription.depthAttachment_.has_value() ? &depthAttachmentReference : nullptr)};
+            
+            VkRenderPassCreateInfo renderPassCreateInfo{};
+            renderPassCreateInfo.sType              = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            renderPassCreateInfo.pNext              = nullptr;
+            renderPassCreateInfo.flags              = 0;
+            renderPassCreateInfo.attachmentCount    = static_cast<std::uint32_t>(attachmentDescriptions.size());
+            renderPassCreateInfo.pAttachments       = attachmentDescriptions.data();
+            renderPassCreateInfo.subpassCount       = static_cast<std::uint32_t>(subpassDescriptions.size());
+            renderPassCreateInfo.pSubpasses         = subpassDescriptions.data();
+            renderPassCreateInfo.dependencyCount    = 0;
+            renderPassCreateInfo.pDependencies      = nullptr;
+            
+            if (vkCreateRenderPass(this->device_.get(), &renderPassCreateInfo, nullptr, &this->renderPass_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::RenderPass!");
+        }
+        
+        RenderPass::~RenderPass() noexcept
+        {
+            vkDestroyRenderPass(this->device_.get(), this->renderPass_, nullptr);
+        }
+        
+        const VkRenderPass& RenderPass::get() const noexcept
+        {
+            return this->renderPass_;
+        }
+        
+        RenderPassDescription RenderPass::getRenderPassDescription(const Swapchain& swapchain) noexcept
+        {
+            VkAttachmentDescription attachmentDescription{};
+            attachmentDescription.flags           = 0;
+            attachmentDescription.format          = swapchain.getVkSurfaceFormatKHR().format;
+            attachmentDescription.samples         = VK_SAMPLE_COUNT_1_BIT;
+            attachmentDescription.loadOp          = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachmentDescription.storeOp         = VK_ATTACHMENT_STORE_OP_STORE;
+            attachmentDescription.stencilLoadOp   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachmentDescription.stencilStoreOp  = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachmentDescription.initialLayout   = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachmentDescription.finalLayout     = swapchain.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            
+            RenderPassDescription renderPassDescription{};
+            renderPassDescription.colorAttachments_ = {attachmentDescription};
+            return renderPassDescription;
+        }
+        
+        VkSubpassDescription RenderPass::getVkSubpassDescription(const std::vector<VkAttachmentReference>& colorAttachmentReferences,
+                                                                 const VkAttachmentReference* pDepthAttachmentReference) const noexcept
+        {
+            VkSubpassDescription subpassDescription{};
+            subpassDescription.flags                    = 0;
+            subpassDescription.pipelineBindPoint        = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpassDescription.inputAttachmentCount     = 0;
+            subpassDescription.pInputAttachments        = nullptr;
+            subpassDescription.colorAttachmentCount     = static_cast<std::uint32_t>(colorAttachmentReferences.size());
+            subpassDescription.pColorAttachments        = colorAttachmentReferences.data();
+            subpassDescription.pResolveAttachments      = nullptr;
+            subpassDescription.pDepthStencilAttachment  = pDepthAttachmentReference;
+            subpassDescription.preserveAttachmentCount  = 0;
+            subpassDescription.pPreserveAttachments     = nullptr;
+            return subpassDescription;
+        }
+        
+#pragma mark - mgo::vk::Framebuffers
+        Framebuffers::Framebuffers(const Device& device, DeletionQueue& deletionQueue, const RenderPass& renderPass, const std::vector<std::vector<VkImageView>>& attachments, VkExtent2D extent)
+        :
+        attachments_(attachments),
+        extent_(extent),
+        device_(device),
+        deletionQueue_(deletionQueue),
+        renderPass_(renderPass)
+        {
+            for (const std::vector<VkImageView>& framebufferAttachments : this->attachments_)
+                this->framebuffers_.push_back(this->createFramebuffer(framebufferAttachments));
+        }
+        
+        Framebuffers::~Framebuffers() noexcept
+        {
+            this->destory();
+        }
+        
+        VkFramebuffer Framebuffers::createFramebuffer(const std::vector<VkImageView>& attachments) const
+        {
+            VkFramebuffer framebuffer;
+            
+            VkFramebufferCreateInfo framebufferCreateInfo{};
+            framebufferCreateInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferCreateInfo.pNext           = nullptr;
+            framebufferCreateInfo.flags           = 0;
+            framebufferCreateInfo.renderPass      = this->renderPass_.get();
+            framebufferCreateInfo.attachmentCount = static_cast<std::uint32_t>(attachments.size());
+            framebufferCreateInfo.pAttachments    = attachments.data();
+            framebufferCreateInfo.width           = this->extent_.width;
+            framebufferCreateInfo.height          = this->extent_.height;
+            framebufferCreateInfo.layers          = 1;
+            
+            if (vkCreateFramebuffer(this->device_.get(), &framebufferCreateInfo, nullptr, &framebuffer) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::Framebuffers!");
+            return framebuffer;
+        }
+        
+        void Framebuffers::destory()
+        {
+            for (auto& framebuffer : this->framebuffers_)
+                vkDestroyFramebuffer(this->device_.get(), framebuffer, nullptr);
+        }
+        
+        void Framebuffers::recreate(const std::vector<std::vector<VkImageView>>& attachments, VkExtent2D extent, std::uint64_t retireFrame)
+        {
+            const bool extentChanged = this->extent_.width != extent.width || this->extent_.height != extent.height;
+            this->extent_ = extent;
+            
+            // Framebuffers whose attachments and extent survived recreation are kept as they are.
+            std::vector<VkFramebuffer> framebuffers(attachments.size(), VK_NULL_HANDLE);
+            for (std::size_t i = 0; i < attachments.size(); i++)
+                if (!extentChanged && i < this->attachments_.size() && this->attachments_[i] == attachments[i])
+                    std::swap(framebuffers[i], this->framebuffers_[i]);
+                else
+                    framebuffers[i] = this->createFramebuffer(attachments[i]);
+            
+            for (VkFramebuffer framebuffer : this->framebuffers_)
+                if (framebuffer != VK_NULL_HANDLE)
+                    this->deletionQueue_.push([&device = this->device_, framebuffer]()
+                    {
+                        vkDestroyFramebuffer(device.get(), framebuffer, nullptr);
+                    }, retireFrame);
+            
+            this->attachments_ = attachments;
+            this->framebuffers_ = std::move(framebuffers);
+        }
+        
+        const std::vector<VkFramebuffer>& Framebuffers::get() const noexcept
+        {
+            return this->framebuffers_;
+        }
+        
+        std::size_t Framebuffers::size() const noexcept
+        {
+            return this->framebuffers_.size();
+        }
+        
+        
+#pragma mark - mgo::vk::TransientAttachmentPool
+        TransientAttachmentPool::TransientAttachmentPool(const PhysicalDevice& physicalDevice,
+                                                         const Device& device,
+                                                         MemoryAllocator& memoryAllocator,
+                                                         DeletionQueue& deletionQueue,
+                                                         const Swapchain& swapchain)
+        :
+        statistics_{},
+        physicalDevice_(physicalDevice),
+        device_(device),
+        memoryAllocator_(memoryAllocator),
+        deletionQueue_(deletionQueue),
+        swapchain_(swapchain)
+        {}
+        
+        TransientAttachmentPool::~TransientAttachmentPool() noexcept
+        {
+            this->destory();
+        }
+        
+        TransientAttachmentPool::Handle TransientAttachmentPool::add(VkFormat format, VkExtent2D extent, VkImageUsageFlags usage, std::size_t firstUse, std::size_t lastUse)
+        {
+            TransientAttachment transientAttachment{};
+            transientAttachment.format_ = format;
+            transientAttachment.extent_ = extent;
+            transientAttachment.usage_ = usage;
+            transientAttachment.firstUse_ = firstUse;
+            transientAttachment.lastUse_ = lastUse;
+            this->transientAttachments_.emplace_back(std::move(transientAttachment));
+            return this->transientAttachments_.size() - 1;
+        }
+        
+        void TransientAttachmentPool::create()
+        {
+            // Attachments that never leave the render pass can live in lazily allocated, often tile-only, memory.
+            const std::uint32_t lazilyAllocatedMemoryTypeBits = this->getLazilyAllocatedMemoryTypeBits();
+            const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+            
+            for (TransientAttachment& transientAttachment : this->transientAttachments_)
+            {
+                transientAttachment.lazilyAllocated_ = lazilyAllocatedMemoryTypeBits != 0 && (transientAttachment.usage_ & ~attachmentUsage) == 0;
+                this->createImage(transientAttachment);
+                vkGetImageMemoryRequirements(this->device_.get(), transientAttachment.image_, &transientAttachment.memoryRequirements_);
+                transientAttachment.lazilyAllocated_ = transientAttachment.lazilyAllocated_ &&
+                                                       (transientAttachment.memoryRequirements_.memoryTypeBits & lazilyAllocatedMemoryTypeBits) != 0;
+            }
+            
+            this->statistics_ = {};
+            this->allocate(false);
+            this->allocate(true);
+            
+            for (TransientAttachment& transientAttachment : this->transientAttachments_)
+                this->createImageView(transientAttachment);
+        }
+        
+        void TransientAttachmentPool::createImage(TransientAttachment& transientAttachment) const
+        {
+            const VkExtent2D extent = transientAttachment.extent_.width == 0 || transientAttachment.extent_.height == 0 ? this->swapchain_.getVkExtent2D() : transientAttachment.extent_;
+            
+            VkImageCreateInfo imageCreateInfo{};
+            imageCreateInfo.sType                  = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageCreateInfo.pNext                  = nullptr;
+            imageCreateInfo.flags                  = 0;
+            imageCreateInfo.imageType              = VK_IMAGE_TYPE_2D;
+            imageCreateInfo.format                 = transientAttachment.format_;
+            imageCreateInfo.extent                 = {extent.width, extent.height, 1};
+            imageCreateInfo.mipLevels              = 1;
+            imageCreateInfo.arrayLayers            = 1;
+            imageCreateInfo.samples                = VK_SAMPLE_COUNT_1_BIT;
+            imageCreateInfo.tiling                 = VK_IMAGE_TILING_OPTIMAL;
+            imageCreateInfo.usage                  = transientAttachment.usage_ | (transientAttachment.lazilyAllocated_ ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+            imageCreateInfo.sharingMode            = VK_SHARING_MODE_EXCLUSIVE;
+            imageCreateInfo.queueFamilyIndexCount  = 0;
+            imageCreateInfo.pQueueFamilyIndices    = nullptr;
+            imageCreateInfo.initialLayout          = VK_IMAGE_LAYOUT_UNDEFINED;
+            
+            if (vkCreateImage(this->device_.get(), &imageCreateInfo, nullptr, &transientAttachment.image_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::TransientAttachmentPool image!");
+        }
+        
+        void TransientAttachmentPool::createImageView(TransientAttachment& transientAttachment) const
+        {
+            VkImageViewCreateInfo imageViewCreateInfo{};
+            imageViewCreateInfo.sType                            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            imageViewCreateInfo.pNext                            = nullptr;
+            imageViewCreateInfo.flags                            = 0;
+            imageViewCreateInfo.image                            = transientAttachment.image_;
+            imageViewCreateInfo.viewType                         = VK_IMAGE_VIEW_TYPE_2D;
+            imageViewCreateInfo.format                           = transientAttachment.format_;
+            imageViewCreateInfo.components.r                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.components.g                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.components.b                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.components.a                     = VK_COMPONENT_SWIZZLE_IDENTITY;
+            imageViewCreateInfo.subresourceRange.aspectMask      = getAspectMask(transientAttachment.format_);
+            imageViewCreateInfo.subresourceRange.baseMipLevel    = 0;
+            imageViewCreateInfo.subresourceRange.levelCount      = 1;
+            imageViewCreateInfo.subresourceRange.baseArrayLayer  = 0;
+            imageViewCreateInfo.subresourceRange.layerCount      = 1;
+            
+            if (vkCreateImageView(this->device_.get(), &imageViewCreateInfo, nullptr, &transientAttachment.imageView_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::TransientAttachmentPool image view!");
+        }
+        
+        void TransientAttachmentPool::allocate(bool lazilyAllocated)
+        {
+            std::vector<TransientAttachment*> transientAttachments;
+            for (TransientAttachment& transientAttachment : this->transientAttachments_)
+                if (transientAttachment.lazilyAllocated_ == lazilyAllocated)
+                    transientAttachments.push_back(&transientAttachment);
+            if (transientAttachments.empty())
+                return;
+            
+            std::stable_sort(transientAttachments.begin(), transientAttachments.end(), [](const TransientAttachment* pLhs, const TransientAttachment* pRhs)
+            {
+                return pLhs->memoryRequirements_.size > pRhs->memoryRequirements_.size;
+            });
+            
+            // Only attachments sharing a memory type can alias, the others get an allocation of their own.
+            std::vector<std::vector<TransientAttachment*>> aliasedGroups;
+            std::vector<std::uint32_t> aliasedGroupMemoryTypeBits;
+            for (TransientAttachment* pTransientAttachment : transientAttachments)
+            {
+                std::size_t group = 0;
+                while (group < aliasedGroups.size() && (aliasedGroupMemoryTypeBits[group] & pTransientAttachment->memoryRequirements_.memoryTypeBits) == 0)
+                    group++;
+                if (group == aliasedGroups.size())
+                {
+                    aliasedGroups.emplace_back();
+                    aliasedGroupMemoryTypeBits.push_back(UINT32_MAX);
+                }
+                aliasedGroups[group].push_back(pTransientAttachment);
+                aliasedGroupMemoryTypeBits[group] &= pTransientAttachment->memoryRequirements_.memoryTypeBits;
+            }
+            
+            for (const std::vector<TransientAttachment*>& aliasedGroup : aliasedGroups)
+                this->allocateAliased(aliasedGroup, lazilyAllocated);
+        }
+        
+        void TransientAttachmentPool::allocateAliased(const std::vector<TransientAttachment*>& transientAttachments, bool lazilyAllocated)
+        {
+            // Largest first, each attachment takes the lowest offset not used by one alive at the same time.
+            VkMemoryRequirements memoryRequirements{0, 1, UINT32_MAX};
+            for (std::size_t i = 0; i < transientAttachments.size(); i++)
+            {
+                TransientAttachment& transientAttachment = *transientAttachments[i];
+                transientAttachment.offset_ = 0;
+                for (bool moved = true; moved;)
+                {
+                    moved = false;
+                    for (std::size_t j = 0; j < i; j++)
+                    {
+                        const TransientAttachment& placed = *transientAttachments[j];
+                        if (transientAttachment.firstUse_ <= placed.lastUse_ && placed.firstUse_ <= transientAttachment.lastUse_ &&
+                            transientAttachment.offset_ < placed.offset_ + placed.memoryRequirements_.size &&
+                            placed.offset_ < transientAttachment.offset_ + transientAttachment.memoryRequirements_.size)
+                        {
+                            transientAttachment.offset_ = MemoryAllocator::alignUp(placed.offset_ + placed.memoryRequirements_.size, transientAttachment.memoryRequirements_.alignment);
+                            moved = true;
+                        }
+                    }
+                }
+                
+                memoryRequirements.size = std::max(memoryRequirements.size, transientAttachment.offset_ + transientAttachment.memoryRequirements_.size);
+                memoryRequirements.alignment = std::max(memoryRequirements.alignment, transientAttachment.memoryRequirements_.alignment);
+                memoryRequirements.memoryTypeBits &= transientAttachment.memoryRequirements_.memoryTypeBits;
+                this->statistics_.requiredBytes_ += transientAttachment.memoryRequirements_.size;
+            }
+            
+            const VkMemoryPropertyFlags memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | (lazilyAllocated ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : 0);
+            MemoryAllocator::Allocation allocation = this->memoryAllocator_.allocate(memoryRequirements, memoryPropertyFlags, MemoryAllocator::ResourceType::IMAGE);
+            this->allocations_.push_back(allocation);
+            (lazilyAllocated ? this->statistics_.lazilyAllocatedBytes_ : this->statistics_.allocatedBytes_) += memoryRequirements.size;
+            
+            for (const TransientAttachment* pTransientAttachment : transientAttachments)
+                if (vkBindImageMemory(this->device_.get(), pTransientAttachment->image_, allocation.memory_, allocation.offset_ + pTransientAttachment->offset_) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to bind mgo::vk::TransientAttachmentPool image memory!");
+        }
+        
+        std::uint32_t TransientAttachmentPool::getLazilyAllocatedMemoryTypeBits() const noexcept
+        {
+            VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties = this->physicalDevice_.getPhysicalDeviceMemoryProperties();
+            
+            std::uint32_t memoryTypeBits = 0;
+            for (std::uint32_t memoryTypeIndex = 0; memoryTypeIndex < physicalDeviceMemoryProperties.memoryTypeCount; memoryTypeIndex++)
+                if (physicalDeviceMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+                    memoryTypeBits |= 1u << memoryTypeIndex;
+            return memoryTypeBits;
+        }
+        
+        void TransientAttachmentPool::destory()
+        {
+            for (const TransientAttachment& transientAttachment : this->transientAttachments_)
+            {
+                vkDestroyImageView(this->device_.get(), transientAttachment.imageView_, nullptr);
+                vkDestroyImage(this->device_.get(), transientAttachment.image_, nullptr);
+            }
+            for (const MemoryAllocator::Allocation& allocation : this->allocations_)
+                this->memoryAllocator_.free(allocation);
+            this->allocations_.clear();
+        }
+        
+        void TransientAttachmentPool::recreate(std::uint64_t retireFrame)
+        {
+            // Images are destroyed before the memory they are bound to is freed.
+            std::vector<std::pair<VkImage, VkImageView>> images;
+            for (TransientAttachment& transientAttachment : this->transientAttachments_)
+            {
+                images.emplace_back(transientAttachment.image_, transientAttachment.imageView_);
+                transientAttachment.imageView_ = VK_NULL_HANDLE;
+                transientAttachment.image_ = VK_NULL_HANDLE;
+            }
+            this->deletionQueue_.push([&device = this->device_, &memoryAllocator = this->memoryAllocator_, images, allocations = this->allocations_]()
+            {
+                for (const std::pair<VkImage, VkImageView>& image : images)
+                {
+                    vkDestroyImageView(device.get(), image.second, nullptr);
+                    vkDestroyImage(device.get(), image.first, nullptr);
+                }
+                for (const MemoryAllocator::Allocation& allocation : allocations)
+                    memoryAllocator.free(allocation);
+            }, retireFrame);
+            this->allocations_.clear();
+            
+            this->create();
+        }
+        
+        VkImage TransientAttachmentPool::getImage(Handle handle) const noexcept
+        {
+            return this->transientAttachments_[handle].image_;
+        }
+        
+        VkImageView TransientAttachmentPool::getImageView(Handle handle) const noexcept
+        {
+            return this->transientAttachments_[handle].imageView_;
+        }
+        
+        bool TransientAttachmentPool::isLazilyAllocated(Handle handle) const noexcept
+        {
+            return this->transientAttachments_[handle].lazilyAllocated_;
+        }
+        
+        std::vector<TransientAttachmentPool::Handle> TransientAttachmentPool::getAliases(Handle handle) const
+        {
+            const TransientAttachment& transientAttachment = this->transientAttachments_[handle];
+            
+            std::vector<Handle> aliases;
+            for (Handle other = 0; other < this->transientAttachments_.size(); other++)
+            {
+                const TransientAttachment& otherAttachment = this->transientAttachments_[other];
+                if (other != handle &&
+                    otherAttachment.lazilyAllocated_ == transientAttachment.lazilyAllocated_ &&
+                    otherAttachment.offset_ < transientAttachment.offset_ + transientAttachment.memoryRequirements_.size &&
+                    transientAttachment.offset_ < otherAttachment.offset_ + otherAttachment.memoryRequirements_.size)
+                    aliases.push_back(other);
+            }
+            return aliases;
+        }
+        
+        TransientAttachmentPool::Statistics TransientAttachmentPool::getStatistics() const noexcept
+        {
+            return this->statistics_;
+        }
+        
+        std::size_t TransientAttachmentPool::size() const noexcept
+        {
+            return this->transientAttachments_.size();
+        }
+        
+        VkImageAspectFlags TransientAttachmentPool::getAspectMask(VkFormat format) noexcept
+        {
+            switch (format)
+            {
+                case (VK_FORMAT_D16_UNORM) :
+                case (VK_FORMAT_X8_D24_UNORM_PACK32) :
+                case (VK_FORMAT_D32_SFLOAT) :
+                {
+                    return VK_IMAGE_ASPECT_DEPTH_BIT;
+                };
+                case (VK_FORMAT_D16_UNORM_S8_UINT) :
+                case (VK_FORMAT_D24_UNORM_S8_UINT) :
+                case (VK_FORMAT_D32_SFLOAT_S8_UINT) :
+                {
+                    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                };
+                case (VK_FORMAT_S8_UINT) :
+                {
+                    return VK_IMAGE_ASPECT_STENCIL_BIT;
+                };
+                default :
+                {
+                    return VK_IMAGE_ASPECT_COLOR_BIT;
+                };
+            }
+        }
+        
+#pragma mark - mgo::vk::BindlessDescriptors
+        BindlessDescriptors::BindlessDescriptors(const PhysicalDevice& physicalDevice, const Device& device, DeletionQueue& deletionQueue)
+        :
+        nextHandles_{},
+        freeHandles_(std::make_shared<FreeHandles>()),
+        device_(device),
+        deletionQueue_(deletionQueue)
+        {
+            // An update-after-bind set counts against the update-after-bind limits, which also cover every other set of
+            // the pipeline layout, so the arrays leave room for the per-frame set visible to the same stages.
+            VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties = physicalDevice.getDescriptorIndexingProperties();
+            this->capacities_[static_cast<std::size_t>(Binding::SAMPLED_IMAGES)] = std::min({DEFAULT_SAMPLED_IMAGE_COUNT,
+                                                                                            descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                                                                            descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSampledImages});
+            this->capacities_[static_cast<std::size_t>(Binding::SAMPLERS)] = std::min({DEFAULT_SAMPLER_COUNT,
+                                                                                      descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                                                                                      descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSamplers});
+            this->capacities_[static_cast<std::size_t>(Binding::STORAGE_BUFFERS)] = std::min({DEFAULT_STORAGE_BUFFER_COUNT,
+                                                                                             descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                                                                                             descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers}) -
+                                                                                   RESERVED_STORAGE_BUFFER_COUNT;
+            
+            this->createDescriptorSetLayout();
+            try
+            {
+                this->createDescriptorPool();
+                this->allocateDescriptorSet();
+            }
+            catch (...)
+            {
+                if (this->descriptorPool_ != VK_NULL_HANDLE)
+                    vkDestroyDescriptorPool(this->device_.get(), this->descriptorPool_, nullptr);
+                vkDestroyDescriptorSetLayout(this->device_.get(), this->descriptorSetLayout_, nullptr);
+                throw;
+            }
+        }
+        
+        BindlessDescriptors::~BindlessDescriptors() noexcept
+        {
+            vkDestroyDescriptorPool(this->device_.get(), this->descriptorPool_, nullptr);
+            vkDestroyDescriptorSetLayout(this->device_.get(), this->descriptorSetLayout_, nullptr);
+        }
+        
+        void BindlessDescriptors::createDescriptorSetLayout()
+        {
+            std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> descriptorSetLayoutBindings{};
+            std::array<VkDescriptorBindingFlags, BINDING_COUNT> descriptorBindingFlags{};
+            for (std::size_t i = 0; i < BINDING_COUNT; i++)
+            {
+                descriptorSetLayoutBindings[i].binding              = static_cast<std::uint32_t>(i);
+                descriptorSetLayoutBindings[i].descriptorType       = getVkDescriptorType(static_cast<Binding>(i));
+                descriptorSetLayoutBindings[i].descriptorCount      = this->capacities_[i];
+                descriptorSetLayoutBindings[i].stageFlags           = VK_SHADER_STAGE_ALL;
+                descriptorSetLayoutBindings[i].pImmutableSamplers   = nullptr;
+                
+                // Unwritten slots may stay empty, and free slots may be rewritten while frames using other slots are in flight.
+                descriptorBindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+            }
+            
+            VkDescriptorSetLayoutBindingFlagsCreateInfo descriptorSetLayoutBindingFlagsCreateInfo{};
+            descriptorSetLayoutBindingFlagsCreateInfo.sType           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+            descriptorSetLayoutBindingFlagsCreateInfo.pNext           = nullptr;
+            descriptorSetLayoutBindingFlagsCreateInfo.bindingCount    = static_cast<std::uint32_t>(descriptorBindingFlags.size());
+            descriptorSetLayoutBindingFlagsCreateInfo.pBindingFlags   = descriptorBindingFlags.data();
+            
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+            descriptorSetLayoutCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            descriptorSetLayoutCreateInfo.pNext         = &descriptorSetLayoutBindingFlagsCreateInfo;
+            descriptorSetLayoutCreateInfo.flags         = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+            descriptorSetLayoutCreateInfo.bindingCount  = static_cast<std::uint32_t>(descriptorSetLayoutBindings.size());
+            descriptorSetLayoutCreateInfo.pBindings     = descriptorSetLayoutBindings.data();
+            
+            if (vkCreateDescriptorSetLayout(this->device_.get(), &descriptorSetLayoutCreateInfo, nullptr, &this->descriptorSetLayout_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::BindlessDescriptors layout!");
+        }
+        
+        void BindlessDescriptors::createDescriptorPool()
+        {
+            this->descriptorPool_ = VK_NULL_HANDLE;
+            
+            std::array<VkDescriptorPoolSize, BINDING_COUNT> descriptorPoolSizes{};
+            for (std::size_t i = 0; i < BINDING_COUNT; i++)
+            {
+                descriptorPoolSizes[i].type             = getVkDescriptorType(static_cast<Binding>(i));
+                descriptorPoolSizes[i].descriptorCount  = this->capacities_[i];
+            }
+            
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType          = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.pNext          = nullptr;
+            descriptorPoolCreateInfo.flags          = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+            descriptorPoolCreateInfo.maxSets        = 1;
+            descriptorPoolCreateInfo.poolSizeCount  = static_cast<std::uint32_t>(descriptorPoolSizes.size());
+            descriptorPoolCreateInfo.pPoolSizes     = descriptorPoolSizes.data();
+            
+            if (vkCreateDescriptorPool(this->device_.get(), &descriptorPoolCreateInfo, nullptr, &this->descriptorPool_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::BindlessDescriptors pool!");
+        }
+        
+        void BindlessDescriptors::allocateDescriptorSet()
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType                 = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.pNext                 = nullptr;
+            descriptorSetAllocateInfo.descriptorPool        = this->descriptorPool_;
+            descriptorSetAllocateInfo.descriptorSetCount    = 1;
+            descriptorSetAllocateInfo.pSetLayouts           = &this->descriptorSetLayout_;
+            
+            if (vkAllocateDescriptorSets(this->device_.get(), &descriptorSetAllocateInfo, &this->descriptorSet_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to allocate mgo::vk::BindlessDescriptors set!");
+        }
+        
+        BindlessDescriptors::Handle BindlessDescriptors::allocateHandle(Binding binding)
+        {
+            const std::size_t bindingIndex = static_cast<std::size_t>(binding);
+            {
+                std::lock_guard<std::mutex> lock(this->freeHandles_->mutex_);
+                std::vector<Handle>& freeHandles = this->freeHandles_->handles_[bindingIndex];
+                if (!freeHandles.empty())
+                {
+                    Handle handle = freeHandles.back();
+                    freeHandles.pop_back();
+                    return handle;
+                }
+            }
+            
+            if (this->nextHandles_[bindingIndex] >= this->capacities_[bindingIndex])
+                throw std::runtime_error("Failed to allocate mgo::vk::BindlessDescriptors handle!");
+            return this->nextHandles_[bindingIndex]++;
+        }
+        
+        void BindlessDescriptors::write(Binding binding, Handle handle, const VkDescriptorImageInfo* pImageInfo, const VkDescriptorBufferInfo* pBufferInfo) noexcept
+        {
+            VkWriteDescriptorSet writeDescriptorSet{};
+            writeDescriptorSet.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet.pNext            = nullptr;
+            writeDescriptorSet.dstSet           = this->descriptorSet_;
+            writeDescriptorSet.dstBinding       = static_cast<std::uint32_t>(binding);
+            writeDescriptorSet.dstArrayElement  = handle;
+            writeDescriptorSet.descriptorCount  = 1;
+            writeDescriptorSet.descriptorType   = getVkDescriptorType(binding);
+            writeDescriptorSet.pImageInfo       = pImageInfo;
+            writeDescriptorSet.pBufferInfo      = pBufferInfo;
+            writeDescriptorSet.pTexelBufferView = nullptr;
+            
+            vkUpdateDescriptorSets(this->device_.get(), 1, &writeDescriptorSet, 0, nullptr);
+        }
+        
+        VkDescriptorType BindlessDescriptors::getVkDescriptorType(Binding binding) noexcept
+        {
+            switch (binding)
+            {
+                case (Binding::SAMPLED_IMAGES)  : return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                case (Binding::SAMPLERS)        : return VK_DESCRIPTOR_TYPE_SAMPLER;
+                case (Binding::STORAGE_BUFFERS) : return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            };
+            return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        
+        BindlessDescriptors::Handle BindlessDescriptors::addSampledImage(VkImageView imageView, VkImageLayout imageLayout)
+        {
+            VkDescriptorImageInfo descriptorImageInfo{};
+            descriptorImageInfo.sampler     = VK_NULL_HANDLE;
+            descriptorImageInfo.imageView   = imageView;
+            descriptorImageInfo.imageLayout = imageLayout;
+            
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            Handle handle = this->allocateHandle(Binding::SAMPLED_IMAGES);
+            this->write(Binding::SAMPLED_IMAGES, handle, &descriptorImageInfo, nullptr);
+            return handle;
+        }
+        
+        BindlessDescriptors::Handle BindlessDescriptors::addSampler(VkSampler sampler)
+        {
+            VkDescriptorImageInfo descriptorImageInfo{};
+            descriptorImageInfo.sampler     = sampler;
+            descriptorImageInfo.imageView   = VK_NULL_HANDLE;
+            descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            Handle handle = this->allocateHandle(Binding::SAMPLERS);
+            this->write(Binding::SAMPLERS, handle, &descriptorImageInfo, nullptr);
+            return handle;
+        }
+        
+        BindlessDescriptors::Handle BindlessDescriptors::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+        {
+            VkDescriptorBufferInfo descriptorBufferInfo{};
+            descriptorBufferInfo.buffer = buffer;
+            descriptorBufferInfo.offset = offset;
+            descriptorBufferInfo.range  = range;
+            
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            Handle handle = this->allocateHandle(Binding::STORAGE_BUFFERS);
+            this->write(Binding::STORAGE_BUFFERS, handle, nullptr, &descriptorBufferInfo);
+            return handle;
+        }
+        
+        BindlessDescriptors::Handle BindlessDescriptors::addStorageBuffer(const Buffer& buffer)
+        {
+            return this->addStorageBuffer(buffer.get(), 0, buffer.size());
+        }
+        
+        void BindlessDescriptors::remove(Binding binding, Handle handle)
+        {
+            // Frames already submitted may still index the slot, so it only becomes reusable once they complete.
+            this->deletionQueue_.push([freeHandles = this->freeHandles_, binding, handle]()
+            {
+                std::lock_guard<std::mutex> lock(freeHandles->mutex_);
+                freeHandles->handles_[static_cast<std::size_t>(binding)].push_back(handle);
+            });
+        }
+        
+        std::uint32_t BindlessDescriptors::getCapacity(Binding binding) const noexcept
+        {
+            return this->capacities_[static_cast<std::size_t>(binding)];
+        }
+        
+        const VkDescriptorSetLayout& BindlessDescriptors::getLayout() const noexcept
+        {
+            return this->descriptorSetLayout_;
+        }
+        
+        const VkDescriptorSet& BindlessDescriptors::get() const noexcept
+        {
+            return this->descriptorSet_;
+        }
+        
+#pragma mark - mgo::vk::FrameAllocator
+        FrameAllocator::FrameAllocator(const PhysicalDevice& physicalDevice,
+                                       const Device& device,
+                                       MemoryAllocator& memoryAllocator,
+                                       const QueueTimelines& queueTimelines,
+                                       std::uint32_t framesInFlight,
+                                       VkDeviceSize capacity)
+        :
+        alignment_(getAlignment(physicalDevice)),
+        capacity_(MemoryAllocator::alignUp(capacity, this->alignment_)),
+        uniformRange_(std::min({MAX_UNIFORM_RANGE, static_cast<VkDeviceSize>(physicalDevice.getPhysicalDeviceProperties().limits.maxUniformBufferRange), this->capacity_})),
+        storageRange_(std::min(static_cast<VkDeviceSize>(physicalDevice.getPhysicalDeviceProperties().limits.maxStorageBufferRange), this->capacity_)),
+        // The tail leaves room for a full descriptor range past the last slice of the last region.
+        buffer_(device,
+                memoryAllocator,
+                this->capacity_ * std::max(framesInFlight, 1u) + std::max(this->uniformRange_, this->storageRange_),
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        descriptorPool_(VK_NULL_HANDLE),
+        regionValues_(std::max(framesInFlight, 1u), 0),
+        currentRegion_(0),
+        head_(0),
+        device_(device),
+        queueTimelines_(queueTimelines)
+        {
+            this->createDescriptorSetLayout();
+            try
+            {
+                this->createDescriptorPool();
+                this->allocateDescriptorSet();
+            }
+            catch (...)
+            {
+                if (this->descriptorPool_ != VK_NULL_HANDLE)
+                    vkDestroyDescriptorPool(this->device_.get(), this->descriptorPool_, nullptr);
+                vkDestroyDescriptorSetLayout(this->device_.get(), this->descriptorSetLayout_, nullptr);
+                throw;
+            }
+            this->writeDescriptorSet();
+        }
+        
+        FrameAllocator::~FrameAllocator() noexcept
+        {
+            vkDestroyDescriptorPool(this->device_.get(), this->descriptorPool_, nullptr);
+            vkDestroyDescriptorSetLayout(this->device_.get(), this->descriptorSetLayout_, nullptr);
+        }
+        
+        VkDeviceSize FrameAllocator::getAlignment(const PhysicalDevice& physicalDevice) noexcept
+        {
+            VkPhysicalDeviceLimits physicalDeviceLimits = physicalDevice.getPhysicalDeviceProperties().limits;
+            return std::max(physicalDeviceLimits.minUniformBufferOffsetAlignment, physicalDeviceLimits.minStorageBufferOffsetAlignment);
+        }
+        
+        void FrameAllocator::createDescriptorSetLayout()
+        {
+            std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> descriptorSetLayoutBindings{};
+            descriptorSetLayoutBindings[0].binding              = 0;
+            descriptorSetLayoutBindings[0].descriptorType       = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            descriptorSetLayoutBindings[0].descriptorCount      = 1;
+            descriptorSetLayoutBindings[0].stageFlags           = VK_SHADER_STAGE_ALL;
+            descriptorSetLayoutBindings[0].pImmutableSamplers   = nullptr;
+            
+            descriptorSetLayoutBindings[1].binding              = 1;
+            descriptorSetLayoutBindings[1].descriptorType       = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+            descriptorSetLayoutBindings[1].descriptorCount      = 1;
+            descriptorSetLayoutBindings[1].stageFlags           = VK_SHADER_STAGE_ALL;
+            descriptorSetLayoutBindings[1].pImmutableSamplers   = nullptr;
+            
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+            descriptorSetLayoutCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            descriptorSetLayoutCreateInfo.pNext         = nullptr;
+            descriptorSetLayoutCreateInfo.flags         = 0;
+            descriptorSetLayoutCreateInfo.bindingCount  = static_cast<std::uint32_t>(descriptorSetLayoutBindings.size());
+            descriptorSetLayoutCreateInfo.pBindings     = descriptorSetLayoutBindings.data();
+            
+            if (vkCreateDescriptorSetLayout(this->device_.get(), &descriptorSetLayoutCreateInfo, nullptr, &this->descriptorSetLayout_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::FrameAllocator layout!");
+        }
+        
+        void FrameAllocator::createDescriptorPool()
+        {
+            std::array<VkDescriptorPoolSize, BINDING_COUNT> descriptorPoolSizes{};
+            descriptorPoolSizes[0].type             = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            descriptorPoolSizes[0].descriptorCount  = 1;
+            descriptorPoolSizes[1].type             = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+            descriptorPoolSizes[1].descriptorCount  = 1;
+            
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType          = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.pNext          = nullptr;
+            descriptorPoolCreateInfo.flags          = 0;
+            descriptorPoolCreateInfo.maxSets        = 1;
+            descriptorPoolCreateInfo.poolSizeCount  = static_cast<std::uint32_t>(descriptorPoolSizes.size());
+            descriptorPoolCreateInfo.pPoolSizes     = descriptorPoolSizes.data();
+            
+            if (vkCreateDescriptorPool(this->device_.get(), &descriptorPoolCreateInfo, nullptr, &this->descriptorPool_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::FrameAllocator pool!");
+        }
+        
+        void FrameAllocator::allocateDescriptorSet()
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType                 = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.pNext                 = nullptr;
+            descriptorSetAllocateInfo.descriptorPool        = this->descriptorPool_;
+            descriptorSetAllocateInfo.descriptorSetCount    = 1;
+            descriptorSetAllocateInfo.pSetLayouts           = &this->descriptorSetLayout_;
+            
+            if (vkAllocateDescriptorSets(this->device_.get(), &descriptorSetAllocateInfo, &this->descriptorSet_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to allocate mgo::vk::FrameAllocator set!");
+        }
+        
+        void FrameAllocator::writeDescriptorSet() noexcept
+        {
+            // Both descriptors are written once; draws select their slice with dynamic offsets.
+            std::array<VkDescriptorBufferInfo, BINDING_COUNT> descriptorBufferInfos{};
+            descriptorBufferInfos[0].buffer = this->buffer_.get();
+            descriptorBufferInfos[0].offset = 0;
+            descriptorBufferInfos[0].range  = this->uniformRange_;
+            descriptorBufferInfos[1].buffer = this->buffer_.get();
+            descriptorBufferInfos[1].offset = 0;
+            descriptorBufferInfos[1].range  = this->storageRange_;
+            
+            std::array<VkWriteDescriptorSet, BINDING_COUNT> writeDescriptorSets{};
+            for (std::size_t i = 0; i < BINDING_COUNT; i++)
+            {
+                writeDescriptorSets[i].sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDescriptorSets[i].pNext            = nullptr;
+                writeDescriptorSets[i].dstSet           = this->descriptorSet_;
+                writeDescriptorSets[i].dstBinding       = static_cast<std::uint32_t>(i);
+                writeDescriptorSets[i].dstArrayElement  = 0;
+                writeDescriptorSets[i].descriptorCount  = 1;
+                writeDescriptorSets[i].descriptorType   = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+                writeDescriptorSets[i].pImageInfo       = nullptr;
+                writeDescriptorSets[i].pBufferInfo      = &descriptorBufferInfos[i];
+                writeDescriptorSets[i].pTexelBufferView = nullptr;
+            }
+            
+            vkUpdateDescriptorSets(this->device_.get(), static_cast<std::uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+        }
+        
+        FrameAllocator::Allocation FrameAllocator::allocate(VkDeviceSize size, Usage usage)
+        {
+            // Uniform and storage slices are read through descriptors of fixed range, vertex slices are bound directly.
+            const VkDeviceSize range = usage == Usage::UNIFORM ? this->uniformRange_ : usage == Usage::STORAGE ? this->storageRange_ : this->capacity_;
+            if (size > range)
+                throw std::runtime_error("Failed to allocate from mgo::vk::FrameAllocator: slice exceeds the descriptor range!");
+            
+            // Recording threads may allocate concurrently, so the bump is a single atomic add.
+            const VkDeviceSize alignedSize = MemoryAllocator::alignUp(size, this->alignment_);
+            const VkDeviceSize offset = this->head_.fetch_add(alignedSize);
+            if (offset + alignedSize > this->capacity_)
+                throw std::runtime_error("Failed to allocate from mgo::vk::FrameAllocator: frame capacity exhausted!");
+            
+            const VkDeviceSize bufferOffset = this->currentRegion_ * this->capacity_ + offset;
+            
+            Allocation allocation{};
+            allocation.pData_           = static_cast<std::uint8_t*>(this->buffer_.getMappedData()) + bufferOffset;
+            allocation.size_            = size;
+            allocation.dynamicOffset_   = static_cast<std::uint32_t>(bufferOffset);
+            return allocation;
+        }
+        
+        void FrameAllocator::endFrame(std::uint64_t submittedValue) noexcept
+        {
+            // The next region is reset only once the frame that last read it has completed. This blocks the render
+            // thread, but on the frame the next draw() waits for to reuse its command buffer slot, so it moves that
+            // wait earlier rather than adding one.
+            this->regionValues_[this->currentRegion_] = submittedValue;
+            this->currentRegion_ = (this->currentRegion_ + 1) % this->regionValues_.size();
+            this->queueTimelines_.wait(PhysicalDevice::QueueType::GRAPHICS, this->regionValues_[this->currentRegion_]);
+            this->head_ = 0;
+        }
+        
+        VkDeviceSize FrameAllocator::getUsedBytes() const noexcept
+        {
+            return std::min(this->head_.load(), this->capacity_);
+        }
+        
+        VkDeviceSize FrameAllocator::getCapacity() const noexcept
+        {
+            return this->capacity_;
+        }
+        
+        VkDeviceSize FrameAllocator::getUniformRange() const noexcept
+        {
+            return this->uniformRange_;
+        }
+        
+        const VkBuffer& FrameAllocator::getBuffer() const noexcept
+        {
+            return this->buffer_.get();
+        }
+        
+        const VkDescriptorSetLayout& FrameAllocator::getLayout() const noexcept
+        {
+            return this->descriptorSetLayout_;
+        }
+        
+        const VkDescriptorSet& FrameAllocator::get() const noexcept
+        {
+            return this->descriptorSet_;
+        }
+        
+#pragma mark - mgo::vk::PipelineLayout
+        PipelineLayout::PipelineLayout(const Device& device, const BindlessDescriptors& bindlessDescriptors, const FrameAllocator& frameAllocator)
+        :
+        device_(device),
+        bindlessDescriptors_(bindlessDescriptors),
+        frameAllocator_(frameAllocator)
+        {
+            std::array<VkDescriptorSetLayout, 2> descriptorSetLayouts = {this->bindlessDescriptors_.getLayout(), this->frameAllocator_.getLayout()};
+            
+            VkPushConstantRange pushConstantRange{};
+            pushConstantRange.stageFlags    = PUSH_CONSTANT_STAGES;
+            pushConstantRange.offset        = 0;
+            pushConstantRange.size          = PUSH_CONSTANT_SIZE;
+            
+            // Every pipeline shares the bindless set, indexed through push constants, and the per-frame set at dynamic offsets.
+            VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+            pipelineLayoutCreateInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pipelineLayoutCreateInfo.pNext                   = nullptr;
+            pipelineLayoutCreateInfo.flags                   = 0;
+            pipelineLayoutCreateInfo.setLayoutCount          = static_cast<std::uint32_t>(descriptorSetLayouts.size());
+            pipelineLayoutCreateInfo.pSetLayouts             = descriptorSetLayouts.data();
+            pipelineLayoutCreateInfo.pushConstantRangeCount  = 1;
+            pipelineLayoutCreateInfo.pPushConstantRanges     = &pushConstantRange;
+            
+            if (vkCreatePipelineLayout(this->device_.get(), &pipelineLayoutCreateInfo, nullptr, &this->pipelineLayout_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::PipelineLayout!");
+        }
+        
+        PipelineLayout::~PipelineLayout() noexcept
+        {
+            vkDestroyPipelineLayout(this->device_.get(), this->pipelineLayout_, nullptr);
+        }
+        
+        const VkPipelineLayout& PipelineLayout::get() const noexcept
+        {
+            return pipelineLayout_;
+        }
+        
+        void PipelineLayout::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint) const noexcept
+        {
+            vkCmdBindDescriptorSets(commandBuffer, pipelineBindPoint, this->pipelineLayout_, 0, 1, &this->bindlessDescriptors_.get(), 0, nullptr);
+        }
+        
+        void PipelineLayout::bindFrameData(VkCommandBuffer commandBuffer,
+                                           VkPipelineBindPoint pipelineBindPoint,
+                                           std::uint32_t uniformOffset,
+                                           std::uint32_t storageOffset) const noexcept
+        {
+            std::array<std::uint32_t, FrameAllocator::BINDING_COUNT> dynamicOffsets = {uniformOffset, storageOffset};
+            vkCmdBindDescriptorSets(commandBuffer,
+                                    pipelineBindPoint,
+                                    this->pipelineLayout_,
+                                    1,
+                                    1,
+                                    &this->frameAllocator_.get(),
+                                    static_cast<std::uint32_t>(dynamicOffsets.size()),
+                                    dynamicOffsets.data());
+        }
+        
+        void PipelineLayout::pushConstants(VkCommandBuffer commandBuffer, std::uint32_t offset, std::uint32_t size, const void* pValues) const noexcept
+        {
+            vkCmdPushConstants(commandBuffer, this->pipelineLayout_, PUSH_CONSTANT_STAGES, offset, size, pValues);
+        }
+        
+#pragma mark - mgo::vk::PipelineCache
+        PipelineCache::PipelineCache(const PhysicalDevice& physicalDevice, const Device& device, const std::filesystem::path& path)
+        :
+        path_(path),
+        physicalDevice_(physicalDevice),
+        device_(device)
+        {
+            std::vector<char> data = this->load();
+            
+            VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+            pipelineCacheCreateInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            pipelineCacheCreateInfo.pNext           = nullptr;
+            pipelineCacheCreateInfo.flags           = 0;
+            pipelineCacheCreateInfo.initialDataSize = data.size();
+            pipelineCacheCreateInfo.pInitialData    = data.empty() ? nullptr : data.data();
+            
+            if (vkCreatePipelineCache(this->device_.get(), &pipelineCacheCreateInfo, nullptr, &this->pipelineCache_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::PipelineCache!");
+        }
+        
+        PipelineCache::~PipelineCache() noexcept
+        {
+            try
+            {
+                this->save();
+            }
+            catch (const std::exception& errorMessage)
+            {
+                MGO_DEBUG_LOG_ERROR("mgo::vk::PipelineCache NOT saved: " << errorMessage.what());
+            }
+            vkDestroyPipelineCache(this->device_.get(), this->pipelineCache_, nullptr);
+        }
+        
+        const VkPipelineCache& PipelineCache::get() const noexcept
+        {
+            return this->pipelineCache_;
+        }
+        
+        void PipelineCache::save() const
+        {
+            std::size_t dataSize = 0;
+            vkGetPipelineCacheData(this->device_.get(), this->pipelineCache_, &dataSize, nullptr);
+            
+            std::vector<char> data(dataSize);
+            if (vkGetPipelineCacheData(this->device_.get(), this->pipelineCache_, &dataSize, data.data()) != VK_SUCCESS)
+                throw std::runtime_error("Failed to get mgo::vk::PipelineCache data!");
+            data.resize(dataSize);
+            
+            FileHeader fileHeader = this->getFileHeader(data);
+            
+            // Written next to the target and renamed over it, so a crash never leaves a torn cache behind.
+            std::filesystem::path temporaryPath = this->path_;
+            temporaryPath += ".tmp";
+            {
+                std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(FileHeader));
+                file.write(data.data(), static_cast<std::streamsize>(data.size()));
+                file.flush();
+                if (!file)
+                    throw std::runtime_error("Failed to write mgo::vk::PipelineCache!");
+            }
+            std::filesystem::rename(temporaryPath, this->path_);
+        }
+        
+        std::vector<char> PipelineCache::load() const noexcept
+        {
+            // A cache that cannot be read, including one too large to allocate, is treated as a miss.
+            try
+            {
+                std::ifstream file(this->path_, std::ios::binary | std::ios::ate);
+                if (!file.is_open())
+                    return {};
+                
+                std::streamsize fileSize = file.tellg();
+                if (fileSize < static_cast<std::streamsize>(sizeof(FileHeader)))
+                    return {};
+                
+                FileHeader fileHeader{};
+                file.seekg(0);
+                file.read(reinterpret_cast<char*>(&fileHeader), sizeof(FileHeader));
+                
+                std::vector<char> data(static_cast<std::size_t>(fileSize) - sizeof(FileHeader));
+                file.read(data.data(), static_cast<std::streamsize>(data.size()));
+                
+                if (!file || !this->checkFileHeader(fileHeader, data))
+                {
+                    MGO_DEBUG_LOG_MESSAGE("mgo::vk::PipelineCache discarded stale cache: " << this->path_.string());
+                    return {};
+                }
+                return data;
+            }
+            catch (const std::exception& errorMessage)
+            {
+                MGO_DEBUG_LOG_ERROR("mgo::vk::PipelineCache NOT loaded: " << errorMessage.what());
+                return {};
+            }
+        }
+        
+        PipelineCache::FileHeader PipelineCache::getFileHeader(const std::vector<char>& data) const noexcept
+        {
+            VkPhysicalDeviceProperties physicalDeviceProperties = this->physicalDevice_.getPhysicalDeviceProperties();
+            
+            FileHeader fileHeader{};
+            fileHeader.magic_           = FILE_MAGIC;
+            fileHeader.version_         = FILE_VERSION;
+            fileHeader.vendorID_        = physicalDeviceProperties.vendorID;
+            fileHeader.deviceID_        = physicalDeviceProperties.deviceID;
+            fileHeader.driverVersion_   = physicalDeviceProperties.driverVersion;
+            fileHeader.reserved_        = 0;
+            fileHeader.dataSize_        = data.size();
+            fileHeader.checksum_        = hashBytes(data.data(), data.size());
+            std::memcpy(fileHeader.pipelineCacheUUID_, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+            return fileHeader;
+        }
+        
+        bool PipelineCache::checkFileHeader(const FileHeader& fileHeader, const std::vector<char>& data) const noexcept
+        {
+            FileHeader expectedFileHeader = this->getFileHeader(data);
+            
+            if (fileHeader.magic_ != expectedFileHeader.magic_ ||
+                fileHeader.version_ != expectedFileHeader.version_ ||
+                fileHeader.vendorID_ != expectedFileHeader.vendorID_ ||
+                fileHeader.deviceID_ != expectedFileHeader.deviceID_ ||
+                fileHeader.driverVersion_ != expectedFileHeader.driverVersion_ ||
+                fileHeader.dataSize_ != expectedFileHeader.dataSize_ ||
+                fileHeader.checksum_ != expectedFileHeader.checksum_ ||
+                std::memcmp(fileHeader.pipelineCacheUUID_, expectedFileHeader.pipelineCacheUUID_, VK_UUID_SIZE) != 0)
+                return false;
+            
+            // The driver's own header must agree with ours before the blob is handed back to it.
+            VkPipelineCacheHeaderVersionOne pipelineCacheHeader{};
+            if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+                return false;
+            std::memcpy(&pipelineCacheHeader, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+            
+            return pipelineCacheHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                   pipelineCacheHeader.vendorID == fileHeader.vendorID_ &&
+                   pipelineCacheHeader.deviceID == fileHeader.deviceID_ &&
+                   std::memcmp(pipelineCacheHeader.pipelineCacheUUID, fileHeader.pipelineCacheUUID_, VK_UUID_SIZE) == 0;
+        }
+        
+#pragma mark - mgo::vk::ShaderLibrary::MappedFile
+        ShaderLibrary::MappedFile::MappedFile(const std::string& path)
+        :
+        pData_(MAP_FAILED),
+        size_(0)
+        {
+            int fileDescriptor = open(path.c_str(), O_RDONLY);
+            if (fileDescriptor < 0)
+                throw std::runtime_error("Failed to open shader: " + path);
+            
+            struct stat fileStatus{};
+            if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0)
+            {
+                this->size_ = static_cast<std::size_t>(fileStatus.st_size);
+                this->pData_ = mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            }
+            close(fileDescriptor);
+            
+            if (this->pData_ == MAP_FAILED)
+                throw std::runtime_error("Failed to map shader: " + path);
+        }
+        
+        ShaderLibrary::MappedFile::~MappedFile() noexcept
+        {
+            munmap(this->pData_, this->size_);
+        }
+        
+        const void* ShaderLibrary::MappedFile::data() const noexcept
+        {
+            return this->pData_;
+        }
+        
+        std::size_t ShaderLibrary::MappedFile::size() const noexcept
+        {
+            return this->size_;
+        }
+        
+#pragma mark - mgo::vk::ShaderLibrary
+        ShaderLibrary::ShaderLibrary(const Device& device)
+        :
+        device_(device)
+        {}
+        
+        ShaderLibrary::~ShaderLibrary() noexcept
+        {
+            for (auto& [contentHash, module] : this->modulesByContent_)
+                vkDestroyShaderModule(this->device_.get(), module.shaderModule_, nullptr);
+        }
+        
+        VkShaderModule ShaderLibrary::load(const std::string& path)
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                auto modulesByPathIterator = this->modulesByPath_.find(path);
+                if (modulesByPathIterator != this->modulesByPath_.end())
+                    return modulesByPathIterator->second;
+            }
+            
+            // Mapping, hashing and module creation run unlocked so concurrent pipeline builds load shaders in parallel.
+            std::shared_ptr<const MappedFile> pMappedFile = std::make_shared<const MappedFile>(path);
+            std::uint64_t contentHash = hashBytes(pMappedFile->data(), pMappedFile->size());
+            
+            {
+                // Identical SPIR-V reached through different paths shares one module.
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                if (VkShaderModule shaderModule = this->findModule(contentHash, *pMappedFile); shaderModule != VK_NULL_HANDLE)
+                {
+                    this->modulesByPath_.emplace(path, shaderModule);
+                    return shaderModule;
+                }
+            }
+            
+            VkShaderModule shaderModule = this->createShaderModule(path, *pMappedFile);
+            
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            // Another thread may have created the same module while this one was unlocked.
+            if (VkShaderModule existingShaderModule = this->findModule(contentHash, *pMappedFile); existingShaderModule != VK_NULL_HANDLE)
+            {
+                vkDestroyShaderModule(this->device_.get(), shaderModule, nullptr);
+                shaderModule = existingShaderModule;
+            }
+            else
+                this->modulesByContent_.emplace(contentHash, Module{std::move(pMappedFile), shaderModule});
+            
+            this->modulesByPath_.emplace(path, shaderModule);
+            return shaderModule;
+        }
+        
+        std::size_t ShaderLibrary::size() const noexcept
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            return this->modulesByContent_.size();
+        }
+        
+        VkShaderModule ShaderLibrary::createShaderModule(const std::string& path, const MappedFile& mappedFile) const
+        {
+            // Mappings are page aligned, so the words can be handed to the driver in place.
+            if (reinterpret_cast<std::uintptr_t>(mappedFile.data()) % alignof(std::uint32_t) != 0 ||
+                mappedFile.size() % sizeof(std::uint32_t) != 0 ||
+                mappedFile.size() < 5 * sizeof(std::uint32_t) ||
+                *static_cast<const std::uint32_t*>(mappedFile.data()) != SPIRV_MAGIC)
+                throw std::runtime_error("Invalid SPIR-V: " + path);
+            
+            VkShaderModule shaderModule;
+            
+            VkShaderModuleCreateInfo shaderModuleCreateInfo{};
+            shaderModuleCreateInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            shaderModuleCreateInfo.pNext    = nullptr;
+            shaderModuleCreateInfo.flags    = 0;
+            shaderModuleCreateInfo.codeSize = mappedFile.size();
+            shaderModuleCreateInfo.pCode    = static_cast<const std::uint32_t*>(mappedFile.data());
+            
+            if (vkCreateShaderModule(this->device_.get(), &shaderModuleCreateInfo, nullptr, &shaderModule) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::ShaderLibrary module: " + path);
+            return shaderModule;
+        }
+        
+        VkShaderModule ShaderLibrary::findModule(std::uint64_t contentHash, const MappedFile& mappedFile) const noexcept
+        {
+            // A hash hit only counts when the bytes match, so a collision can never hand out the wrong shader.
+            auto [first, last] = this->modulesByContent_.equal_range(contentHash);
+            for (auto modulesByContentIterator = first; modulesByContentIterator != last; modulesByContentIterator++)
+            {
+                const Module& module = modulesByContentIterator->second;
+                if (module.pMappedFile_->size() == mappedFile.size() && std::memcmp(module.pMappedFile_->data(), mappedFile.data(), mappedFile.size()) == 0)
+                    return module.shaderModule_;
+            }
+            return VK_NULL_HANDLE;
+        }
+        
+#pragma mark - mgo::vk::PipelineDescription
+        PipelineDescription PipelineDescription::getFallback() noexcept
+        {
+            PipelineDescription description;
+            description.optimize_ = false;
+            return description;
+        }
+        
+#pragma mark - mgo::vk::Pipeline
+        Pipeline::Pipeline(const Device& device,
+                           const RenderPass& renderPass,
+                           const PipelineLayout& pipelineLayout,
+                           const PipelineCache& pipelineCache,
+                           ShaderLibrary& shaderLibrary,
+                           const PipelineDescription& description)
+        :
+        device_(device),
+        renderPass_(renderPass),
+        pipelineLayout_(pipelineLayout),
+        pipelineCache_(pipelineCache),
+        shaderLibrary_(shaderLibrary),
+        description_(description)
+        {
+            VkPipelineShaderStageCreateInfo vertPipelineShaderStageCreateInfo =
+            this->getVkPipelineShaderStageCreateInfo(this->shaderLibrary_.load(this->description_.vertexShaderPath_), VK_SHADER_STAGE_VERTEX_BIT);
+            
+            VkPipelineShaderStageCreateInfo fragPipelineShaderStageCreateInfo =
+            this->getVkPipelineShaderStageCreateInfo(this->shaderLibrary_.load(this->description_.fragmentShaderPath_), VK_SHADER_STAGE_FRAGMENT_BIT);
+            
+            std::vector<VkPipelineShaderStageCreateInfo> stages = {vertPipelineShaderStageCreateInfo, fragPipelineShaderStageCreateInfo};
+            
+            std::vector<VkVertexInputBindingDescription> vertexBindings = Vertex::getVkVertexInputBindingDescriptions();
+            std::vector<VkVertexInputAttributeDescription> vertexAttributes = Vertex::getVkVertexInputAttributeDescriptions();
+            for (const auto& instanceBinding : InstanceData::getVkVertexInputBindingDescriptions())
+                vertexBindings.push_back(instanceBinding);
+            for (const auto& instanceAttribute : InstanceData::getVkVertexInputAttributeDescriptions())
+                vertexAttributes.push_back(instanceAttribute);
+            VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo =
+            this->getVkPipelineVertexInputStateCreateInfo(vertexBindings, vertexAttributes);
+            
+            VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo =
+            this->getVkPipelineInputAssemblyStateCreateInfo();
+            
+            VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo =
+            this->getVkPipelineViewportStateCreateInfo();
+            
+            VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo =
+            this->getVkPipelineRasterizationStateCreateInfo();
+            
+            VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo =
+            this->getVkPipelineMultisampleStateCreateInfo();
+            
+            std::vector<VkPipelineColorBlendAttachmentState> attachments = {this->getVkPipelineColorBlendAttachmentState()};
+            VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo =
+            this->getVkPipelineColorBlendStateCreateInfo(attachments);
+            
+            std::vector<VkDynamicState> dynamicStates ={VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+            VkPipelineDynamicStateCreateInfo pipelineDynamicStateCreateInfo =
+            this->getVkPipelineDynamicStateCreateInfo(dynamicStates);
+            
+            
+            VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
+            graphicsPipelineCreateInfo.sType                = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            graphicsPipelineCreateInfo.flags                = this->description_.optimize_ ? 0 : VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT;
             graphicsPipelineCreateInfo.stageCount           = static_cast<std::uint32_t>(stages.size());
             graphicsPipelineCreateInfo.pStages              = stages.data();
             graphicsPipelineCreateInfo.pVertexInputState    = &pipelineVertexInputStateCreateInfo;
@@ -1019,199 +3144,2080 @@ namespace mgo
             graphicsPipelineCreateInfo.subpass              = 0;
             graphicsPipelineCreateInfo.basePipelineHandle   = VK_NULL_HANDLE;
             
-            if (vkCreateGraphicsPipelines(this->device_.get(), VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &this->pipeline_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::Pipeline!");
+            if (vkCreateGraphicsPipelines(this->device_.get(), this->pipelineCache_.get(), 1, &graphicsPipelineCreateInfo, nullptr, &this->pipeline_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::Pipeline!");
+        }
+        
+        Pipeline::~Pipeline() noexcept
+        {
+            vkDestroyPipeline(this->device_.get(), this->pipeline_, nullptr);
+        }
+        
+        const VkPipeline& Pipeline::get() const noexcept
+        {
+            return this->pipeline_;
+        }
+        
+        VkPipelineShaderStageCreateInfo Pipeline::getVkPipelineShaderStageCreateInfo(VkShaderModule shaderModule,
+                                                                                     VkShaderStageFlagBits stage) const noexcept
+        {
+            VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
+            pipelineShaderStageCreateInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipelineShaderStageCreateInfo.pNext                   = nullptr;
+            pipelineShaderStageCreateInfo.flags                   = 0;
+            pipelineShaderStageCreateInfo.stage                   = stage;
+            pipelineShaderStageCreateInfo.module                  = shaderModule;
+            pipelineShaderStageCreateInfo.pName                   = "main";
+            pipelineShaderStageCreateInfo.pSpecializationInfo     = nullptr;
+            return pipelineShaderStageCreateInfo;
+        }
+        
+        VkPipelineVertexInputStateCreateInfo
+        Pipeline::getVkPipelineVertexInputStateCreateInfo(const std::vector<VkVertexInputBindingDescription>& bindings,
+                                                          const std::vector<VkVertexInputAttributeDescription>& attributes) const noexcept
+        {
+            VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{};
+            pipelineVertexInputStateCreateInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            pipelineVertexInputStateCreateInfo.pNext                           = nullptr;
+            pipelineVertexInputStateCreateInfo.flags                           = 0;
+            pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount   = static_cast<std::uint32_t>(bindings.size());
+            pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions      = bindings.data();
+            pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<std::uint32_t>(attributes.size());
+            pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions    = attributes.data();
+            return pipelineVertexInputStateCreateInfo;
+        }
+        
+        VkPipelineInputAssemblyStateCreateInfo Pipeline::getVkPipelineInputAssemblyStateCreateInfo() const noexcept
+        {
+            VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{};
+            pipelineInputAssemblyStateCreateInfo.sType                    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            pipelineInputAssemblyStateCreateInfo.pNext                    = nullptr;
+            pipelineInputAssemblyStateCreateInfo.flags                    = 0;
+            pipelineInputAssemblyStateCreateInfo.topology                 = this->description_.topology_;
+            pipelineInputAssemblyStateCreateInfo.primitiveRestartEnable   = VK_FALSE;
+            return pipelineInputAssemblyStateCreateInfo;
+        }
+        
+        VkPipelineViewportStateCreateInfo Pipeline::getVkPipelineViewportStateCreateInfo() const noexcept
+        {
+            VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo{};
+            pipelineViewportStateCreateInfo.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+            pipelineViewportStateCreateInfo.pNext         = nullptr;
+            pipelineViewportStateCreateInfo.flags         = 0;
+            pipelineViewportStateCreateInfo.viewportCount = 1;
+            pipelineViewportStateCreateInfo.pViewports    = nullptr;
+            pipelineViewportStateCreateInfo.scissorCount  = 1;
+            pipelineViewportStateCreateInfo.pScissors     = nullptr;
+            return pipelineViewportStateCreateInfo;
+        }
+        
+        VkPipelineRasterizationStateCreateInfo Pipeline::getVkPipelineRasterizationStateCreateInfo() const noexcept
+        {
+            VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo{};
+            pipelineRasterizationStateCreateInfo.sType                    = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            pipelineRasterizationStateCreateInfo.pNext                    = nullptr;
+            pipelineRasterizationStateCreateInfo.flags                    = 0;
+            pipelineRasterizationStateCreateInfo.depthClampEnable         = VK_FALSE;
+            pipelineRasterizationStateCreateInfo.rasterizerDiscardEnable  = VK_FALSE;
+            pipelineRasterizationStateCreateInfo.polygonMode              = this->description_.polygonMode_;
+            pipelineRasterizationStateCreateInfo.cullMode                 = this->description_.cullMode_;
+            pipelineRasterizationStateCreateInfo.frontFace                = VK_FRONT_FACE_CLOCKWISE;
+            pipelineRasterizationStateCreateInfo.depthBiasEnable          = VK_FALSE;
+            pipelineRasterizationStateCreateInfo.depthBiasConstantFactor  = 0.0f;
+            pipelineRasterizationStateCreateInfo.depthBiasClamp           = 0.0f;
+            pipelineRasterizationStateCreateInfo.depthBiasSlopeFactor     = 0.0f;
+            pipelineRasterizationStateCreateInfo.lineWidth                = 1.0f;
+            return pipelineRasterizationStateCreateInfo;
+        }
+        
+        VkPipelineMultisampleStateCreateInfo Pipeline::getVkPipelineMultisampleStateCreateInfo() const noexcept
+        {
+            VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo{};
+            pipelineMultisampleStateCreateInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+            pipelineMultisampleStateCreateInfo.pNext                  = nullptr;
+            pipelineMultisampleStateCreateInfo.flags                  = 0;
+            pipelineMultisampleStateCreateInfo.rasterizationSamples   = VK_SAMPLE_COUNT_1_BIT;
+            pipelineMultisampleStateCreateInfo.sampleShadingEnable    = VK_FALSE;
+            pipelineMultisampleStateCreateInfo.minSampleShading       = 0.0f;
+            pipelineMultisampleStateCreateInfo.pSampleMask            = nullptr;
+            pipelineMultisampleStateCreateInfo.alphaToCoverageEnable  = VK_FALSE;
+            pipelineMultisampleStateCreateInfo.alphaToOneEnable       = VK_FALSE;
+            return pipelineMultisampleStateCreateInfo;
+        }
+        
+        VkPipelineColorBlendAttachmentState Pipeline::getVkPipelineColorBlendAttachmentState() const noexcept
+        {
+            VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
+            pipelineColorBlendAttachmentState.blendEnable            = this->description_.blendEnable_ ? VK_TRUE : VK_FALSE;
+            pipelineColorBlendAttachmentState.srcColorBlendFactor    = this->description_.blendEnable_ ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+            pipelineColorBlendAttachmentState.dstColorBlendFactor    = this->description_.blendEnable_ ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+            pipelineColorBlendAttachmentState.colorBlendOp           = VK_BLEND_OP_ADD;
+            pipelineColorBlendAttachmentState.srcAlphaBlendFactor    = this->description_.blendEnable_ ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ZERO;
+            pipelineColorBlendAttachmentState.dstAlphaBlendFactor    = VK_BLEND_FACTOR_ZERO;
+            pipelineColorBlendAttachmentState.alphaBlendOp           = VK_BLEND_OP_ADD;
+            pipelineColorBlendAttachmentState.colorWriteMask         = this->description_.colorWriteMask_;
+            return pipelineColorBlendAttachmentState;
+        }
+        
+        VkPipelineColorBlendStateCreateInfo
+        Pipeline::getVkPipelineColorBlendStateCreateInfo(const std::vector<VkPipelineColorBlendAttachmentState>& attachments) const noexcept
+        {
+            VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{};
+            pipelineColorBlendStateCreateInfo.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            pipelineColorBlendStateCreateInfo.pNext             = nullptr;
+            pipelineColorBlendStateCreateInfo.flags             = 0;
+            pipelineColorBlendStateCreateInfo.logicOpEnable     = VK_FALSE;
+            pipelineColorBlendStateCreateInfo.logicOp           = VK_LOGIC_OP_COPY;
+            pipelineColorBlendStateCreateInfo.attachmentCount   = static_cast<std::uint32_t>(attachments.size());
+            pipelineColorBlendStateCreateInfo.pAttachments      = attachments.data();
+            pipelineColorBlendStateCreateInfo.blendConstants[0] = 0.0f;
+            pipelineColorBlendStateCreateInfo.blendConstants[1] = 0.0f;
+            pipelineColorBlendStateCreateInfo.blendConstants[2] = 0.0f;
+            pipelineColorBlendStateCreateInfo.blendConstants[3] = 0.0f;
+            return pipelineColorBlendStateCreateInfo;
+        }
+        
+        VkPipelineDynamicStateCreateInfo Pipeline::getVkPipelineDynamicStateCreateInfo(const std::vector<VkDynamicState>& dynamicStates) const noexcept
+        {
+            VkPipelineDynamicStateCreateInfo pipelineDynamicStateCreateInfo{};
+            pipelineDynamicStateCreateInfo.sType              = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            pipelineDynamicStateCreateInfo.pNext              = nullptr;
+            pipelineDynamicStateCreateInfo.flags              = 0;
+            pipelineDynamicStateCreateInfo.dynamicStateCount  = static_cast<std::uint32_t>(dynamicStates.size());
+            pipelineDynamicStateCreateInfo.pDynamicStates     = dynamicStates.data();
+            return pipelineDynamicStateCreateInfo;
+        }
+        
+#pragma mark - mgo::vk::ComputePipeline
+        ComputePipeline::ComputePipeline(const Device& device,
+                                         const PipelineLayout& pipelineLayout,
+                                         const PipelineCache& pipelineCache,
+                                         ShaderLibrary& shaderLibrary,
+                                         const std::string& shaderPath)
+        :
+        device_(device),
+        pipelineLayout_(pipelineLayout)
+        {
+            VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
+            pipelineShaderStageCreateInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipelineShaderStageCreateInfo.pNext                   = nullptr;
+            pipelineShaderStageCreateInfo.flags                   = 0;
+            pipelineShaderStageCreateInfo.stage                   = VK_SHADER_STAGE_COMPUTE_BIT;
+            pipelineShaderStageCreateInfo.module                  = shaderLibrary.load(shaderPath);
+            pipelineShaderStageCreateInfo.pName                   = "main";
+            pipelineShaderStageCreateInfo.pSpecializationInfo     = nullptr;
+            
+            VkComputePipelineCreateInfo computePipelineCreateInfo{};
+            computePipelineCreateInfo.sType                 = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            computePipelineCreateInfo.pNext                 = nullptr;
+            computePipelineCreateInfo.flags                 = 0;
+            computePipelineCreateInfo.stage                 = pipelineShaderStageCreateInfo;
+            computePipelineCreateInfo.layout                = this->pipelineLayout_.get();
+            computePipelineCreateInfo.basePipelineHandle    = VK_NULL_HANDLE;
+            computePipelineCreateInfo.basePipelineIndex     = -1;
+            
+            if (vkCreateComputePipelines(this->device_.get(), pipelineCache.get(), 1, &computePipelineCreateInfo, nullptr, &this->pipeline_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::ComputePipeline!");
+        }
+        
+        ComputePipeline::~ComputePipeline() noexcept
+        {
+            vkDestroyPipeline(this->device_.get(), this->pipeline_, nullptr);
+        }
+        
+        const VkPipeline& ComputePipeline::get() const noexcept
+        {
+            return this->pipeline_;
+        }
+        
+        void ComputePipeline::bind(VkCommandBuffer commandBuffer) const noexcept
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline_);
+            this->pipelineLayout_.bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+        }
+        
+#pragma mark - mgo::vk::PipelineBuilder
+        PipelineBuilder::PipelineBuilder(const Device& device,
+                                         const RenderPass& renderPass,
+                                         const PipelineLayout& pipelineLayout,
+                                         const PipelineCache& pipelineCache,
+                                         ShaderLibrary& shaderLibrary)
+        :
+        device_(device),
+        renderPass_(renderPass),
+        pipelineLayout_(pipelineLayout),
+        pipelineCache_(pipelineCache),
+        shaderLibrary_(shaderLibrary)
+        {}
+        
+        PipelineBuilder::~PipelineBuilder() noexcept
+        {
+            // Queued builds reference this builder, so they finish before it goes away.
+            jobs::Scheduler::get().wait(this->counter_);
+        }
+        
+        PipelineBuilder::Future PipelineBuilder::build(const PipelineDescription& description)
+        {
+            // Builds run on the shared job scheduler, so compilation uses the same cores as recording and sorting.
+            auto pTask = std::make_shared<std::packaged_task<std::shared_ptr<Pipeline>()>>([this, description]()
+            {
+                return std::make_shared<Pipeline>(this->device_,
+                                                  this->renderPass_,
+                                                  this->pipelineLayout_,
+                                                  this->pipelineCache_,
+                                                  this->shaderLibrary_,
+                                                  description);
+            });
+            Future future = pTask->get_future().share();
+            jobs::Scheduler::get().run([pTask]()
+            {
+                // Build failures are stored in the future rather than thrown here.
+                trace::Scope scope("PipelineBuilder::build");
+                (*pTask)();
+            }, &this->counter_);
+            return future;
+        }
+        
+        std::vector<PipelineBuilder::Future> PipelineBuilder::build(const std::vector<PipelineDescription>& descriptions)
+        {
+            std::vector<Future> futures;
+            futures.reserve(descriptions.size());
+            for (const auto& description : descriptions)
+                futures.emplace_back(this->build(description));
+            return futures;
+        }
+        
+#pragma mark - mgo::vk::AsyncPipeline
+        AsyncPipeline::AsyncPipeline(const PipelineBuilder::Future& future, const Pipeline& fallbackPipeline)
+        :
+        future_(future),
+        pResolvedPipeline_(nullptr),
+        fallbackPipeline_(fallbackPipeline)
+        {}
+        
+        const VkPipeline& AsyncPipeline::get() const noexcept
+        {
+            return this->resolve().get();
+        }
+        
+        bool AsyncPipeline::isReady() const noexcept
+        {
+            return &this->resolve() != &this->fallbackPipeline_;
+        }
+        
+        const Pipeline& AsyncPipeline::resolve() const noexcept
+        {
+            // Once the build is collected the answer never changes, so later calls skip the lock.
+            if (const Pipeline* pPipeline = this->pResolvedPipeline_.load(std::memory_order_acquire))
+                return *pPipeline;
+            
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            if (const Pipeline* pPipeline = this->pResolvedPipeline_.load(std::memory_order_relaxed))
+                return *pPipeline;
+            
+            if (this->future_.valid() && this->future_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return this->fallbackPipeline_;
+            
+            try
+            {
+                if (this->future_.valid())
+                    this->pipeline_ = this->future_.get();
+            }
+            catch (const std::exception& errorMessage)
+            {
+                MGO_DEBUG_LOG_ERROR("mgo::vk::AsyncPipeline keeps its fallback: " << errorMessage.what());
+            }
+            this->future_ = PipelineBuilder::Future();
+            
+            const Pipeline* pPipeline = this->pipeline_ ? this->pipeline_.get() : &this->fallbackPipeline_;
+            this->pResolvedPipeline_.store(pPipeline, std::memory_order_release);
+            return *pPipeline;
+        }
+        
+#pragma mark - mgo::vk::CommandPool
+        CommandPool::CommandPool(const PhysicalDevice& physicalDevice, const Device& device, PhysicalDevice::QueueType queueType)
+        :
+        queueType_(queueType),
+        physicalDevice_(physicalDevice),
+        device_(device)
+        {
+            VkCommandPoolCreateInfo commandPoolCreateInfo{};
+            commandPoolCreateInfo.sType               = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            commandPoolCreateInfo.pNext               = nullptr;
+            commandPoolCreateInfo.flags               = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            commandPoolCreateInfo.queueFamilyIndex    = this->physicalDevice_.getQueueFamilyIndex(this->queueType_);
+            
+            if (vkCreateCommandPool(this->device_.get(), &commandPoolCreateInfo, nullptr, &this->commandPool_) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::CommandPool!");
+        }
+        
+        CommandPool::~CommandPool() noexcept
+        {
+            vkDestroyCommandPool(this->device_.get(), this->commandPool_, nullptr);
+        }
+        
+        const VkCommandPool& CommandPool::get() const noexcept
+        {
+            return this->commandPool_;
+        }
+        
+        const VkQueue& CommandPool::getQueue() const noexcept
+        {
+            return this->device_.getQueue(this->queueType_);
+        }
+        
+        PhysicalDevice::QueueType CommandPool::getQueueType() const noexcept
+        {
+            return this->queueType_;
+        }
+        
+#pragma mark - mgo::vk::StagingRing
+        StagingRing::StagingRing(const Device& device,
+                                 MemoryAllocator& memoryAllocator,
+                                 const CommandPool& commandPool,
+                                 QueueTimelines& queueTimelines,
+                                 VkDeviceSize capacity)
+        :
+        buffer_(device,
+                memoryAllocator,
+                capacity,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        batchValues_{},
+        batchBytes_{},
+        head_(0),
+        usedBytes_(0),
+        pendingBytes_(0),
+        oldestBatch_(0),
+        batchesInFlight_(0),
+        device_(device),
+        commandPool_(commandPool),
+        queueTimelines_(queueTimelines)
+        {
+            VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+            commandBufferAllocateInfo.sType               = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            commandBufferAllocateInfo.pNext               = nullptr;
+            commandBufferAllocateInfo.commandPool         = this->commandPool_.get();
+            commandBufferAllocateInfo.level               = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            commandBufferAllocateInfo.commandBufferCount  = static_cast<std::uint32_t>(this->commandBuffers_.size());
+            
+            if (vkAllocateCommandBuffers(this->device_.get(), &commandBufferAllocateInfo, this->commandBuffers_.data()) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create mgo::vk::StagingRing!");
+        }
+        
+        StagingRing::~StagingRing() noexcept
+        {
+            while (this->batchesInFlight_ > 0)
+                this->waitForOldestBatch();
+            
+            vkFreeCommandBuffers(this->device_.get(),
+                                 this->commandPool_.get(),
+                                 static_cast<std::uint32_t>(this->commandBuffers_.size()),
+                                 this->commandBuffers_.data());
+        }
+        
+        void StagingRing::upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size)
+        {
+            const std::uint8_t* pSrc = static_cast<const std::uint8_t*>(pData);
+            
+            // Uploads larger than half the ring are streamed through in chunks.
+            while (size > 0)
+            {
+                VkDeviceSize chunkSize = std::min(size, this->buffer_.size() / 2);
+                VkDeviceSize srcOffset = this->reserve(chunkSize);
+                
+                std::memcpy(static_cast<std::uint8_t*>(this->buffer_.getMappedData()) + srcOffset, pSrc, chunkSize);
+                
+                VkBufferCopy bufferCopy{};
+                bufferCopy.srcOffset    = srcOffset;
+                bufferCopy.dstOffset    = dstOffset;
+                bufferCopy.size         = chunkSize;
+                this->pendingCopies_[dstBuffer].push_back(bufferCopy);
+                
+                pSrc        += chunkSize;
+                dstOffset   += chunkSize;
+                size        -= chunkSize;
+            }
+        }
+        
+        std::uint64_t StagingRing::flush()
+        {
+            return this->submitBatch();
+        }
+        
+        std::uint64_t StagingRing::submitBatch()
+        {
+            if (this->pendingCopies_.empty())
+                return 0;
+            
+            if (this->batchesInFlight_ == MAX_BATCHES_IN_FLIGHT)
+                this->waitForOldestBatch();
+            
+            std::size_t batch = (this->oldestBatch_ + this->batchesInFlight_) % MAX_BATCHES_IN_FLIGHT;
+            VkCommandBuffer commandBuffer = this->commandBuffers_[batch];
+            vkResetCommandBuffer(commandBuffer, 0);
+            
+            VkCommandBufferBeginInfo commandBufferBeginInfo{};
+            commandBufferBeginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            commandBufferBeginInfo.pNext            = nullptr;
+            commandBufferBeginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            commandBufferBeginInfo.pInheritanceInfo = nullptr;
+            
+            if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+                throw std::runtime_error("Failed to begin recording staging batch!");
+            
+            // One copy command per destination buffer, carrying every region queued for it.
+            for (const auto& [dstBuffer, bufferCopies] : this->pendingCopies_)
+                vkCmdCopyBuffer(commandBuffer,
+                                this->buffer_.get(),
+                                dstBuffer,
+                                static_cast<std::uint32_t>(bufferCopies.size()),
+                                bufferCopies.data());
+            
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+                throw std::runtime_error("Failed to end recording staging batch!");
+            
+            // Every batch signals the next value on its queue's timeline, which also orders it behind earlier batches.
+            const std::uint64_t signalValue = this->queueTimelines_.getNextValue(this->getQueueType());
+            const VkSemaphore signalSemaphore = this->queueTimelines_.getSemaphore(this->getQueueType());
+            
+            VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo{};
+            timelineSemaphoreSubmitInfo.sType                       = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineSemaphoreSubmitInfo.pNext                       = nullptr;
+            timelineSemaphoreSubmitInfo.waitSemaphoreValueCount     = 0;
+            timelineSemaphoreSubmitInfo.pWaitSemaphoreValues        = nullptr;
+            timelineSemaphoreSubmitInfo.signalSemaphoreValueCount   = 1;
+            timelineSemaphoreSubmitInfo.pSignalSemaphoreValues      = &signalValue;
+            
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.pNext                = &timelineSemaphoreSubmitInfo;
+            submitInfo.waitSemaphoreCount   = 0;
+            submitInfo.pWaitSemaphores      = nullptr;
+            submitInfo.pWaitDstStageMask    = nullptr;
+            submitInfo.commandBufferCount   = 1;
+            submitInfo.pCommandBuffers      = &commandBuffer;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores    = &signalSemaphore;
+            
+            if (vkQueueSubmit(this->commandPool_.getQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+                throw std::runtime_error("Failed to submit staging batch!");
+            this->queueTimelines_.advance(this->getQueueType());
+            
+            this->batchValues_[batch] = signalValue;
+            this->batchBytes_[batch] = this->pendingBytes_;
+            this->pendingBytes_ = 0;
+            this->pendingCopies_.clear();
+            ++this->batchesInFlight_;
+            
+            return signalValue;
+        }
+        
+        void StagingRing::collect() noexcept
+        {
+            while (this->batchesInFlight_ > 0 && this->queueTimelines_.isComplete(this->getQueueType(), this->batchValues_[this->oldestBatch_]))
+                this->retireOldestBatch();
+        }
+        
+        PhysicalDevice::QueueType StagingRing::getQueueType() const noexcept
+        {
+            return this->commandPool_.getQueueType();
+        }
+        
+        VkDeviceSize StagingRing::reserve(VkDeviceSize size)
+        {
+            const VkDeviceSize capacity = this->buffer_.size();
+            
+            while (true)
+            {
+                VkDeviceSize offset = MemoryAllocator::alignUp(this->head_, COPY_ALIGNMENT);
+                VkDeviceSize consumed = offset - this->head_ + size;
+                
+                // The tail end of the ring is skipped rather than splitting a copy region across the wrap.
+                if (offset + size > capacity)
+                {
+                    offset = 0;
+                    consumed = capacity - this->head_ + size;
+                }
+                
+                if (this->usedBytes_ + consumed <= capacity)
+                {
+                    this->head_ = offset + size;
+                    this->usedBytes_ += consumed;
+                    this->pendingBytes_ += consumed;
+                    return offset;
+                }
+                
+                // A batch submitted to make room is covered by the next flush(), whose timeline value is larger.
+                if (this->batchesInFlight_ == 0)
+                    this->submitBatch();
+                
+                if (this->batchesInFlight_ == 0)
+                    throw std::runtime_error("Failed to reserve mgo::vk::StagingRing space!");
+                
+                this->waitForOldestBatch();
+            }
+        }
+        
+        void StagingRing::waitForOldestBatch() noexcept
+        {
+            this->queueTimelines_.wait(this->getQueueType(), this->batchValues_[this->oldestBatch_]);
+            this->retireOldestBatch();
+        }
+        
+        void StagingRing::retireOldestBatch() noexcept
+        {
+            this->usedBytes_ -= this->batchBytes_[this->oldestBatch_];
+            this->oldestBatch_ = (this->oldestBatch_ + 1) % MAX_BATCHES_IN_FLIGHT;
+            --this->batchesInFlight_;
+        }
+        
+#pragma mark - mgo::vk::AsyncCompute
+        AsyncCompute::AsyncCompute(const Device& device, const CommandPool& commandPool, QueueTimelines& queueTimelines)
+        :
+        batchValues_{},
+        nextBatch_(0),
+        device_(device),
+        commandPool_(commandPool),
+        queueTimelines_(queueTimelines)
+        {
+            VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+            commandBufferAllocateInfo.sType               = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            commandBufferAllocateInfo.pNext               = nullptr;
+            commandBufferAllocateInfo.commandPool         = this->commandPool_.get();
+            commandBufferAllocateInfo.level               = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            commandBufferAllocateInfo.commandBufferCount  = static_cast<std::uint32_t>(this->commandBuffers_.size());
+            
+            if (vkAllocateCommandBuffers(this->device_.get(), &commandBufferAllocateInfo, this->commandBuffers_.data()) != VK_SUCCESS)
+                throw std::runtime_error("Failed to allocate mgo::vk::AsyncCompute command buffers!");
+        }
+        
+        AsyncCompute::~AsyncCompute() noexcept
+        {
+            for (std::uint64_t batchValue : this->batchValues_)
+                this->queueTimelines_.wait(this->getQueueType(), batchValue);
+            
+            vkFreeCommandBuffers(this->device_.get(),
+                                 this->commandPool_.get(),
+                                 static_cast<std::uint32_t>(this->commandBuffers_.size()),
+                                 this->commandBuffers_.data());
+        }
+        
+        std::uint64_t AsyncCompute::submit(const RecordFunction& record)
+        {
+            // The command pool is externally synchronised, and batches reuse their command buffer round-robin.
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            const std::size_t batch = this->nextBatch_;
+            this->queueTimelines_.wait(this->getQueueType(), this->batchValues_[batch]);
+            
+            VkCommandBuffer commandBuffer = this->commandBuffers_[batch];
+            vkResetCommandBuffer(commandBuffer, 0);
+            
+            VkCommandBufferBeginInfo commandBufferBeginInfo{};
+            commandBufferBeginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            commandBufferBeginInfo.pNext            = nullptr;
+            commandBufferBeginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            commandBufferBeginInfo.pInheritanceInfo = nullptr;
+            
+            if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+                throw std::runtime_error("Failed to begin recording compute batch!");
+            record(commandBuffer);
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+                throw std::runtime_error("Failed to end recording compute batch!");
+            
+            // Like staging batches, compute batches signal the next value on their own queue's timeline.
+            const std::uint64_t signalValue = this->queueTimelines_.getNextValue(this->getQueueType());
+            const VkSemaphore signalSemaphore = this->queueTimelines_.getSemaphore(this->getQueueType());
+            
+            VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo{};
+            timelineSemaphoreSubmitInfo.sType                       = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineSemaphoreSubmitInfo.pNext                       = nullptr;
+            timelineSemaphoreSubmitInfo.waitSemaphoreValueCount     = 0;
+            timelineSemaphoreSubmitInfo.pWaitSemaphoreValues        = nullptr;
+            timelineSemaphoreSubmitInfo.signalSemaphoreValueCount   = 1;
+            timelineSemaphoreSubmitInfo.pSignalSemaphoreValues      = &signalValue;
+            
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.pNext                = &timelineSemaphoreSubmitInfo;
+            submitInfo.waitSemaphoreCount   = 0;
+            submitInfo.pWaitSemaphores      = nullptr;
+            submitInfo.pWaitDstStageMask    = nullptr;
+            submitInfo.commandBufferCount   = 1;
+            submitInfo.pCommandBuffers      = &commandBuffer;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores    = &signalSemaphore;
+            
+            if (vkQueueSubmit(this->commandPool_.getQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+                throw std::runtime_error("Failed to submit compute batch!");
+            this->queueTimelines_.advance(this->getQueueType());
+            
+            this->batchValues_[batch] = signalValue;
+            this->nextBatch_ = (batch + 1) % MAX_BATCHES_IN_FLIGHT;
+            return signalValue;
+        }
+        
+        PhysicalDevice::QueueType AsyncCompute::getQueueType() const noexcept
+        {
+            return this->commandPool_.getQueueType();
+        }
+        
+#pragma mark - mgo::vk::Vertex
+        std::vector<VkVertexInputBindingDescription> Vertex::getVkVertexInputBindingDescriptions() noexcept
+        {
+            VkVertexInputBindingDescription vertexInputBindingDescription{};
+            vertexInputBindingDescription.binding   = 0;
+            vertexInputBindingDescription.stride    = sizeof(Vertex);
+            vertexInputBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            return {vertexInputBindingDescription};
+        }
+        
+        std::vector<VkVertexInputAttributeDescription> Vertex::getVkVertexInputAttributeDescriptions() noexcept
+        {
+            VkVertexInputAttributeDescription positionAttributeDescription{};
+            positionAttributeDescription.location   = 0;
+            positionAttributeDescription.binding    = 0;
+            positionAttributeDescription.format     = VK_FORMAT_R32G32_SFLOAT;
+            positionAttributeDescription.offset     = offsetof(Vertex, position_);
+            
+            VkVertexInputAttributeDescription colorAttributeDescription{};
+            colorAttributeDescription.location      = 1;
+            colorAttributeDescription.binding       = 0;
+            colorAttributeDescription.format        = VK_FORMAT_R32G32B32_SFLOAT;
+            colorAttributeDescription.offset        = offsetof(Vertex, color_);
+            
+            return {positionAttributeDescription, colorAttributeDescription};
+        }
+        
+#pragma mark - mgo::vk::InstanceData
+        std::vector<VkVertexInputBindingDescription> InstanceData::getVkVertexInputBindingDescriptions() noexcept
+        {
+            VkVertexInputBindingDescription instanceInputBindingDescription{};
+            instanceInputBindingDescription.binding     = 1;
+            instanceInputBindingDescription.stride      = sizeof(InstanceData);
+            instanceInputBindingDescription.inputRate   = VK_VERTEX_INPUT_RATE_INSTANCE;
+            return {instanceInputBindingDescription};
+        }
+        
+        std::vector<VkVertexInputAttributeDescription> InstanceData::getVkVertexInputAttributeDescriptions() noexcept
+        {
+            // A mat4 attribute occupies four consecutive locations, one per column.
+            std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+            for (std::uint32_t column = 0; column < 4; column++)
+            {
+                VkVertexInputAttributeDescription transformAttributeDescription{};
+                transformAttributeDescription.location  = 2 + column;
+                transformAttributeDescription.binding   = 1;
+                transformAttributeDescription.format    = VK_FORMAT_R32G32B32A32_SFLOAT;
+                transformAttributeDescription.offset    = static_cast<std::uint32_t>(offsetof(InstanceData, transform_) + 4 * sizeof(float) * column);
+                attributeDescriptions.push_back(transformAttributeDescription);
+            }
+            
+            VkVertexInputAttributeDescription colorAttributeDescription{};
+            colorAttributeDescription.location          = 6;
+            colorAttributeDescription.binding           = 1;
+            colorAttributeDescription.format            = VK_FORMAT_R32G32B32A32_SFLOAT;
+            colorAttributeDescription.offset            = offsetof(InstanceData, color_);
+            attributeDescriptions.push_back(colorAttributeDescription);
+            
+            VkVertexInputAttributeDescription materialIndexAttributeDescription{};
+            materialIndexAttributeDescription.location  = 7;
+            materialIndexAttributeDescription.binding   = 1;
+            materialIndexAttributeDescription.format    = VK_FORMAT_R32_UINT;
+            materialIndexAttributeDescription.offset    = offsetof(InstanceData, materialIndex_);
+            attributeDescriptions.push_back(materialIndexAttributeDescription);
+            
+            return attributeDescriptions;
+        }
+        
+#pragma mark - mgo::vk::VertexBuffer
+        VertexBuffer::VertexBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<Vertex>& vertices)
+        :
+        buffer_(device,
+                memoryAllocator,
+                sizeof(Vertex) * vertices.size(),
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        vertexCount_(static_cast<std::uint32_t>(vertices.size()))
+        {
+            stagingRing.upload(this->buffer_.get(), 0, vertices.data(), this->buffer_.size());
+        }
+        
+        const VkBuffer& VertexBuffer::get() const noexcept
+        {
+            return this->buffer_.get();
+        }
+        
+        std::uint32_t VertexBuffer::size() const noexcept
+        {
+            return this->vertexCount_;
+        }
+        
+#pragma mark - mgo::vk::InstanceBuffer
+        InstanceBuffer::InstanceBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<InstanceData>& instances)
+        :
+        buffer_(device,
+                memoryAllocator,
+                sizeof(InstanceData) * instances.size(),
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        instanceCount_(static_cast<std::uint32_t>(instances.size()))
+        {
+            stagingRing.upload(this->buffer_.get(), 0, instances.data(), this->buffer_.size());
+        }
+        
+        const VkBuffer& InstanceBuffer::get() const noexcept
+        {
+            return this->buffer_.get();
+        }
+        
+        std::uint32_t InstanceBuffer::size() const noexcept
+        {
+            return this->instanceCount_;
+        }
+        
+#pragma mark - mgo::vk::IndexBuffer
+        IndexBuffer::IndexBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<std::uint16_t>& indices)
+        :
+        buffer_(device,
+                memoryAllocator,
+                sizeof(std::uint16_t) * indices.size(),
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        indexCount_(static_cast<std::uint32_t>(indices.size())),
+        indexType_(VK_INDEX_TYPE_UINT16)
+        {
+            stagingRing.upload(this->buffer_.get(), 0, indices.data(), this->buffer_.size());
+        }
+        
+        IndexBuffer::IndexBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<std::uint32_t>& indices)
+        :
+        buffer_(device,
+                memoryAllocator,
+                sizeof(std::uint32_t) * indices.size(),
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        indexCount_(static_cast<std::uint32_t>(indices.size())),
+        indexType_(VK_INDEX_TYPE_UINT32)
+        {
+            stagingRing.upload(this->buffer_.get(), 0, indices.data(), this->buffer_.size());
+        }
+        
+        const VkBuffer& IndexBuffer::get() const noexcept
+        {
+            return this->buffer_.get();
+        }
+        
+        std::uint32_t IndexBuffer::size() const noexcept
+        {
+            return this->indexCount_;
+        }
+        
+        VkIndexType IndexBuffer::getVkIndexType() const noexcept
+        {
+            return this->indexType_;
+        }
+        
+#pragma mark - mgo::vk::IndirectRenderer
+        IndirectRenderer::IndirectRenderer(const Device& device,
+                                           MemoryAllocator& memoryAllocator,
+                                           DeletionQueue& deletionQueue,
+                                           StagingRing& stagingRing,
+                                           BindlessDescriptors& bindlessDescriptors,
+                                           const PipelineLayout& pipelineLayout,
+                                           const ComputePipeline& cullPipeline)
+        :
+        countBuffer_(device,
+                     memoryAllocator,
+                     sizeof(std::uint32_t),
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        objectHandle_(BindlessDescriptors::INVALID_HANDLE),
+        drawHandle_(BindlessDescriptors::INVALID_HANDLE),
+        countHandle_(bindlessDescriptors.addStorageBuffer(this->countBuffer_)),
+        objectCount_(0),
+        vkCmdDrawIndexedIndirectCount_(nullptr),
+        multiDrawSupported_(false),
+        supported_(false),
+        device_(device),
+        memoryAllocator_(memoryAllocator),
+        deletionQueue_(deletionQueue),
+        stagingRing_(stagingRing),
+        bindlessDescriptors_(bindlessDescriptors),
+        pipelineLayout_(pipelineLayout),
+        cullPipeline_(cullPipeline)
+        {
+            // Until a frustum is set every plane accepts every sphere.
+            this->frustum_.fill({0.0f, 0.0f, 0.0f, 1.0f});
+            
+            // Each object's firstInstance selects its instance data, so without drawIndirectFirstInstance the renderer stays empty.
+            VkPhysicalDeviceFeatures physicalDeviceFeatures = this->device_.getPhysicalDevice().getPhysicalDeviceFeatures();
+            this->multiDrawSupported_ = physicalDeviceFeatures.multiDrawIndirect;
+            this->supported_ = physicalDeviceFeatures.drawIndirectFirstInstance;
+            if (!this->supported_)
+            {
+                MGO_DEBUG_LOG_MESSAGE("drawIndirectFirstInstance is not supported, mgo::vk::IndirectRenderer is disabled.");
+                return;
+            }
+            
+            // A draw count above one needs multiDrawIndirect as well.
+            if (this->multiDrawSupported_ && this->device_.getPhysicalDevice().isExtensionSupported(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+                this->vkCmdDrawIndexedIndirectCount_ = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                    vkGetDeviceProcAddr(this->device_.get(), "vkCmdDrawIndexedIndirectCountKHR"));
+        }
+        
+        IndirectRenderer::~IndirectRenderer() noexcept
+        {
+            this->releaseBuffers();
+            this->bindlessDescriptors_.remove(BindlessDescriptors::Binding::STORAGE_BUFFERS, this->countHandle_);
+        }
+        
+        void IndirectRenderer::setObjects(const std::vector<Object>& objects)
+        {
+            // Frames in flight may still cull the previous buffers, so they are retired instead of overwritten.
+            this->releaseBuffers();
+            this->objectCount_ = this->supported_ ? static_cast<std::uint32_t>(objects.size()) : 0;
+            if (this->objectCount_ == 0)
+                return;
+            
+            this->objectBuffer_ = std::make_unique<Buffer>(this->device_,
+                                                           this->memoryAllocator_,
+                                                           sizeof(Object) * objects.size(),
+                                                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                           &this->deletionQueue_);
+            this->drawBuffer_ = std::make_unique<Buffer>(this->device_,
+                                                         this->memoryAllocator_,
+                                                         sizeof(VkDrawIndexedIndirectCommand) * objects.size(),
+                                                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                         &this->deletionQueue_);
+            this->objectHandle_ = this->bindlessDescriptors_.addStorageBuffer(*this->objectBuffer_);
+            this->drawHandle_ = this->bindlessDescriptors_.addStorageBuffer(*this->drawBuffer_);
+            
+            this->stagingRing_.upload(this->objectBuffer_->get(), 0, objects.data(), this->objectBuffer_->size());
+        }
+        
+        void IndirectRenderer::setFrustum(const Frustum& frustum) noexcept
+        {
+            this->frustum_ = frustum;
+        }
+        
+        void IndirectRenderer::cull(VkCommandBuffer commandBuffer) const noexcept
+        {
+            if (this->objectCount_ == 0)
+                return;
+            
+            // The previous frame must have read its draws before they are rewritten.
+            recordBarrier(commandBuffer,
+                          VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                          0,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          0);
+            
+            vkCmdFillBuffer(commandBuffer, this->countBuffer_.get(), 0, sizeof(std::uint32_t), 0);
+            recordBarrier(commandBuffer,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_ACCESS_TRANSFER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+            
+            CullConstants cullConstants{};
+            cullConstants.resourceIndices_  = {this->objectHandle_, this->drawHandle_, this->countHandle_, this->objectCount_};
+            cullConstants.frustum_          = this->frustum_;
+            cullConstants.compact_          = this->isCompacting() ? 1 : 0;
+            
+            this->cullPipeline_.bind(commandBuffer);
+            this->pipelineLayout_.pushConstants(commandBuffer, 0, sizeof(CullConstants), &cullConstants);
+            vkCmdDispatch(commandBuffer, (this->objectCount_ + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+            
+            recordBarrier(commandBuffer,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_SHADER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                          VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+        }
+        
+        void IndirectRenderer::draw(VkCommandBuffer commandBuffer, VkPipeline pipeline, std::uint32_t uniformOffset) const noexcept
+        {
+            if (this->objectCount_ == 0)
+                return;
+            
+            // The draws bind every set and push constant they use, so nothing leaks in from whatever was recorded before them.
+            const std::array<std::uint32_t, 4> resourceIndices = {this->objectHandle_, this->drawHandle_, this->countHandle_, this->objectCount_};
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            this->pipelineLayout_.bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+            this->pipelineLayout_.bindFrameData(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, uniformOffset, 0);
+            this->pipelineLayout_.pushConstants(commandBuffer, 0, sizeof(resourceIndices), resourceIndices.data());
+            
+            // Without a draw count the culled commands stay in place with an instance count of zero.
+            if (this->isCompacting())
+                this->vkCmdDrawIndexedIndirectCount_(commandBuffer,
+                                                     this->drawBuffer_->get(),
+                                                     0,
+                                                     this->countBuffer_.get(),
+                                                     0,
+                                                     this->objectCount_,
+                                                     sizeof(VkDrawIndexedIndirectCommand));
+            else if (this->multiDrawSupported_)
+                vkCmdDrawIndexedIndirect(commandBuffer, this->drawBuffer_->get(), 0, this->objectCount_, sizeof(VkDrawIndexedIndirectCommand));
+            else
+                for (std::uint32_t object = 0; object < this->objectCount_; object++)
+                    vkCmdDrawIndexedIndirect(commandBuffer, this->drawBuffer_->get(), object * sizeof(VkDrawIndexedIndirectCommand), 1, 0);
+        }
+        
+        std::uint32_t IndirectRenderer::getObjectCount() const noexcept
+        {
+            return this->objectCount_;
+        }
+        
+        bool IndirectRenderer::isCompacting() const noexcept
+        {
+            return this->vkCmdDrawIndexedIndirectCount_ != nullptr;
+        }
+        
+        bool IndirectRenderer::isSupported() const noexcept
+        {
+            return this->supported_;
+        }
+        
+        void IndirectRenderer::releaseBuffers() noexcept
+        {
+            if (this->objectHandle_ != BindlessDescriptors::INVALID_HANDLE)
+                this->bindlessDescriptors_.remove(BindlessDescriptors::Binding::STORAGE_BUFFERS, this->objectHandle_);
+            if (this->drawHandle_ != BindlessDescriptors::INVALID_HANDLE)
+                this->bindlessDescriptors_.remove(BindlessDescriptors::Binding::STORAGE_BUFFERS, this->drawHandle_);
+            this->objectHandle_ = BindlessDescriptors::INVALID_HANDLE;
+            this->drawHandle_ = BindlessDescriptors::INVALID_HANDLE;
+            this->objectBuffer_.reset();
+            this->drawBuffer_.reset();
+        }
+        
+        void IndirectRenderer::recordBarrier(VkCommandBuffer commandBuffer,
+                                             VkPipelineStageFlags srcStageMask,
+                                             VkAccessFlags srcAccessMask,
+                                             VkPipelineStageFlags dstStageMask,
+                                             VkAccessFlags dstAccessMask) noexcept
+        {
+            VkMemoryBarrier memoryBarrier{};
+            memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.pNext         = nullptr;
+            memoryBarrier.srcAccessMask = srcAccessMask;
+            memoryBarrier.dstAccessMask = dstAccessMask;
+            
+            vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+        }
+        
+#pragma mark - mgo::vk::GpuProfiler
+        GpuProfiler::Scope::Scope(GpuProfiler& gpuProfiler, VkCommandBuffer commandBuffer, const std::string& name)
+        :
+        gpuProfiler_(gpuProfiler),
+        commandBuffer_(commandBuffer)
+        {
+            this->gpuProfiler_.beginScope(this->commandBuffer_, name);
+        }
+        
+        GpuProfiler::Scope::~Scope() noexcept
+        {
+            this->gpuProfiler_.endScope(this->commandBuffer_);
+        }
+        
+        GpuProfiler::GpuProfiler(const Device& device, std::uint32_t framesInFlight, std::uint32_t maxScopes)
+        :
+        timestampQueryPools_(framesInFlight, VK_NULL_HANDLE),
+        statisticsQueryPools_(framesInFlight, VK_NULL_HANDLE),
+        frameScopes_(framesInFlight),
+        frameRecorded_(framesInFlight, false),
+        statisticsQueryCounts_(framesInFlight, 0),
+        currentFrame_(0),
+        timestampPeriod_(0.0),
+        timestampMask_(0),
+        timestampsSupported_(false),
+        statisticsSupported_(false),
+        maxScopes_(maxScopes),
+        device_(device)
+        {
+            const PhysicalDevice& physicalDevice = this->device_.getPhysicalDevice();
+            
+            std::uint32_t queueFamilyPropertyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.get(), &queueFamilyPropertyCount, nullptr);
+            std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyPropertyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.get(), &queueFamilyPropertyCount, queueFamilyProperties.data());
+            
+            std::uint32_t timestampValidBits = queueFamilyProperties[physicalDevice.getQueueFamilyIndex(PhysicalDevice::QueueType::GRAPHICS)].timestampValidBits;
+            this->timestampPeriod_ = static_cast<double>(physicalDevice.getPhysicalDeviceProperties().limits.timestampPeriod);
+            this->timestampMask_ = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+            this->timestampsSupported_ = timestampValidBits > 0 && this->timestampPeriod_ > 0.0;
+            
+            // Statistics queries stay active across vkCmdExecuteCommands, which needs inheritedQueries.
+            VkPhysicalDeviceFeatures physicalDeviceFeatures = physicalDevice.getPhysicalDeviceFeatures();
+            this->statisticsSupported_ = this->timestampsSupported_ &&
+                                         physicalDeviceFeatures.pipelineStatisticsQuery &&
+                                         physicalDeviceFeatures.inheritedQueries;
+            
+            if (!this->timestampsSupported_)
+            {
+                MGO_DEBUG_LOG_MESSAGE("GPU timestamps are not supported, mgo::vk::GpuProfiler is disabled.");
+                return;
+            }
+            
+            for (std::uint32_t frame = 0; frame < framesInFlight; frame++)
+            {
+                VkQueryPoolCreateInfo timestampQueryPoolCreateInfo{};
+                timestampQueryPoolCreateInfo.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+                timestampQueryPoolCreateInfo.pNext              = nullptr;
+                timestampQueryPoolCreateInfo.flags              = 0;
+                timestampQueryPoolCreateInfo.queryType          = VK_QUERY_TYPE_TIMESTAMP;
+                timestampQueryPoolCreateInfo.queryCount         = 2 * (this->maxScopes_ + 1);
+                timestampQueryPoolCreateInfo.pipelineStatistics = 0;
+                
+                if (vkCreateQueryPool(this->device_.get(), &timestampQueryPoolCreateInfo, nullptr, &this->timestampQueryPools_[frame]) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to create mgo::vk::GpuProfiler!");
+                
+                if (!this->statisticsSupported_)
+                    continue;
+                
+                VkQueryPoolCreateInfo statisticsQueryPoolCreateInfo{};
+                statisticsQueryPoolCreateInfo.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+                statisticsQueryPoolCreateInfo.pNext                 = nullptr;
+                statisticsQueryPoolCreateInfo.flags                 = 0;
+                statisticsQueryPoolCreateInfo.queryType             = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+                statisticsQueryPoolCreateInfo.queryCount            = this->maxScopes_;
+                statisticsQueryPoolCreateInfo.pipelineStatistics    = PIPELINE_STATISTICS;
+                
+                if (vkCreateQueryPool(this->device_.get(), &statisticsQueryPoolCreateInfo, nullptr, &this->statisticsQueryPools_[frame]) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to create mgo::vk::GpuProfiler!");
+            }
+        }
+        
+        GpuProfiler::~GpuProfiler() noexcept
+        {
+            for (VkQueryPool queryPool : this->timestampQueryPools_)
+                if (queryPool != VK_NULL_HANDLE)
+                    vkDestroyQueryPool(this->device_.get(), queryPool, nullptr);
+            
+            for (VkQueryPool queryPool : this->statisticsQueryPools_)
+                if (queryPool != VK_NULL_HANDLE)
+                    vkDestroyQueryPool(this->device_.get(), queryPool, nullptr);
+        }
+        
+        void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, std::uint32_t frame)
+        {
+            if (!this->timestampsSupported_)
+                return;
+            
+            // The frame's fence has signalled, so its queries from framesInFlight frames ago are ready without stalling.
+            this->collect(frame);
+            
+            this->currentFrame_ = frame;
+            this->frameScopes_[frame].clear();
+            this->frameRecorded_[frame] = false;
+            this->openScopes_.clear();
+            this->statisticsScope_.reset();
+            this->statisticsQueryCounts_[frame] = 0;
+            
+            vkCmdResetQueryPool(commandBuffer, this->timestampQueryPools_[frame], 0, 2 * (this->maxScopes_ + 1));
+            if (this->statisticsSupported_)
+                vkCmdResetQueryPool(commandBuffer, this->statisticsQueryPools_[frame], 0, this->maxScopes_);
+            
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->timestampQueryPools_[frame], 0);
+        }
+        
+        void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) noexcept
+        {
+            if (!this->timestampsSupported_)
+                return;
+            
+            while (!this->openScopes_.empty())
+            {
+                MGO_DEBUG_LOG_ERROR("mgo::vk::GpuProfiler scope was not closed before the end of the frame!");
+                this->endScope(commandBuffer);
+            }
+            
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->timestampQueryPools_[this->currentFrame_], 1);
+            this->frameRecorded_[this->currentFrame_] = true;
+        }
+        
+        void GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name)
+        {
+            if (!this->timestampsSupported_)
+                return;
+            
+            std::vector<FrameScope>& frameScopes = this->frameScopes_[this->currentFrame_];
+            if (frameScopes.size() >= this->maxScopes_)
+            {
+                this->openScopes_.push_back(SIZE_MAX);
+                return;
+            }
+            
+            FrameScope frameScope{};
+            frameScope.name_ = name;
+            frameScope.timestampQuery_ = 2 * (static_cast<std::uint32_t>(frameScopes.size()) + 1);
+            
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->timestampQueryPools_[this->currentFrame_], frameScope.timestampQuery_);
+            
+            // Only one statistics query may be active at a time, so nested scopes only get timestamps.
+            if (this->statisticsSupported_ && !this->statisticsScope_.has_value())
+            {
+                frameScope.statisticsQuery_ = this->statisticsQueryCounts_[this->currentFrame_]++;
+                this->statisticsScope_ = frameScopes.size();
+                vkCmdBeginQuery(commandBuffer, this->statisticsQueryPools_[this->currentFrame_], frameScope.statisticsQuery_.value(), 0);
+            }
+            
+            this->openScopes_.push_back(frameScopes.size());
+            frameScopes.emplace_back(std::move(frameScope));
+        }
+        
+        void GpuProfiler::endScope(VkCommandBuffer commandBuffer) noexcept
+        {
+            if (!this->timestampsSupported_ || this->openScopes_.empty())
+                return;
+            
+            std::size_t scopeIndex = this->openScopes_.back();
+            this->openScopes_.pop_back();
+            if (scopeIndex == SIZE_MAX)
+                return;
+            
+            const FrameScope& frameScope = this->frameScopes_[this->currentFrame_][scopeIndex];
+            if (this->statisticsScope_ == scopeIndex)
+            {
+                vkCmdEndQuery(commandBuffer, this->statisticsQueryPools_[this->currentFrame_], frameScope.statisticsQuery_.value());
+                this->statisticsScope_.reset();
+            }
+            
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->timestampQueryPools_[this->currentFrame_], frameScope.timestampQuery_ + 1);
+        }
+        
+        std::optional<GpuProfiler::Statistics> GpuProfiler::getStatistics(const std::string& name) const
+        {
+            auto history = this->histories_.find(name);
+            if (history == this->histories_.end() || history->second.samples_.empty())
+                return std::nullopt;
+            
+            std::vector<double> samples = history->second.samples_;
+            std::sort(samples.begin(), samples.end());
+            
+            auto percentile = [&samples](double fraction)
+            {
+                std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(samples.size())));
+                return samples[std::clamp(rank, static_cast<std::size_t>(1), samples.size()) - 1];
+            };
+            
+            std::size_t lastSample = (history->second.next_ + history->second.samples_.size() - 1) % history->second.samples_.size();
+            
+            Statistics statistics{};
+            statistics.lastMilliseconds_    = history->second.samples_[lastSample];
+            statistics.averageMilliseconds_ = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+            statistics.p50Milliseconds_     = percentile(0.50);
+            statistics.p95Milliseconds_     = percentile(0.95);
+            statistics.p99Milliseconds_     = percentile(0.99);
+            statistics.sampleCount_         = samples.size();
+            statistics.totalSampleCount_    = history->second.totalSampleCount_;
+            statistics.pipelineStatistics_  = history->second.pipelineStatistics_;
+            return statistics;
+        }
+        
+        std::vector<std::string> GpuProfiler::getScopeNames() const
+        {
+            std::vector<std::string> scopeNames;
+            for (const auto& history : this->histories_)
+                scopeNames.push_back(history.first);
+            return scopeNames;
+        }
+        
+        VkQueryPipelineStatisticFlags GpuProfiler::getInheritedPipelineStatistics() const noexcept
+        {
+            return this->statisticsSupported_ ? PIPELINE_STATISTICS : 0;
+        }
+        
+        bool GpuProfiler::isEnabled() const noexcept
+        {
+            return this->timestampsSupported_;
+        }
+        
+        void GpuProfiler::collect(std::uint32_t frame)
+        {
+            if (!this->frameRecorded_[frame])
+                return;
+            this->frameRecorded_[frame] = false;
+            
+            const std::vector<FrameScope>& frameScopes = this->frameScopes_[frame];
+            
+            std::vector<std::uint64_t> timestamps(2 * (frameScopes.size() + 1));
+            if (vkGetQueryPoolResults(this->device_.get(),
+                                      this->timestampQueryPools_[frame],
+                                      0,
+                                      static_cast<std::uint32_t>(timestamps.size()),
+                                      timestamps.size() * sizeof(std::uint64_t),
+                                      timestamps.data(),
+                                      sizeof(std::uint64_t),
+                                      VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+                return;
+            
+            // Each slot keeps its own query count; the slot being collected is not the one recorded last.
+            const std::uint32_t statisticsQueryCount = this->statisticsQueryCounts_[frame];
+            std::vector<std::uint64_t> pipelineStatistics(statisticsQueryCount * PIPELINE_STATISTICS_COUNT);
+            bool hasPipelineStatistics = false;
+            if (this->statisticsSupported_ && !pipelineStatistics.empty())
+                hasPipelineStatistics = vkGetQueryPoolResults(this->device_.get(),
+                                                              this->statisticsQueryPools_[frame],
+                                                              0,
+                                                              statisticsQueryCount,
+                                                              pipelineStatistics.size() * sizeof(std::uint64_t),
+                                                              pipelineStatistics.data(),
+                                                              PIPELINE_STATISTICS_COUNT * sizeof(std::uint64_t),
+                                                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+            
+            this->addSample(FRAME_SCOPE, timestamps[0], timestamps[1], nullptr);
+            for (const FrameScope& frameScope : frameScopes)
+                this->addSample(frameScope.name_,
+                                timestamps[frameScope.timestampQuery_],
+                                timestamps[frameScope.timestampQuery_ + 1],
+                                hasPipelineStatistics && frameScope.statisticsQuery_.has_value() ?
+                                &pipelineStatistics[frameScope.statisticsQuery_.value() * PIPELINE_STATISTICS_COUNT] : nullptr);
+        }
+        
+        void GpuProfiler::addSample(const std::string& name, std::uint64_t beginTimestamp, std::uint64_t endTimestamp, const std::uint64_t* pPipelineStatistics)
+        {
+            History& history = this->histories_[name];
+            double milliseconds = static_cast<double>((endTimestamp - beginTimestamp) & this->timestampMask_) * this->timestampPeriod_ / 1000000.0;
+            
+            if (history.samples_.size() < HISTORY_SIZE)
+                history.samples_.push_back(milliseconds);
+            else
+                history.samples_[history.next_] = milliseconds;
+            history.next_ = (history.next_ + 1) % HISTORY_SIZE;
+            history.totalSampleCount_++;
+            
+            if (pPipelineStatistics != nullptr)
+                std::copy(pPipelineStatistics, pPipelineStatistics + PIPELINE_STATISTICS_COUNT, history.pipelineStatistics_.begin());
+        }
+        
+#pragma mark - mgo::vk::RenderGraph
+        RenderGraph::RenderGraph(const PhysicalDevice& physicalDevice,
+                                 const Device& device,
+                                 MemoryAllocator& memoryAllocator,
+                                 DeletionQueue& deletionQueue,
+                                 const Swapchain& swapchain,
+                                 ImageViews& imageViews)
+        :
+        transientAttachmentPool_(physicalDevice, device, memoryAllocator, deletionQueue, swapchain),
+        barrierCount_(0),
+        compiled_(false),
+        device_(device),
+        deletionQueue_(deletionQueue),
+        swapchain_(swapchain),
+        imageViews_(imageViews)
+        {
+            Resource backbuffer{};
+            backbuffer.name_ = "Backbuffer";
+            backbuffer.description_.format_ = swapchain.getVkSurfaceFormatKHR().format;
+            this->resources_.emplace_back(std::move(backbuffer));
+            this->outputs_.push_back(BACKBUFFER);
+        }
+        
+        RenderGraph::ResourceHandle RenderGraph::createAttachment(const std::string& name, const AttachmentDescription& attachmentDescription)
+        {
+            if (this->compiled_)
+                throw std::runtime_error("Failed to create mgo::vk::RenderGraph attachment " + name + " after compilation!");
+            
+            Resource resource{};
+            resource.name_ = name;
+            resource.description_ = attachmentDescription;
+            this->resources_.emplace_back(std::move(resource));
+            return static_cast<ResourceHandle>(this->resources_.size() - 1);
+        }
+        
+        void RenderGraph::addPass(const std::string& name, const PassDescription& passDescription)
+        {
+            if (this->compiled_)
+                throw std::runtime_error("Failed to add mgo::vk::RenderGraph pass " + name + " after compilation!");
+            
+            std::vector<const Attachment*> attachments = getAttachments(passDescription);
+            if (attachments.empty())
+                throw std::runtime_error("mgo::vk::RenderGraph pass " + name + " has no attachments!");
+            
+            for (const Attachment* pAttachment : attachments)
+                if (pAttachment->resource_ >= this->resources_.size())
+                    throw std::runtime_error("mgo::vk::RenderGraph pass " + name + " uses an unknown resource!");
+            for (ResourceHandle resource : passDescription.sampledImages_)
+                if (resource >= this->resources_.size() || resource == BACKBUFFER)
+                    throw std::runtime_error("mgo::vk::RenderGraph pass " + name + " samples an unknown resource!");
+            
+            Pass pass{};
+            pass.name_ = name;
+            pass.description_ = passDescription;
+            this->passes_.emplace_back(std::move(pass));
+        }
+        
+        void RenderGraph::setOutput(ResourceHandle resource)
+        {
+            if (resource >= this->resources_.size())
+                throw std::runtime_error("mgo::vk::RenderGraph output is an unknown resource!");
+            this->outputs_.push_back(resource);
+        }
+        
+        void RenderGraph::compile()
+        {
+            if (this->compiled_)
+                return;
+            
+            trace::Scope scope("RenderGraph::compile");
+            this->cull(this->getDependencies());
+            this->assignTransientAttachments();
+            this->transientAttachmentPool_.create();
+            this->scheduleBarriers();
+            this->createRenderPasses();
+            this->compiled_ = true;
+        }
+        
+        void RenderGraph::execute(VkCommandBuffer commandBuffer, std::uint32_t imageIndex, GpuProfiler* pGpuProfiler)
+        {
+            this->compile();
+            
+            for (std::size_t passIndex : this->executionOrder_)
+            {
+                const Pass& pass = this->passes_[passIndex];
+                this->recordBarriers(commandBuffer, pass.barriers_, imageIndex);
+                
+                if (pGpuProfiler != nullptr)
+                    pGpuProfiler->beginScope(commandBuffer, pass.name_);
+                
+                if (pass.description_.prepare_)
+                    pass.description_.prepare_(commandBuffer);
+                
+                PassContext passContext{};
+                passContext.commandBuffer_  = commandBuffer;
+                passContext.renderPass_     = pass.renderPass_->get();
+                passContext.framebuffer_    = pass.framebuffers_->get()[std::min(static_cast<std::size_t>(imageIndex), pass.framebuffers_->size() - 1)];
+                passContext.extent_         = this->getExtent(pass.description_);
+                
+                VkRenderPassBeginInfo renderPassBeginInfo{};
+                renderPassBeginInfo.sType                   = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                renderPassBeginInfo.pNext                   = nullptr;
+                renderPassBeginInfo.renderPass              = passContext.renderPass_;
+                renderPassBeginInfo.framebuffer             = passContext.framebuffer_;
+                renderPassBeginInfo.renderArea.offset.x     = 0;
+                renderPassBeginInfo.renderArea.offset.y     = 0;
+                renderPassBeginInfo.renderArea.extent       = passContext.extent_;
+                renderPassBeginInfo.clearValueCount         = static_cast<std::uint32_t>(pass.clearValues_.size());
+                renderPassBeginInfo.pClearValues            = pass.clearValues_.data();
+                
+                vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, pass.description_.subpassContents_);
+                if (pass.description_.execute_)
+                    pass.description_.execute_(passContext);
+                vkCmdEndRenderPass(commandBuffer);
+                
+                if (pGpuProfiler != nullptr)
+                    pGpuProfiler->endScope(commandBuffer);
+            }
+            
+            this->recordBarriers(commandBuffer, this->finalBarriers_, imageIndex);
+        }
+        
+        void RenderGraph::recreate(std::uint64_t retireFrame)
+        {
+            this->imageViews_.recreate(this->swapchain_, retireFrame);
+            if (!this->compiled_)
+                return;
+            
+            this->transientAttachmentPool_.recreate(retireFrame);
+            for (std::size_t passIndex : this->executionOrder_)
+            {
+                Pass& pass = this->passes_[passIndex];
+                pass.framebuffers_->recreate(this->getFramebufferAttachments(pass), this->getExtent(pass.description_), retireFrame);
+            }
+        }
+        
+        const RenderPass& RenderGraph::getRenderPass(const std::string& passName)
+        {
+            this->compile();
+            
+            for (const Pass& pass : this->passes_)
+                if (pass.name_ == passName && pass.renderPass_ != nullptr)
+                    return *pass.renderPass_;
+            throw std::runtime_error("mgo::vk::RenderGraph has no executed pass " + passName + "!");
+        }
+        
+        std::vector<std::string> RenderGraph::getExecutionOrder() const
+        {
+            std::vector<std::string> executionOrder;
+            for (std::size_t passIndex : this->executionOrder_)
+                executionOrder.push_back(this->passes_[passIndex].name_);
+            return executionOrder;
+        }
+        
+        std::size_t RenderGraph::getBarrierCount() const noexcept
+        {
+            return this->barrierCount_;
+        }
+        
+        const TransientAttachmentPool& RenderGraph::getTransientAttachmentPool() const noexcept
+        {
+            return this->transientAttachmentPool_;
+        }
+        
+        std::vector<std::vector<std::size_t>> RenderGraph::getDependencies() const
+        {
+            std::vector<std::vector<std::size_t>> dependencies(this->passes_.size());
+            std::vector<std::optional<std::size_t>> lastWriters(this->resources_.size());
+            std::vector<std::vector<std::size_t>> readers(this->resources_.size());
+            
+            for (std::size_t i = 0; i < this->passes_.size(); i++)
+            {
+                const Pass& pass = this->passes_[i];
+                for (ResourceHandle resource : pass.description_.sampledImages_)
+                {
+                    if (!lastWriters[resource].has_value())
+                        throw std::runtime_error("mgo::vk::RenderGraph pass " + pass.name_ + " samples " + this->resources_[resource].name_ + " before it is written!");
+                    dependencies[i].push_back(lastWriters[resource].value());
+                    readers[resource].push_back(i);
+                }
+                
+                for (const Attachment* pAttachment : getAttachments(pass.description_))
+                {
+                    const ResourceHandle resource = pAttachment->resource_;
+                    if (std::find(pass.description_.sampledImages_.begin(), pass.description_.sampledImages_.end(), resource) != pass.description_.sampledImages_.end())
+                        throw std::runtime_error("mgo::vk::RenderGraph pass " + pass.name_ + " samples and writes " + this->resources_[resource].name_ + "!");
+                    if (lastWriters[resource] == i)
+                        throw std::runtime_error("mgo::vk::RenderGraph pass " + pass.name_ + " attaches " + this->resources_[resource].name_ + " twice!");
+                    if (pAttachment->loadOp_ == VK_ATTACHMENT_LOAD_OP_LOAD && !lastWriters[resource].has_value())
+                        throw std::runtime_error("mgo::vk::RenderGraph pass " + pass.name_ + " loads " + this->resources_[resource].name_ + " before it is written!");
+                    
+                    // Writes wait for the previous writer and for every pass still sampling its result.
+                    if (lastWriters[resource].has_value())
+                        dependencies[i].push_back(lastWriters[resource].value());
+                    dependencies[i].insert(dependencies[i].end(), readers[resource].begin(), readers[resource].end());
+                    readers[resource].clear();
+                    lastWriters[resource] = i;
+                }
+            }
+            return dependencies;
+        }
+        
+        void RenderGraph::cull(const std::vector<std::vector<std::size_t>>& dependencies)
+        {
+            std::vector<bool> used(this->passes_.size(), false);
+            std::vector<std::size_t> pendingPasses;
+            for (ResourceHandle output : this->outputs_)
+            {
+                auto writer = std::find_if(this->passes_.rbegin(), this->passes_.rend(), [&](const Pass& pass)
+                {
+                    std::vector<const Attachment*> attachments = getAttachments(pass.description_);
+                    return std::any_of(attachments.begin(), attachments.end(), [&](const Attachment* pAttachment) { return pAttachment->resource_ == output; });
+                });
+                if (writer == this->passes_.rend())
+                    throw std::runtime_error("mgo::vk::RenderGraph output " + this->resources_[output].name_ + " is never written!");
+                pendingPasses.push_back(static_cast<std::size_t>(std::distance(writer, this->passes_.rend()) - 1));
+            }
+            
+            // Passes that no output transitively depends on are dropped.
+            while (!pendingPasses.empty())
+            {
+                const std::size_t passIndex = pendingPasses.back();
+                pendingPasses.pop_back();
+                if (used[passIndex])
+                    continue;
+                used[passIndex] = true;
+                pendingPasses.insert(pendingPasses.end(), dependencies[passIndex].begin(), dependencies[passIndex].end());
+            }
+            
+            // Dependencies always point at earlier passes, so declaration order is already a valid execution order.
+            this->executionOrder_.clear();
+            for (std::size_t i = 0; i < this->passes_.size(); i++)
+                if (used[i])
+                    this->executionOrder_.push_back(i);
+        }
+        
+        void RenderGraph::assignTransientAttachments()
+        {
+            for (Resource& resource : this->resources_)
+            {
+                resource.usage_ = resource.description_.usage_;
+                resource.transientAttachment_.reset();
+                resource.firstUse_ = SIZE_MAX;
+                resource.lastUse_ = 0;
+            }
+            
+            auto use = [this](ResourceHandle handle, std::size_t position, VkImageUsageFlags usage)
+            {
+                Resource& resource = this->resources_[handle];
+                resource.usage_ |= usage;
+                resource.firstUse_ = std::min(resource.firstUse_, position);
+                resource.lastUse_ = std::max(resource.lastUse_, position);
+            };
+            
+            for (std::size_t position = 0; position < this->executionOrder_.size(); position++)
+            {
+                const PassDescription& passDescription = this->passes_[this->executionOrder_[position]].description_;
+                for (const Attachment& attachment : passDescription.colorAttachments_)
+                    use(attachment.resource_, position, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+                if (passDescription.depthAttachment_.has_value())
+                    use(passDescription.depthAttachment_->resource_, position, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+                for (ResourceHandle resource : passDescription.sampledImages_)
+                    use(resource, position, VK_IMAGE_USAGE_SAMPLED_BIT);
+            }
+            
+            // Outputs are read after the frame, so they must stay alive and may never be lazily allocated.
+            for (ResourceHandle output : this->outputs_)
+                if (output != BACKBUFFER)
+                {
+                    this->resources_[output].lastUse_ = SIZE_MAX;
+                    this->resources_[output].usage_ |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                }
+            
+            for (ResourceHandle handle = BACKBUFFER + 1; handle < this->resources_.size(); handle++)
+            {
+                Resource& resource = this->resources_[handle];
+                if (resource.firstUse_ != SIZE_MAX)
+                    resource.transientAttachment_ = this->transientAttachmentPool_.add(resource.description_.format_,
+                                                                                     resource.description_.extent_,
+                                                                                     resource.usage_,
+                                                                                     resource.firstUse_,
+                                                                                     resource.lastUse_);
+            }
+        }
+        
+        void RenderGraph::scheduleBarriers()
+        {
+            std::vector<ResourceState> states(this->resources_.size(), {VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT});
+            std::vector<ResourceHandle> transientResources(this->transientAttachmentPool_.size());
+            for (ResourceHandle handle = 0; handle < this->resources_.size(); handle++)
+                if (this->resources_[handle].transientAttachment_.has_value())
+                    transientResources[this->resources_[handle].transientAttachment_.value()] = handle;
+            
+            // The first sweep only finds the end-of-frame states the next frame has to wait for.
+            for (int sweep = 0; sweep < 2; sweep++)
+            {
+                for (ResourceState& state : states)
+                    state.layout_ = VK_IMAGE_LAYOUT_UNDEFINED;
+                states[BACKBUFFER] = {VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+                this->barrierCount_ = 0;
+                
+                auto require = [&](std::vector<Barrier>& barriers, ResourceHandle resource, const ResourceState& required, bool discard)
+                {
+                    ResourceState& state = states[resource];
+                    if (state.layout_ == required.layout_ && (state.access_ & WRITE_ACCESS) == 0 && (required.access_ & WRITE_ACCESS) == 0)
+                    {
+                        state.access_ |= required.access_;
+                        state.stages_ |= required.stages_;
+                        return;
+                    }
+                    
+                    Barrier barrier{resource, state, required};
+                    if (discard)
+                        barrier.oldState_.layout_ = VK_IMAGE_LAYOUT_UNDEFINED;
+                    
+                    // Memory shared with other attachments may only be overwritten once they are done with it.
+                    if (discard && this->resources_[resource].transientAttachment_.has_value())
+                        for (TransientAttachmentPool::Handle alias : this->transientAttachmentPool_.getAliases(this->resources_[resource].transientAttachment_.value()))
+                        {
+                            barrier.oldState_.access_ |= states[transientResources[alias]].access_;
+                            barrier.oldState_.stages_ |= states[transientResources[alias]].stages_;
+                        }
+                    barriers.push_back(barrier);
+                    this->barrierCount_++;
+                    state = required;
+                };
+                
+                for (std::size_t passIndex : this->executionOrder_)
+                {
+                    Pass& pass = this->passes_[passIndex];
+                    pass.barriers_.clear();
+                    
+                    for (ResourceHandle resource : pass.description_.sampledImages_)
+                        require(pass.barriers_, resource, {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT}, false);
+                    
+                    for (const Attachment& attachment : pass.description_.colorAttachments_)
+                    {
+                        const bool load = attachment.loadOp_ == VK_ATTACHMENT_LOAD_OP_LOAD;
+                        require(pass.barriers_,
+                                attachment.resource_,
+                                {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                 static_cast<VkAccessFlags>(VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (load ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0)),
+                                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+                                !load);
+                    }
+                    
+                    if (pass.description_.depthAttachment_.has_value())
+                        require(pass.barriers_,
+                                pass.description_.depthAttachment_->resource_,
+                                {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                                 VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT},
+                                pass.description_.depthAttachment_->loadOp_ != VK_ATTACHMENT_LOAD_OP_LOAD);
+                }
+                
+                // The backbuffer reaches its present layout through the last render pass whenever it can.
+                this->finalBarriers_.clear();
+                if (!this->isPresentedByRenderPass())
+                    require(this->finalBarriers_, BACKBUFFER, {this->getPresentLayout(), 0, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT}, false);
+            }
+        }
+        
+        void RenderGraph::createRenderPasses()
+        {
+            for (std::size_t position = 0; position < this->executionOrder_.size(); position++)
+            {
+                Pass& pass = this->passes_[this->executionOrder_[position]];
+                const bool presents = this->isPresentedByRenderPass() && position == this->resources_[BACKBUFFER].lastUse_;
+                
+                const VkExtent2D extent = this->getExtent(pass.description_);
+                for (const Attachment* pAttachment : getAttachments(pass.description_))
+                {
+                    const VkExtent2D attachmentExtent = this->getExtent(pAttachment->resource_);
+                    if (attachmentExtent.width != extent.width || attachmentExtent.height != extent.height)
+                        throw std::runtime_error("mgo::vk::RenderGraph pass " + pass.name_ + " mixes attachment extents!");
+                }
+                
+                RenderPassDescription renderPassDescription{};
+                pass.clearValues_.clear();
+                for (const Attachment& attachment : pass.description_.colorAttachments_)
+                {
+                    VkAttachmentDescription attachmentDescription{};
+                    attachmentDescription.flags           = 0;
+                    attachmentDescription.format          = this->resources_[attachment.resource_].description_.format_;
+                    attachmentDescription.samples         = VK_SAMPLE_COUNT_1_BIT;
+                    attachmentDescription.loadOp          = attachment.loadOp_;
+                    attachmentDescription.storeOp         = this->getStoreOp(attachment.resource_, position);
+                    attachmentDescription.stencilLoadOp   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                    attachmentDescription.stencilStoreOp  = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                    attachmentDescription.initialLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                    attachmentDescription.finalLayout     = presents && attachment.resource_ == BACKBUFFER ? this->getPresentLayout() : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                    renderPassDescription.colorAttachments_.push_back(attachmentDescription);
+                    pass.clearValues_.push_back(attachment.clearValue_);
+                }
+                
+                if (pass.description_.depthAttachment_.has_value())
+                {
+                    const Attachment& attachment = pass.description_.depthAttachment_.value();
+                    const bool stencil = (TransientAttachmentPool::getAspectMask(this->resources_[attachment.resource_].description_.format_) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+                    const VkAttachmentStoreOp storeOp = this->getStoreOp(attachment.resource_, position);
+                    
+                    VkAttachmentDescription attachmentDescription{};
+                    attachmentDescription.flags           = 0;
+                    attachmentDescription.format          = this->resources_[attachment.resource_].description_.format_;
+                    attachmentDescription.samples         = VK_SAMPLE_COUNT_1_BIT;
+                    attachmentDescription.loadOp          = attachment.loadOp_;
+                    attachmentDescription.storeOp         = storeOp;
+                    attachmentDescription.stencilLoadOp   = stencil ? attachment.loadOp_ : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                    attachmentDescription.stencilStoreOp  = stencil ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                    attachmentDescription.initialLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                    attachmentDescription.finalLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                    renderPassDescription.depthAttachment_ = attachmentDescription;
+                    pass.clearValues_.push_back(attachment.clearValue_);
+                }
+                
+                pass.renderPass_ = std::make_unique<RenderPass>(this->device_, renderPassDescription);
+                pass.framebuffers_ = std::make_unique<Framebuffers>(this->device_, this->deletionQueue_, *pass.renderPass_, this->getFramebufferAttachments(pass), extent);
+            }
+        }
+        
+        VkAttachmentStoreOp RenderGraph::getStoreOp(ResourceHandle resource, std::size_t position) const noexcept
+        {
+            if (std::find(this->outputs_.begin(), this->outputs_.end(), resource) != this->outputs_.end())
+                return VK_ATTACHMENT_STORE_OP_STORE;
+            
+            // Contents nobody reads again are never written back to memory.
+            for (std::size_t later = position + 1; later < this->executionOrder_.size(); later++)
+            {
+                const PassDescription& passDescription = this->passes_[this->executionOrder_[later]].description_;
+                if (std::find(passDescription.sampledImages_.begin(), passDescription.sampledImages_.end(), resource) != passDescription.sampledImages_.end())
+                    return VK_ATTACHMENT_STORE_OP_STORE;
+                for (const Attachment* pAttachment : getAttachments(passDescription))
+                    if (pAttachment->resource_ == resource)
+                        return pAttachment->loadOp_ == VK_ATTACHMENT_LOAD_OP_LOAD ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            }
+            return VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+        
+        std::vector<std::vector<VkImageView>> RenderGraph::getFramebufferAttachments(const Pass& pass) const
+        {
+            std::vector<const Attachment*> attachments = getAttachments(pass.description_);
+            const bool usesBackbuffer = std::any_of(attachments.begin(), attachments.end(), [](const Attachment* pAttachment) { return pAttachment->resource_ == BACKBUFFER; });
+            
+            // Passes drawing into the backbuffer need one framebuffer per swapchain image.
+            std::vector<std::vector<VkImageView>> framebufferAttachments(usesBackbuffer ? this->imageViews_.size() : 1);
+            for (std::size_t i = 0; i < framebufferAttachments.size(); i++)
+                for (const Attachment* pAttachment : attachments)
+                    framebufferAttachments[i].push_back(this->getImageView(pAttachment->resource_, static_cast<std::uint32_t>(i)));
+            return framebufferAttachments;
+        }
+        
+        VkExtent2D RenderGraph::getExtent(ResourceHandle resource) const noexcept
+        {
+            const VkExtent2D& extent = this->resources_[resource].description_.extent_;
+            return extent.width == 0 || extent.height == 0 ? this->swapchain_.getVkExtent2D() : extent;
+        }
+        
+        VkExtent2D RenderGraph::getExtent(const PassDescription& passDescription) const noexcept
+        {
+            return this->getExtent(passDescription.colorAttachments_.empty() ? passDescription.depthAttachment_->resource_ : passDescription.colorAttachments_.front().resource_);
+        }
+        
+        VkImageLayout RenderGraph::getPresentLayout() const noexcept
+        {
+            return this->swapchain_.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        }
+        
+        bool RenderGraph::isPresentedByRenderPass() const noexcept
+        {
+            const PassDescription& lastPass = this->passes_[this->executionOrder_[this->resources_[BACKBUFFER].lastUse_]].description_;
+            return std::any_of(lastPass.colorAttachments_.begin(), lastPass.colorAttachments_.end(), [](const Attachment& attachment) { return attachment.resource_ == BACKBUFFER; });
         }
         
-        Pipeline::~Pipeline() noexcept
+        VkImage RenderGraph::getImage(ResourceHandle resource, std::uint32_t imageIndex) const noexcept
         {
-            vkDestroyPipeline(this->device_.get(), this->pipeline_, nullptr);
+            if (resource == BACKBUFFER)
+                return this->swapchain_.getImages()[static_cast<std::size_t>(imageIndex)];
+            return this->transientAttachmentPool_.getImage(this->resources_[resource].transientAttachment_.value());
         }
         
-        const VkPipeline& Pipeline::get() const noexcept
+        VkImageView RenderGraph::getImageView(ResourceHandle resource, std::uint32_t imageIndex) const noexcept
         {
-            return this->pipeline_;
+            if (resource == BACKBUFFER)
+                return this->imageViews_.get()[static_cast<std::size_t>(imageIndex)];
+            return this->transientAttachmentPool_.getImageView(this->resources_[resource].transientAttachment_.value());
         }
         
-        VkPipelineShaderStageCreateInfo Pipeline::getVkPipelineShaderStageCreateInfo(const ShaderModule& shaderModule,
-                                                                                     VkShaderStageFlagBits stage) const noexcept
+        void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers, std::uint32_t imageIndex) const noexcept
         {
-            VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
-            pipelineShaderStageCreateInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            pipelineShaderStageCreateInfo.pNext                   = nullptr;
-            pipelineShaderStageCreateInfo.flags                   = 0;
-            pipelineShaderStageCreateInfo.stage                   = stage;
-            pipelineShaderStageCreateInfo.module                  = shaderModule.get();
-            pipelineShaderStageCreateInfo.pName                   = "main";
-            pipelineShaderStageCreateInfo.pSpecializationInfo     = nullptr;
-            return pipelineShaderStageCreateInfo;
+            if (barriers.empty())
+                return;
+            
+            // Every transition a pass needs goes into a single pipeline barrier.
+            std::vector<VkImageMemoryBarrier> imageMemoryBarriers;
+            VkPipelineStageFlags srcStageMask = 0;
+            VkPipelineStageFlags dstStageMask = 0;
+            for (const Barrier& barrier : barriers)
+            {
+                VkImageMemoryBarrier imageMemoryBarrier{};
+                imageMemoryBarrier.sType                            = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                imageMemoryBarrier.pNext                            = nullptr;
+                imageMemoryBarrier.srcAccessMask                    = barrier.oldState_.access_ & WRITE_ACCESS;
+                imageMemoryBarrier.dstAccessMask                    = barrier.newState_.access_;
+                imageMemoryBarrier.oldLayout                        = barrier.oldState_.layout_;
+                imageMemoryBarrier.newLayout                        = barrier.newState_.layout_;
+                imageMemoryBarrier.srcQueueFamilyIndex              = VK_QUEUE_FAMILY_IGNORED;
+                imageMemoryBarrier.dstQueueFamilyIndex              = VK_QUEUE_FAMILY_IGNORED;
+                imageMemoryBarrier.image                            = this->getImage(barrier.resource_, imageIndex);
+                imageMemoryBarrier.subresourceRange.aspectMask      = TransientAttachmentPool::getAspectMask(this->resources_[barrier.resource_].description_.format_);
+                imageMemoryBarrier.subresourceRange.baseMipLevel    = 0;
+                imageMemoryBarrier.subresourceRange.levelCount      = 1;
+                imageMemoryBarrier.subresourceRange.baseArrayLayer  = 0;
+                imageMemoryBarrier.subresourceRange.layerCount      = 1;
+                imageMemoryBarriers.push_back(imageMemoryBarrier);
+                
+                srcStageMask |= barrier.oldState_.stages_;
+                dstStageMask |= barrier.newState_.stages_;
+            }
+            
+            vkCmdPipelineBarrier(commandBuffer,
+                                 srcStageMask,
+                                 dstStageMask,
+                                 0,
+                                 0,
+                                 nullptr,
+                                 0,
+                                 nullptr,
+                                 static_cast<std::uint32_t>(imageMemoryBarriers.size()),
+                                 imageMemoryBarriers.data());
         }
         
-        VkPipelineVertexInputStateCreateInfo Pipeline::getVkPipelineVertexInputStateCreateInfo() const noexcept
+        std::vector<const RenderGraph::Attachment*> RenderGraph::getAttachments(const PassDescription& passDescription)
         {
-            VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{};
-            pipelineVertexInputStateCreateInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            pipelineVertexInputStateCreateInfo.pNext                           = nullptr;
-            pipelineVertexInputStateCreateInfo.flags                           = 0;
-            pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount   = 0;
-            pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions      = nullptr;
-            pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = 0;
-            pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions    = nullptr;
-            return pipelineVertexInputStateCreateInfo;
+            std::vector<const Attachment*> attachments;
+            for (const Attachment& attachment : passDescription.colorAttachments_)
+                attachments.push_back(&attachment);
+            if (passDescription.depthAttachment_.has_value())
+                attachments.push_back(&passDescription.depthAttachment_.value());
+            return attachments;
         }
         
-        VkPipelineInputAssemblyStateCreateInfo Pipeline::getVkPipelineInputAssemblyStateCreateInfo() const noexcept
+#pragma mark - mgo::vk::RenderQueue
+        RenderQueue::RenderQueue(std::uint32_t threadCount)
+        :
+        skipDigit_(false),
+        threadCount_(threadCount > 0 ? threadCount : jobs::Scheduler::get().getThreadCount())
         {
-            VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{};
-            pipelineInputAssemblyStateCreateInfo.sType                    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-            pipelineInputAssemblyStateCreateInfo.pNext                    = nullptr;
-            pipelineInputAssemblyStateCreateInfo.flags                    = 0;
-            pipelineInputAssemblyStateCreateInfo.topology                 = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-            pipelineInputAssemblyStateCreateInfo.primitiveRestartEnable   = VK_FALSE;
-            return pipelineInputAssemblyStateCreateInfo;
         }
         
-        VkPipelineViewportStateCreateInfo Pipeline::getVkPipelineViewportStateCreateInfo() const noexcept
+        RenderQueue::SortKey RenderQueue::makeKey(std::uint32_t pass, std::uint32_t pipeline, std::uint32_t material, std::uint32_t mesh, float depth) noexcept
         {
-            VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo{};
-            pipelineViewportStateCreateInfo.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-            pipelineViewportStateCreateInfo.pNext         = nullptr;
-            pipelineViewportStateCreateInfo.flags         = 0;
-            pipelineViewportStateCreateInfo.viewportCount = 1;
-            pipelineViewportStateCreateInfo.pViewports    = nullptr;
-            pipelineViewportStateCreateInfo.scissorCount  = 1;
-            pipelineViewportStateCreateInfo.pScissors     = nullptr;
-            return pipelineViewportStateCreateInfo;
+            constexpr SortKey DEPTH_MAX = (SortKey(1) << DEPTH_BITS) - 1;
+            SortKey depthBits = static_cast<SortKey>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(DEPTH_MAX));
+            
+            SortKey key = pass & ((1u << PASS_BITS) - 1);
+            key = (key << PIPELINE_BITS) | (pipeline & ((1u << PIPELINE_BITS) - 1));
+            key = (key << MATERIAL_BITS) | (material & ((1u << MATERIAL_BITS) - 1));
+            key = (key << MESH_BITS) | (mesh & ((1u << MESH_BITS) - 1));
+            key = (key << DEPTH_BITS) | depthBits;
+            return key;
         }
         
-        VkPipelineRasterizationStateCreateInfo Pipeline::getVkPipelineRasterizationStateCreateInfo() const noexcept
+        void RenderQueue::clear() noexcept
         {
-            VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo{};
-            pipelineRasterizationStateCreateInfo.sType                    = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-            pipelineRasterizationStateCreateInfo.pNext                    = nullptr;
-            pipelineRasterizationStateCreateInfo.flags                    = 0;
-            pipelineRasterizationStateCreateInfo.depthClampEnable         = VK_FALSE;
-            pipelineRasterizationStateCreateInfo.rasterizerDiscardEnable  = VK_FALSE;
-            pipelineRasterizationStateCreateInfo.polygonMode              = VK_POLYGON_MODE_FILL;
-            pipelineRasterizationStateCreateInfo.cullMode                 = VK_CULL_MODE_BACK_BIT;
-            pipelineRasterizationStateCreateInfo.frontFace                = VK_FRONT_FACE_CLOCKWISE;
-            pipelineRasterizationStateCreateInfo.depthBiasEnable          = VK_FALSE;
-            pipelineRasterizationStateCreateInfo.depthBiasConstantFactor  = 0.0f;
-            pipelineRasterizationStateCreateInfo.depthBiasClamp           = 0.0f;
-            pipelineRasterizationStateCreateInfo.depthBiasSlopeFactor     = 0.0f;
-            pipelineRasterizationStateCreateInfo.lineWidth                = 1.0f;
-            return pipelineRasterizationStateCreateInfo;
+            this->keys_.clear();
         }
         
-        VkPipelineMultisampleStateCreateInfo Pipeline::getVkPipelineMultisampleStateCreateInfo() const noexcept
+        void RenderQueue::push(SortKey key)
         {
-            VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo{};
-            pipelineMultisampleStateCreateInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-            pipelineMultisampleStateCreateInfo.pNext                  = nullptr;
-            pipelineMultisampleStateCreateInfo.flags                  = 0;
-            pipelineMultisampleStateCreateInfo.rasterizationSamples   = VK_SAMPLE_COUNT_1_BIT;
-            pipelineMultisampleStateCreateInfo.sampleShadingEnable    = VK_FALSE;
-            pipelineMultisampleStateCreateInfo.minSampleShading       = 0.0f;
-            pipelineMultisampleStateCreateInfo.pSampleMask            = nullptr;
-            pipelineMultisampleStateCreateInfo.alphaToCoverageEnable  = VK_FALSE;
-            pipelineMultisampleStateCreateInfo.alphaToOneEnable       = VK_FALSE;
-            return pipelineMultisampleStateCreateInfo;
+            this->keys_.push_back(key);
         }
         
-        VkPipelineColorBlendAttachmentState Pipeline::getVkPipelineColorBlendAttachmentState() const noexcept
+        void RenderQueue::sort()
         {
-            VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
-            pipelineColorBlendAttachmentState.blendEnable            = VK_FALSE;
-            pipelineColorBlendAttachmentState.srcColorBlendFactor    = VK_BLEND_FACTOR_ZERO;
-            pipelineColorBlendAttachmentState.dstColorBlendFactor    = VK_BLEND_FACTOR_ZERO;
-            pipelineColorBlendAttachmentState.colorBlendOp           = VK_BLEND_OP_ADD;
-            pipelineColorBlendAttachmentState.srcAlphaBlendFactor    = VK_BLEND_FACTOR_ZERO;
-            pipelineColorBlendAttachmentState.dstAlphaBlendFactor    = VK_BLEND_FACTOR_ZERO;
-            pipelineColorBlendAttachmentState.alphaBlendOp           = VK_BLEND_OP_ADD;
-            pipelineColorBlendAttachmentState.colorWriteMask         = VK_COLOR_COMPONENT_R_BIT;
-            pipelineColorBlendAttachmentState.colorWriteMask        |= VK_COLOR_COMPONENT_G_BIT;
-            pipelineColorBlendAttachmentState.colorWriteMask        |= VK_COLOR_COMPONENT_B_BIT;
-            pipelineColorBlendAttachmentState.colorWriteMask        |= VK_COLOR_COMPONENT_A_BIT;
-            return pipelineColorBlendAttachmentState;
+            trace::Scope scope("RenderQueue::sort");
+            const std::size_t count = this->keys_.size();
+            this->order_.resize(count);
+            std::iota(this->order_.begin(), this->order_.end(), 0u);
+            this->scratchKeys_.resize(count);
+            this->scratchOrder_.resize(count);
+            
+            // Small queues are not worth splitting into jobs.
+            const std::size_t batchCount = std::clamp(count / MIN_KEYS_PER_THREAD, static_cast<std::size_t>(1), static_cast<std::size_t>(this->threadCount_));
+            this->histograms_.resize(batchCount);
+            
+            // Least significant digit first; every pass is stable, so equal keys keep their submission order.
+            jobs::Scheduler& scheduler = jobs::Scheduler::get();
+            for (std::uint32_t shift = 0; shift < 64; shift += RADIX_BITS)
+            {
+                auto countBatches = [this, count, batchCount, shift](std::size_t firstBatch, std::size_t lastBatch)
+                {
+                    for (std::size_t batch = firstBatch; batch < lastBatch; batch++)
+                    {
+                        std::array<std::size_t, RADIX_SIZE>& histogram = this->histograms_[batch];
+                        histogram.fill(0);
+                        for (std::size_t i = count * batch / batchCount; i < count * (batch + 1) / batchCount; i++)
+                            histogram[(this->keys_[i] >> shift) & (RADIX_SIZE - 1)]++;
+                    }
+                };
+                scheduler.parallelFor(batchCount, 1, countBatches);
+                
+                this->computeOffsets();
+                if (this->skipDigit_)
+                    continue;
+                
+                auto scatterBatches = [this, count, batchCount, shift](std::size_t firstBatch, std::size_t lastBatch)
+                {
+                    for (std::size_t batch = firstBatch; batch < lastBatch; batch++)
+                    {
+                        std::array<std::size_t, RADIX_SIZE>& histogram = this->histograms_[batch];
+                        for (std::size_t i = count * batch / batchCount; i < count * (batch + 1) / batchCount; i++)
+                        {
+                            std::size_t destination = histogram[(this->keys_[i] >> shift) & (RADIX_SIZE - 1)]++;
+                            this->scratchKeys_[destination] = this->keys_[i];
+                            this->scratchOrder_[destination] = this->order_[i];
+                        }
+                    }
+                };
+                scheduler.parallelFor(batchCount, 1, scatterBatches);
+                
+                std::swap(this->keys_, this->scratchKeys_);
+                std::swap(this->order_, this->scratchOrder_);
+            }
         }
         
-        VkPipelineColorBlendStateCreateInfo
-        Pipeline::getVkPipelineColorBlendStateCreateInfo(const std::vector<VkPipelineColorBlendAttachmentState>& attachments) const noexcept
+        const std::vector<std::uint32_t>& RenderQueue::getOrder() const noexcept
         {
-            VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{};
-            pipelineColorBlendStateCreateInfo.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-            pipelineColorBlendStateCreateInfo.pNext             = nullptr;
-            pipelineColorBlendStateCreateInfo.flags             = 0;
-            pipelineColorBlendStateCreateInfo.logicOpEnable     = VK_FALSE;
-            pipelineColorBlendStateCreateInfo.logicOp           = VK_LOGIC_OP_COPY;
-            pipelineColorBlendStateCreateInfo.attachmentCount   = static_cast<std::uint32_t>(attachments.size());
-            pipelineColorBlendStateCreateInfo.pAttachments      = attachments.data();
-            pipelineColorBlendStateCreateInfo.blendConstants[0] = 0.0f;
-            pipelineColorBlendStateCreateInfo.blendConstants[1] = 0.0f;
-            pipelineColorBlendStateCreateInfo.blendConstants[2] = 0.0f;
-            pipelineColorBlendStateCreateInfo.blendConstants[3] = 0.0f;
-            return pipelineColorBlendStateCreateInfo;
+            return this->order_;
         }
         
-        VkPipelineDynamicStateCreateInfo Pipeline::getVkPipelineDynamicStateCreateInfo(const std::vector<VkDynamicState>& dynamicStates) const noexcept
+        std::size_t RenderQueue::size() const noexcept
         {
-            VkPipelineDynamicStateCreateInfo pipelineDynamicStateCreateInfo{};
-            pipelineDynamicStateCreateInfo.sType              = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-            pipelineDynamicStateCreateInfo.pNext              = nullptr;
-            pipelineDynamicStateCreateInfo.flags              = 0;
-            pipelineDynamicStateCreateInfo.dynamicStateCount  = static_cast<std::uint32_t>(dynamicStates.size());
-            pipelineDynamicStateCreateInfo.pDynamicStates     = dynamicStates.data();
-            return pipelineDynamicStateCreateInfo;
+            return this->keys_.size();
         }
         
-#pragma mark - mgo::vk::CommandPool
-        CommandPool::CommandPool(const PhysicalDevice& physicalDevice, const Device& device)
+        void RenderQueue::computeOffsets() noexcept
+        {
+            // A digit shared by every key would only copy the keys, so its scatter is skipped.
+            this->skipDigit_ = false;
+            std::size_t offset = 0;
+            for (std::size_t digit = 0; digit < RADIX_SIZE; digit++)
+            {
+                std::size_t digitCount = 0;
+                for (auto& histogram : this->histograms_)
+                {
+                    std::size_t threadCount = histogram[digit];
+                    histogram[digit] = offset + digitCount;
+                    digitCount += threadCount;
+                }
+                if (digitCount == this->keys_.size())
+                    this->skipDigit_ = true;
+                offset += digitCount;
+            }
+        }
+        
+#pragma mark - mgo::vk::ParallelRecorder
+        ParallelRecorder::ParallelRecorder(const Device& device, std::uint32_t framesInFlight, std::uint32_t workerCount)
         :
-        physicalDevice_(physicalDevice),
+        commandPools_(framesInFlight),
+        commandBuffers_(framesInFlight),
+        pRecordFunction_(nullptr),
+        inheritanceInfo_{},
+        frame_(0),
+        drawCount_(0),
+        chunkCount_(0),
+        workerCount_(workerCount > 0 ? workerCount : jobs::Scheduler::get().getThreadCount()),
         device_(device)
         {
-            VkCommandPoolCreateInfo commandPoolCreateInfo{};
-            commandPoolCreateInfo.sType               = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-            commandPoolCreateInfo.pNext               = nullptr;
-            commandPoolCreateInfo.flags               = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-            commandPoolCreateInfo.queueFamilyIndex    = this->physicalDevice_.getQueueFamilyIndices().graphicsFamily_.value();
+            // Every chunk owns one pool per frame, and a chunk is recorded by one job, so no pool is shared across threads.
+            for (std::uint32_t frame = 0; frame < framesInFlight; frame++)
+            {
+                this->commandPools_[frame].resize(this->workerCount_);
+                this->commandBuffers_[frame].resize(this->workerCount_);
+                
+                for (std::uint32_t worker = 0; worker < this->workerCount_; worker++)
+                {
+                    VkCommandPoolCreateInfo commandPoolCreateInfo{};
+                    commandPoolCreateInfo.sType               = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                    commandPoolCreateInfo.pNext               = nullptr;
+                    commandPoolCreateInfo.flags               = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                    commandPoolCreateInfo.queueFamilyIndex    = this->device_.getPhysicalDevice().getQueueFamilyIndex(PhysicalDevice::QueueType::GRAPHICS);
+                    
+                    if (vkCreateCommandPool(this->device_.get(), &commandPoolCreateInfo, nullptr, &this->commandPools_[frame][worker]) != VK_SUCCESS)
+                        throw std::runtime_error("Failed to create mgo::vk::ParallelRecorder!");
+                    
+                    VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+                    commandBufferAllocateInfo.sType               = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                    commandBufferAllocateInfo.pNext               = nullptr;
+                    commandBufferAllocateInfo.commandPool         = this->commandPools_[frame][worker];
+                    commandBufferAllocateInfo.level               = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                    commandBufferAllocateInfo.commandBufferCount  = 1;
+                    
+                    if (vkAllocateCommandBuffers(this->device_.get(), &commandBufferAllocateInfo, &this->commandBuffers_[frame][worker]) != VK_SUCCESS)
+                        throw std::runtime_error("Failed to allocate mgo::vk::ParallelRecorder command buffer!");
+                }
+            }
+        }
+        
+        ParallelRecorder::~ParallelRecorder() noexcept
+        {
+            for (auto& framePools : this->commandPools_)
+                for (VkCommandPool commandPool : framePools)
+                    vkDestroyCommandPool(this->device_.get(), commandPool, nullptr);
+        }
+        
+        void ParallelRecorder::reset(std::uint32_t frame) const noexcept
+        {
+            for (VkCommandPool commandPool : this->commandPools_[frame])
+                vkResetCommandPool(this->device_.get(), commandPool, 0);
+        }
+        
+        std::vector<VkCommandBuffer> ParallelRecorder::record(std::uint32_t frame,
+                                                              const VkCommandBufferInheritanceInfo& inheritanceInfo,
+                                                              std::size_t drawCount,
+                                                              const RecordFunction& recordFunction)
+        {
+            // Small draw lists are not worth splitting into jobs.
+            std::size_t chunkCount = (drawCount + MIN_DRAWS_PER_WORKER - 1) / MIN_DRAWS_PER_WORKER;
+            chunkCount = std::clamp(chunkCount, static_cast<std::size_t>(1), static_cast<std::size_t>(this->workerCount_));
             
-            if (vkCreateCommandPool(this->device_.get(), &commandPoolCreateInfo, nullptr, &this->commandPool_) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create mgo::vk::CommandPool!");
+            this->pRecordFunction_ = &recordFunction;
+            this->inheritanceInfo_ = inheritanceInfo;
+            this->frame_ = frame;
+            this->drawCount_ = drawCount;
+            this->chunkCount_ = chunkCount;
+            this->exception_ = nullptr;
+            
+            // The calling thread records the first chunk itself, the scheduler's workers take the rest.
+            jobs::Scheduler::get().parallelFor(chunkCount, 1, [this](std::size_t firstChunk, std::size_t lastChunk)
+            {
+                for (std::size_t chunk = firstChunk; chunk < lastChunk; chunk++)
+                    this->recordChunk(static_cast<std::uint32_t>(chunk));
+            });
+            
+            if (this->exception_)
+                std::rethrow_exception(this->exception_);
+            
+            return std::vector<VkCommandBuffer>(this->commandBuffers_[frame].begin(),
+                                                this->commandBuffers_[frame].begin() + static_cast<std::ptrdiff_t>(chunkCount));
         }
         
-        CommandPool::~CommandPool() noexcept
+        std::uint32_t ParallelRecorder::getWorkerCount() const noexcept
         {
-            vkDestroyCommandPool(this->device_.get(), this->commandPool_, nullptr);
+            return this->workerCount_;
         }
         
-        const VkCommandPool& CommandPool::get() const noexcept
+        void ParallelRecorder::recordChunk(std::uint32_t workerIndex) noexcept
         {
-            return this->commandPool_;
+            trace::Scope scope("ParallelRecorder::recordChunk");
+            VkCommandBuffer commandBuffer = this->commandBuffers_[this->frame_][workerIndex];
+            std::size_t firstDraw = this->drawCount_ * workerIndex / this->chunkCount_;
+            std::size_t lastDraw = this->drawCount_ * (workerIndex + 1) / this->chunkCount_;
+            
+            VkCommandBufferBeginInfo commandBufferBeginInfo{};
+            commandBufferBeginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            commandBufferBeginInfo.pNext            = nullptr;
+            commandBufferBeginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            commandBufferBeginInfo.pInheritanceInfo = &this->inheritanceInfo_;
+            
+            try
+            {
+                if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to begin recording secondary command buffer!");
+                
+                (*this->pRecordFunction_)(commandBuffer, firstDraw, lastDraw);
+                
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to end recording secondary command buffer!");
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->exception_ = std::current_exception();
+            }
         }
         
 #pragma mark - mgo::vk::CommandBuffer
         CommandBuffers::CommandBuffers(glfw::Window& window,
                                        const Device& device,
+                                       QueueTimelines& queueTimelines,
+                                       DeletionQueue& deletionQueue,
                                        Swapchain& swapchain,
-                                       RenderPass& renderPass,
-                                       Framebuffers& framebuffers,
-                                       const Pipeline& pipeline,
-                                       const CommandPool& commandPool)
+                                       RenderGraph& renderGraph,
+                                       const PipelineLayout& pipelineLayout,
+                                       const AsyncPipeline& pipeline,
+                                       const CommandPool& commandPool,
+                                       const VertexBuffer& vertexBuffer,
+                                       const IndexBuffer& indexBuffer,
+                                       const InstanceBuffer& instanceBuffer,
+                                       std::uint32_t framesInFlight,
+                                       std::uint32_t recordingThreadCount)
         :
-        imageAvailableSemaphores_{Semaphore(device), Semaphore(device)},
-        renderFinishedSemaphores_{Semaphore(device), Semaphore(device)},
-        inFlightFences_{Fence(device), Fence(device)},
+        commandBuffers_(std::max(framesInFlight, 1u)),
+        imagesInFlight_(swapchain.getImages().size(), 0),
+        slotFrames_(std::max(framesInFlight, 1u), 0),
+        submittedFrames_(0),
+        completedFrame_(0),
+        pIndirectRenderer_(nullptr),
+        indirectPipeline_(VK_NULL_HANDLE),
+        frameUniformOffset_(0),
+        parallelRecorder_(device, std::max(framesInFlight, 1u), recordingThreadCount),
+        renderQueue_(recordingThreadCount),
+        gpuProfiler_(device, std::max(framesInFlight, 1u)),
         imageIndex_(0),
         currentFrame_(0),
+        framesInFlight_(std::max(framesInFlight, 1u)),
         window_(window),
         device_(device),
+        queueTimelines_(queueTimelines),
+        deletionQueue_(deletionQueue),
         swapchain_(swapchain),
-        renderPass_(renderPass),
-        framebuffers_(framebuffers),
+        renderGraph_(renderGraph),
         commandPool_(commandPool),
-        pipeline_(pipeline)
+        pipelineLayout_(pipelineLayout),
+        pipeline_(pipeline),
+        vertexBuffer_(vertexBuffer),
+        indexBuffer_(indexBuffer),
+        instanceBuffer_(instanceBuffer)
         {
+            for (std::uint32_t i = 0; i < this->framesInFlight_; i++)
+            {
+                this->imageAvailableSemaphores_.emplace_back(std::make_unique<Semaphore>(this->device_));
+                this->renderFinishedSemaphores_.emplace_back(std::make_unique<Semaphore>(this->device_));
+            }
+            
             VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
             commandBufferAllocateInfo.sType               = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
             commandBufferAllocateInfo.pNext               = nullptr;
@@ -1223,57 +5229,133 @@ namespace mgo
                 throw std::runtime_error("Failed to allocate mgo::vk::CommandBuffer!");
         }
         
-        const std::array<VkCommandBuffer, CommandBuffers::MAX_FRAMES_IN_FLIGHT>& CommandBuffers::get() const noexcept
+        const std::vector<VkCommandBuffer>& CommandBuffers::get() const noexcept
         {
             return this->commandBuffers_;
         }
         
+        std::uint32_t CommandBuffers::getFramesInFlight() const noexcept
+        {
+            return this->framesInFlight_;
+        }
+        
         void CommandBuffers::draw()
         {
-            this->inFlightFences_[this->currentFrame_].wait();
-            this->getNextImageIndex();
-            this->inFlightFences_[this->currentFrame_].reset();
-            this->beginCommandBuffer();
-            this->beginRenderPass();
-            this->bindPipline();
-            this->setViewport();
-            this->setScissor();
-            this->drawImage();
-            this->endRenderPass();
-            this->endCommandBuffer();
-            this->submitImage();
-            this->presentImage();
-            this->currentFrame_ = (this->currentFrame_ + 1) % MAX_FRAMES_IN_FLIGHT;
+            trace::Scope drawScope("CommandBuffers::draw");
+            {
+                trace::Scope scope("CommandBuffers::waitForFrame");
+                this->queueTimelines_.wait(PhysicalDevice::QueueType::GRAPHICS, this->slotFrames_[this->currentFrame_]);
+                this->completedFrame_ = this->queueTimelines_.getCompletedValue(PhysicalDevice::QueueType::GRAPHICS);
+                this->releaseRetired();
+            }
+            {
+                trace::Scope scope("CommandBuffers::acquire");
+                if (!this->getNextImageIndex())
+                    return;
+                this->waitForImageInFlight();
+            }
+            {
+                trace::Scope scope("CommandBuffers::record");
+                this->parallelRecorder_.reset(this->currentFrame_);
+                this->beginCommandBuffer();
+                this->gpuProfiler_.beginFrame(this->commandBuffers_[this->currentFrame_], this->currentFrame_);
+                this->renderGraph_.execute(this->commandBuffers_[this->currentFrame_], this->imageIndex_, &this->gpuProfiler_);
+                this->gpuProfiler_.endFrame(this->commandBuffers_[this->currentFrame_]);
+                this->endCommandBuffer();
+            }
+            {
+                trace::Scope scope("CommandBuffers::submit");
+                // Frames are numbered by the graphics timeline value they signal.
+                this->submitImage(this->queueTimelines_.getNextValue(PhysicalDevice::QueueType::GRAPHICS));
+                this->submittedFrames_ = this->queueTimelines_.advance(PhysicalDevice::QueueType::GRAPHICS);
+                this->slotFrames_[this->currentFrame_] = this->submittedFrames_;
+                this->imagesInFlight_[static_cast<std::size_t>(this->imageIndex_)] = this->submittedFrames_;
+                this->waitSemaphores_.clear();
+                this->waitStages_.clear();
+                this->waitValues_.clear();
+            }
+            {
+                trace::Scope scope("CommandBuffers::present");
+                this->presentImage();
+            }
+            this->currentFrame_ = (this->currentFrame_ + 1) % this->framesInFlight_;
+        }
+        
+        void CommandBuffers::waitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage)
+        {
+            this->waitSemaphores_.push_back(semaphore);
+            this->waitStages_.push_back(waitStage);
+            this->waitValues_.push_back(0);
+        }
+        
+        void CommandBuffers::waitTimeline(PhysicalDevice::QueueType queueType, std::uint64_t value, VkPipelineStageFlags waitStage)
+        {
+            this->waitSemaphores_.push_back(this->queueTimelines_.getSemaphore(queueType));
+            this->waitStages_.push_back(waitStage);
+            this->waitValues_.push_back(value);
+        }
+        
+        void CommandBuffers::setDrawCommands(const std::vector<DrawCommand>& drawCommands)
+        {
+            this->drawCommands_ = drawCommands;
+        }
+        
+        void CommandBuffers::setIndirectRenderer(const IndirectRenderer* pIndirectRenderer) noexcept
+        {
+            this->pIndirectRenderer_ = pIndirectRenderer;
+        }
+        
+        void CommandBuffers::setFrameUniformOffset(std::uint32_t frameUniformOffset) noexcept
+        {
+            this->frameUniformOffset_ = frameUniformOffset;
+        }
+        
+        GpuProfiler& CommandBuffers::getGpuProfiler() noexcept
+        {
+            return this->gpuProfiler_;
+        }
+        
+        const GpuProfiler& CommandBuffers::getGpuProfiler() const noexcept
+        {
+            return this->gpuProfiler_;
         }
         
-        void CommandBuffers::getNextImageIndex()
+        bool CommandBuffers::getNextImageIndex()
         {
-            if (this->window_.hasResized())
+            if (this->swapchain_.isHeadless())
             {
-                this->swapchain_.recreate();
-                this->framebuffers_.recreate(this->swapchain_, this->renderPass_);
+                this->imageIndex_ = this->currentFrame_ % static_cast<std::uint32_t>(this->swapchain_.getImages().size());
+                return true;
             }
+            
+            // A minimised window has no extent to create a swapchain with, so frames are skipped until it returns.
+            VkExtent2D framebufferSize = this->window_.GetFramebufferSize();
+            if (framebufferSize.width == 0 || framebufferSize.height == 0)
+                return false;
+            
+            if (this->window_.hasResized() || this->swapchain_.isOutOfDate())
+                this->recreateSwapchain();
                 
             switch (vkAcquireNextImageKHR(this->device_.get(),
                                           this->swapchain_.get(),
                                           UINT64_MAX,
-                                          this->imageAvailableSemaphores_[this->currentFrame_].get(),
+                                          this->imageAvailableSemaphores_[this->currentFrame_]->get(),
                                           VK_NULL_HANDLE,
                                           &this->imageIndex_))
             {
                 case (VK_SUCCESS) :
                 {
-                    break;
+                    return true;
                 };
                 case (VK_SUBOPTIMAL_KHR) :
                 {
-                    break;
+                    return true;
                 };
                 case (VK_ERROR_OUT_OF_DATE_KHR) :
                 {
-                    this->swapchain_.recreate();
-                    this->framebuffers_.recreate(this->swapchain_, this->renderPass_);
-                    break;
+                    // Nothing was acquired; the frame is skipped and the next one acquires from the replacement swapchain.
+                    this->recreateSwapchain();
+                    return false;
                 };
                 default :
                 {
@@ -1282,6 +5364,25 @@ namespace mgo
             }
         }
         
+        void CommandBuffers::waitForImageInFlight()
+        {
+            // An earlier frame slot may still be rendering into this image when images outnumber frames in flight.
+            this->queueTimelines_.wait(PhysicalDevice::QueueType::GRAPHICS, this->imagesInFlight_[static_cast<std::size_t>(this->imageIndex_)]);
+        }
+        
+        void CommandBuffers::recreateSwapchain()
+        {
+            // Old handles stay alive until every frame submitted so far has finished with them.
+            this->swapchain_.recreate(this->submittedFrames_);
+            this->renderGraph_.recreate(this->submittedFrames_);
+            this->imagesInFlight_.assign(this->swapchain_.getImages().size(), 0);
+        }
+        
+        void CommandBuffers::releaseRetired() noexcept
+        {
+            this->deletionQueue_.release(this->completedFrame_);
+        }
+        
         void CommandBuffers::beginCommandBuffer() const
         {
             vkResetCommandBuffer(this->commandBuffers_[this->currentFrame_], 0);
@@ -1296,31 +5397,108 @@ namespace mgo
                 throw std::runtime_error("Failed to begin recording image!");
         }
     
-        void CommandBuffers::beginRenderPass() const noexcept
+        void CommandBuffers::recordScene(const RenderGraph::PassContext& passContext)
         {
-            VkClearValue clearValue{};
-            clearValue.color = {0.0f, 0.0f, 0.0f, 1.0f};
+            VkCommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.pNext                   = nullptr;
+            inheritanceInfo.renderPass              = passContext.renderPass_;
+            inheritanceInfo.subpass                 = 0;
+            inheritanceInfo.framebuffer             = passContext.framebuffer_;
+            inheritanceInfo.occlusionQueryEnable    = VK_FALSE;
+            inheritanceInfo.queryFlags              = 0;
+            inheritanceInfo.pipelineStatistics      = this->gpuProfiler_.getInheritedPipelineStatistics();
+            
+            this->resolvePipelines();
+            this->sortDraws();
+            
+            // Chunks of the draw list are recorded into secondaries in parallel and replayed in order.
+            std::vector<VkCommandBuffer> secondaryCommandBuffers =
+            this->parallelRecorder_.record(this->currentFrame_,
+                                           inheritanceInfo,
+                                           this->drawCommands_.size(),
+                                           [this](VkCommandBuffer commandBuffer, std::size_t firstDraw, std::size_t lastDraw)
+                                           {
+                                               this->recordDraws(commandBuffer, firstDraw, lastDraw);
+                                           });
             
-            VkRenderPassBeginInfo renderPassBeginInfo{};
-            renderPassBeginInfo.sType                   = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassBeginInfo.pNext                   = nullptr;
-            renderPassBeginInfo.renderPass              = this->renderPass_.get();
-            renderPassBeginInfo.framebuffer             = this->framebuffers_.get()[static_cast<std::size_t>(this->imageIndex_)];
-            renderPassBeginInfo.renderArea.offset.x     = 0;
-            renderPassBeginInfo.renderArea.offset.y     = 0;
-            renderPassBeginInfo.renderArea.extent       = this->swapchain_.getVkExtent2D();
-            renderPassBeginInfo.clearValueCount         = 1;
-            renderPassBeginInfo.pClearValues            = &clearValue;
+            vkCmdExecuteCommands(passContext.commandBuffer_,
+                                 static_cast<std::uint32_t>(secondaryCommandBuffers.size()),
+                                 secondaryCommandBuffers.data());
+        }
+        
+        void CommandBuffers::resolvePipelines()
+        {
+            // Pipelines are resolved once on the calling thread before any worker records, so a build landing
+            // mid-frame cannot leave some chunks on the fallback and others on the final pipeline.
+            this->drawPipelines_.resize(this->drawCommands_.size());
+            for (std::size_t i = 0; i < this->drawCommands_.size(); i++)
+                this->drawPipelines_[i] = this->drawCommands_[i].pPipeline_ != nullptr ? this->drawCommands_[i].pPipeline_->get() : this->pipeline_.get();
+            this->indirectPipeline_ = this->pipeline_.get();
+        }
+        
+        void CommandBuffers::sortDraws()
+        {
+            // Pipelines, materials and meshes get dense ids in order of first use, so distinct state never shares a key
+            // field until a frame uses more of them than the field can count.
+            this->pipelineIds_.clear();
+            this->materialIds_.clear();
+            this->meshIds_.clear();
+            this->renderQueue_.clear();
+            for (std::size_t i = 0; i < this->drawCommands_.size(); i++)
+            {
+                const DrawCommand& drawCommand = this->drawCommands_[i];
+                std::uint32_t pipelineId = this->pipelineIds_.try_emplace(this->drawPipelines_[i], static_cast<std::uint32_t>(this->pipelineIds_.size())).first->second;
+                std::uint32_t materialId = this->materialIds_.try_emplace(drawCommand.resourceIndices_, static_cast<std::uint32_t>(this->materialIds_.size())).first->second;
+                std::uint32_t meshId = this->meshIds_.try_emplace(std::make_pair(drawCommand.instanceBuffer_, drawCommand.instanceOffset_),
+                                                                  static_cast<std::uint32_t>(this->meshIds_.size())).first->second;
+                
+                this->renderQueue_.push(RenderQueue::makeKey(drawCommand.pass_, pipelineId, materialId, meshId, drawCommand.depth_));
+            }
+            this->renderQueue_.sort();
+        }
+        
+        void CommandBuffers::recordDraws(VkCommandBuffer commandBuffer, std::size_t firstDraw, std::size_t lastDraw) const noexcept
+        {
+            // Secondaries inherit no bindings, so each binds the bindless set once.
+            this->pipelineLayout_.bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+            this->bindVertexBuffers(commandBuffer);
+            this->bindIndexBuffer(commandBuffer);
+            this->setViewport(commandBuffer);
+            this->setScissor(commandBuffer);
+            this->drawImage(commandBuffer, firstDraw, lastDraw);
             
-            vkCmdBeginRenderPass(this->commandBuffers_[this->currentFrame_], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            // The GPU-culled draws cost one command however many objects there are, so the first chunk issues them.
+            if (firstDraw == 0 && this->pIndirectRenderer_ != nullptr)
+            {
+                this->bindInstanceBuffer(commandBuffer, this->instanceBuffer_.get(), 0);
+                this->pIndirectRenderer_->draw(commandBuffer, this->indirectPipeline_, this->frameUniformOffset_);
+            }
+        }
+        
+        void CommandBuffers::bindPipline(VkCommandBuffer commandBuffer, VkPipeline pipeline) const noexcept
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        }
+        
+        void CommandBuffers::bindVertexBuffers(VkCommandBuffer commandBuffer) const noexcept
+        {
+            std::array<VkBuffer, 2> buffers = {this->vertexBuffer_.get(), this->instanceBuffer_.get()};
+            std::array<VkDeviceSize, 2> offsets = {0, 0};
+            vkCmdBindVertexBuffers(commandBuffer, 0, static_cast<std::uint32_t>(buffers.size()), buffers.data(), offsets.data());
         }
         
-        void CommandBuffers::bindPipline() const noexcept
+        void CommandBuffers::bindInstanceBuffer(VkCommandBuffer commandBuffer, VkBuffer instanceBuffer, VkDeviceSize instanceOffset) const noexcept
         {
-            vkCmdBindPipeline(this->commandBuffers_[this->currentFrame_], VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline_.get());
+            vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &instanceOffset);
+        }
+        
+        void CommandBuffers::bindIndexBuffer(VkCommandBuffer commandBuffer) const noexcept
+        {
+            vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer_.get(), 0, this->indexBuffer_.getVkIndexType());
         }
     
-        void CommandBuffers::setViewport() const noexcept
+        void CommandBuffers::setViewport(VkCommandBuffer commandBuffer) const noexcept
         {
             VkViewport viewport{};
             viewport.x          = 0.0f;
@@ -1330,26 +5508,65 @@ namespace mgo
             viewport.minDepth   = 0.0f;
             viewport.maxDepth   = 1.0f;
             
-            vkCmdSetViewport(this->commandBuffers_[this->currentFrame_], 0, 1, &viewport);
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
         }
     
-        void CommandBuffers::setScissor() const noexcept
+        void CommandBuffers::setScissor(VkCommandBuffer commandBuffer) const noexcept
         {
             VkRect2D scissor{};
             scissor.offset.x    = 0;
             scissor.offset.y    = 0;
             scissor.extent      = this->swapchain_.getVkExtent2D();
-            vkCmdSetScissor(this->commandBuffers_[this->currentFrame_], 0, 1, &scissor);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
         }
         
-        void CommandBuffers::drawImage() const noexcept
-        {
-            vkCmdDraw(this->commandBuffers_[this->currentFrame_], 3, 1, 0, 0);
-        }
-    
-        void CommandBuffers::endRenderPass() const noexcept
+        void CommandBuffers::drawImage(VkCommandBuffer commandBuffer, std::size_t firstDraw, std::size_t lastDraw) const noexcept
         {
-            vkCmdEndRenderPass(this->commandBuffers_[this->currentFrame_]);
+            // Draws arrive grouped by pipeline, material and mesh, so each piece of state is rebound only where it changes.
+            VkPipeline boundPipeline = VK_NULL_HANDLE;
+            const std::array<BindlessDescriptors::Handle, 4>* pPushedResourceIndices = nullptr;
+            const DrawCommand* pBoundFrameData = nullptr;
+            VkBuffer boundInstanceBuffer = this->instanceBuffer_.get();
+            VkDeviceSize boundInstanceOffset = 0;
+            for (std::size_t position = firstDraw; position < lastDraw; position++)
+            {
+                const std::size_t i = this->renderQueue_.getOrder()[position];
+                if (this->drawPipelines_[i] != boundPipeline)
+                {
+                    boundPipeline = this->drawPipelines_[i];
+                    this->bindPipline(commandBuffer, boundPipeline);
+                }
+                
+                if (pPushedResourceIndices == nullptr || *pPushedResourceIndices != this->drawCommands_[i].resourceIndices_)
+                {
+                    pPushedResourceIndices = &this->drawCommands_[i].resourceIndices_;
+                    this->pipelineLayout_.pushConstants(commandBuffer, 0, sizeof(*pPushedResourceIndices), pPushedResourceIndices->data());
+                }
+                
+                if (pBoundFrameData == nullptr ||
+                    pBoundFrameData->uniformOffset_ != this->drawCommands_[i].uniformOffset_ ||
+                    pBoundFrameData->storageOffset_ != this->drawCommands_[i].storageOffset_)
+                {
+                    pBoundFrameData = &this->drawCommands_[i];
+                    const std::uint32_t uniformOffset = pBoundFrameData->uniformOffset_ == DrawCommand::FRAME_UNIFORM_OFFSET ? this->frameUniformOffset_ : pBoundFrameData->uniformOffset_;
+                    this->pipelineLayout_.bindFrameData(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, uniformOffset, pBoundFrameData->storageOffset_);
+                }
+                
+                VkBuffer instanceBuffer = this->drawCommands_[i].instanceBuffer_ != VK_NULL_HANDLE ? this->drawCommands_[i].instanceBuffer_ : this->instanceBuffer_.get();
+                if (instanceBuffer != boundInstanceBuffer || this->drawCommands_[i].instanceOffset_ != boundInstanceOffset)
+                {
+                    boundInstanceBuffer = instanceBuffer;
+                    boundInstanceOffset = this->drawCommands_[i].instanceOffset_;
+                    this->bindInstanceBuffer(commandBuffer, boundInstanceBuffer, boundInstanceOffset);
+                }
+                
+                vkCmdDrawIndexed(commandBuffer,
+                                 this->drawCommands_[i].indexCount_,
+                                 this->drawCommands_[i].instanceCount_,
+                                 this->drawCommands_[i].firstIndex_,
+                                 this->drawCommands_[i].vertexOffset_,
+                                 this->drawCommands_[i].firstInstance_);
+            }
         }
     
         void CommandBuffers::endCommandBuffer() const
@@ -1358,34 +5575,62 @@ namespace mgo
                 throw std::runtime_error("Failed to end recording image!");
         }
         
-        void CommandBuffers::submitImage() const
+        void CommandBuffers::submitImage(std::uint64_t signalValue) const
         {
-            VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            std::vector<VkSemaphore> waitSemaphores = this->waitSemaphores_;
+            std::vector<VkPipelineStageFlags> waitStages = this->waitStages_;
+            std::vector<std::uint64_t> waitValues = this->waitValues_;
+            if (!this->swapchain_.isHeadless())
+            {
+                waitSemaphores.push_back(this->imageAvailableSemaphores_[this->currentFrame_]->get());
+                waitStages.push_back(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+                waitValues.push_back(0);
+            }
+            
+            // Binary semaphores ignore their entry in the value arrays.
+            std::vector<VkSemaphore> signalSemaphores = {this->queueTimelines_.getSemaphore(PhysicalDevice::QueueType::GRAPHICS)};
+            std::vector<std::uint64_t> signalValues = {signalValue};
+            if (!this->swapchain_.isHeadless())
+            {
+                signalSemaphores.push_back(this->renderFinishedSemaphores_[this->currentFrame_]->get());
+                signalValues.push_back(0);
+            }
+            
+            VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo{};
+            timelineSemaphoreSubmitInfo.sType                       = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineSemaphoreSubmitInfo.pNext                       = nullptr;
+            timelineSemaphoreSubmitInfo.waitSemaphoreValueCount     = static_cast<std::uint32_t>(waitValues.size());
+            timelineSemaphoreSubmitInfo.pWaitSemaphoreValues        = waitValues.data();
+            timelineSemaphoreSubmitInfo.signalSemaphoreValueCount   = static_cast<std::uint32_t>(signalValues.size());
+            timelineSemaphoreSubmitInfo.pSignalSemaphoreValues      = signalValues.data();
             
             VkSubmitInfo submitInfo{};
             submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            submitInfo.pNext                = nullptr;
-            submitInfo.waitSemaphoreCount   = 1;
-            submitInfo.pWaitSemaphores      = &this->imageAvailableSemaphores_[this->currentFrame_].get();
-            submitInfo.pWaitDstStageMask    = &waitStage;
+            submitInfo.pNext                = &timelineSemaphoreSubmitInfo;
+            submitInfo.waitSemaphoreCount   = static_cast<std::uint32_t>(waitSemaphores.size());
+            submitInfo.pWaitSemaphores      = waitSemaphores.data();
+            submitInfo.pWaitDstStageMask    = waitStages.data();
             submitInfo.commandBufferCount   = 1;
             submitInfo.pCommandBuffers      = &this->commandBuffers_[this->currentFrame_];
-            submitInfo.signalSemaphoreCount = 1;
-            submitInfo.pSignalSemaphores    = &this->renderFinishedSemaphores_[this->currentFrame_].get();
+            submitInfo.signalSemaphoreCount = static_cast<std::uint32_t>(signalSemaphores.size());
+            submitInfo.pSignalSemaphores    = signalSemaphores.data();
             
-            if (vkQueueSubmit(this->device_.getGraphicsQueue(), 1, &submitInfo, this->inFlightFences_[this->currentFrame_].get()) != VK_SUCCESS)
+            if (vkQueueSubmit(this->device_.getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
                 throw std::runtime_error("Failed to submit image!");
         }
         
         void CommandBuffers::presentImage()
         {
+            if (this->swapchain_.isHeadless())
+                return;
+            
             VkResult queuePresentResult;
             
             VkPresentInfoKHR presentInfo{};
             presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
             presentInfo.pNext              = nullptr;
             presentInfo.waitSemaphoreCount = 1;
-            presentInfo.pWaitSemaphores    = &this->renderFinishedSemaphores_[this->currentFrame_].get();
+            presentInfo.pWaitSemaphores    = &this->renderFinishedSemaphores_[this->currentFrame_]->get();
             presentInfo.swapchainCount     = 1;
             presentInfo.pSwapchains        = &this->swapchain_.get();
             presentInfo.pImageIndices      = &this->imageIndex_;
@@ -1399,14 +5644,12 @@ namespace mgo
                 };
                 case (VK_SUBOPTIMAL_KHR) :
                 {
-                    this->swapchain_.recreate();
-                    this->framebuffers_.recreate(this->swapchain_, this->renderPass_);
+                    this->recreateSwapchain();
                     break;
                 };
                 case (VK_ERROR_OUT_OF_DATE_KHR) :
                 {
-                    this->swapchain_.recreate();
-                    this->framebuffers_.recreate(this->swapchain_, this->renderPass_);
+                    this->recreateSwapchain();
                     break;
                 };
                 default :
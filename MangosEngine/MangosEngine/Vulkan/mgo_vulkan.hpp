@@ -1,14 +1,38 @@
 #pragma once
 #include "mgo_glfw.hpp"
+#include "mgo_trace.hpp"
+#include "mgo_jobs.hpp"
 #include <vulkan/vulkan.h>
 #include <map>
+#include <tuple>
 #include <set>
 #include <fstream>
+#include <filesystem>
 #include <array>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <bit>
+#include <algorithm>
+#include <thread>
+#include <future>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <numeric>
+#include <atomic>
+#include <limits>
 namespace mgo
 {
     namespace vk
     {
+#pragma mark - mgo::vk::hashBytes
+        std::uint64_t hashBytes(const void* pData, std::size_t size) noexcept;
+        
 #pragma mark - mgo::vk::Instance
         class Instance final
         {
@@ -67,6 +91,35 @@ namespace mgo
                                                       const VkAllocationCallbacks* pAllocator) noexcept;
         };
         
+#pragma mark - mgo::vk::PresentPolicy
+        class PresentPolicy final
+        {
+        public:
+            enum class Mode
+            {
+                UNCAPPED,
+                VSYNC,
+                RELAXED_VSYNC,
+                MAILBOX
+            };
+            
+        private:
+            std::vector<Mode> preferences_;
+            
+        public:
+            PresentPolicy(Mode mode = Mode::MAILBOX);
+            
+            PresentPolicy(const std::vector<Mode>& preferences);
+            
+            const std::vector<Mode>& getPreferences() const noexcept;
+            
+            VkPresentModeKHR select(const std::vector<VkPresentModeKHR>& availablePresentModes) const noexcept;
+            
+            bool operator==(const PresentPolicy& other) const noexcept;
+            
+            static VkPresentModeKHR getVkPresentModeKHR(Mode mode) noexcept;
+        };
+        
 #pragma mark - mgo::vk::Surface
         class PhysicalDevice;
         class Surface final
@@ -88,19 +141,30 @@ namespace mgo
             
             VkSurfaceFormatKHR getVkSurfaceFormatKHR(const PhysicalDevice& physicalDevice) const noexcept;
             
-            VkPresentModeKHR getVkPresentModeKHR(const PhysicalDevice& physicalDevice) const noexcept;
+            VkPresentModeKHR getVkPresentModeKHR(const PhysicalDevice& physicalDevice, const PresentPolicy& presentPolicy) const noexcept;
             
             VkExtent2D getVkExtent2D(const PhysicalDevice& physicalDevice) const noexcept;
+            
+            bool isHeadless() const noexcept;
         };
         
 #pragma mark - mgo::vk::PhysicalDevice
         class PhysicalDevice final
         {
         public:
+            enum class QueueType
+            {
+                GRAPHICS,
+                TRANSFER,
+                COMPUTE
+            };
+            
             struct QueueFamilyIndices
             {
                 std::optional<std::uint32_t> graphicsFamily_;
                 std::optional<std::uint32_t> presentFamily_;
+                std::optional<std::uint32_t> transferFamily_;
+                std::optional<std::uint32_t> computeFamily_;
                 float priority_;
             };
             
@@ -113,28 +177,49 @@ namespace mgo
         private:
             VkPhysicalDevice physicalDevice_;
             QueueFamilyIndices queueFamilyIndices_;
-            const std::vector<const char*> extensions_;
+            const bool allowCpuDevice_;
             const Instance& instance_;
             const Surface& surface_;
+            const std::vector<const char*> extensions_;
             
         public:
-            PhysicalDevice(const Instance& instance, const Surface& surface);
+            PhysicalDevice(const Instance& instance, const Surface& surface, bool allowCpuDevice = false);
                         
             const VkPhysicalDevice& get() const noexcept;
             
             std::vector<const char*> getExtensions() const noexcept;
             
+            std::vector<const char*> getOptionalExtensions() const noexcept;
+            
+            bool isExtensionSupported(const char* extension) const noexcept;
+            
             QueueFamilyIndices getQueueFamilyIndices() const noexcept;
             
             UniqueQueueFamilyIndices getUniqueQueueFamilyIndices() const noexcept;
             
+            std::uint32_t getQueueFamilyIndex(QueueType queueType) const noexcept;
+            
             VkPhysicalDeviceFeatures getPhysicalDeviceFeatures() const noexcept;
             
+            VkPhysicalDeviceTimelineSemaphoreFeatures getTimelineSemaphoreFeatures() const noexcept;
+            
+            VkPhysicalDeviceDescriptorIndexingFeatures getDescriptorIndexingFeatures() const noexcept;
+            
+            VkPhysicalDeviceProperties getPhysicalDeviceProperties() const noexcept;
+            
+            VkPhysicalDeviceDescriptorIndexingProperties getDescriptorIndexingProperties() const noexcept;
+            
+            VkPhysicalDeviceMemoryProperties getPhysicalDeviceMemoryProperties() const noexcept;
+            
+            std::uint32_t findMemoryTypeIndex(std::uint32_t memoryTypeBits, VkMemoryPropertyFlags memoryPropertyFlags) const;
+            
         private:
             std::uint8_t rankPhysicalDevices(VkPhysicalDevice physicalDevice) const noexcept;
             
             bool checkPhysicalDeviceExtensionSupport(VkPhysicalDevice physicalDevice, bool logResults) const noexcept;
             
+            bool checkPhysicalDeviceFeatureSupport(VkPhysicalDevice physicalDevice) const noexcept;
+            
             QueueFamilyIndices findQueueFamilyIndices(VkPhysicalDevice physicalDevice,
                                                       VkSurfaceKHR surface,
                                                       float queuePriority) const noexcept;
@@ -147,6 +232,8 @@ namespace mgo
             VkDevice device_;
             VkQueue graphicsQueue_;
             VkQueue presentQueue_;
+            VkQueue transferQueue_;
+            VkQueue computeQueue_;
             const Instance& instance_;
             const Surface& surface_;
             const PhysicalDevice& physicalDevice_;
@@ -162,12 +249,192 @@ namespace mgo
             
             const VkQueue& getPresentQueue() const noexcept;
             
+            const VkQueue& getTransferQueue() const noexcept;
+            
+            const VkQueue& getComputeQueue() const noexcept;
+            
+            const VkQueue& getQueue(PhysicalDevice::QueueType queueType) const noexcept;
+            
+            const PhysicalDevice& getPhysicalDevice() const noexcept;
+            
             void wait() const noexcept;
 
         private:
             VkDeviceQueueCreateInfo getDeviceQueueCreateInfo(std::uint32_t queueFamily, const float* pQueuePriority) const noexcept;
         };
         
+#pragma mark - mgo::vk::MemoryAllocator
+        class MemoryAllocator final
+        {
+        public:
+            static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024ull * 1024ull;
+            
+            enum class Strategy
+            {
+                DEFAULT,
+                LINEAR,
+                BUDDY,
+                FREE_LIST
+            };
+            
+            enum class ResourceType
+            {
+                BUFFER,
+                IMAGE
+            };
+            
+            struct Allocation
+            {
+                VkDeviceMemory memory_;
+                VkDeviceSize offset_;
+                VkDeviceSize size_;
+                void* pMappedData_;
+                std::uint32_t memoryTypeIndex_;
+                ResourceType resourceType_;
+                Strategy strategy_;
+            };
+            
+            struct Statistics
+            {
+                std::size_t blockCount_;
+                std::size_t allocationCount_;
+                std::size_t freeRangeCount_;
+                VkDeviceSize blockBytes_;
+                VkDeviceSize usedBytes_;
+                VkDeviceSize freeBytes_;
+                VkDeviceSize largestFreeRange_;
+                float fragmentation_;
+            };
+            
+        private:
+#pragma mark - mgo::vk::MemoryAllocator::SubAllocator
+            class SubAllocator
+            {
+            protected:
+                const VkDeviceSize size_;
+                VkDeviceSize usedBytes_;
+                std::size_t allocationCount_;
+                
+            public:
+                SubAllocator(VkDeviceSize size) noexcept;
+                
+                virtual ~SubAllocator() noexcept = default;
+                
+                virtual std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment) = 0;
+                
+                virtual void free(VkDeviceSize offset) = 0;
+                
+                virtual void addFreeRanges(Statistics& statistics) const noexcept = 0;
+                
+                VkDeviceSize getUsedBytes() const noexcept;
+                
+                std::size_t getAllocationCount() const noexcept;
+            };
+            
+#pragma mark - mgo::vk::MemoryAllocator::LinearSubAllocator
+            class LinearSubAllocator final : public SubAllocator
+            {
+            private:
+                VkDeviceSize head_;
+                std::map<VkDeviceSize, VkDeviceSize> allocations_;
+                
+            public:
+                LinearSubAllocator(VkDeviceSize size) noexcept;
+                
+                std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment) override;
+                
+                void free(VkDeviceSize offset) override;
+                
+                void addFreeRanges(Statistics& statistics) const noexcept override;
+            };
+            
+#pragma mark - mgo::vk::MemoryAllocator::BuddySubAllocator
+            class BuddySubAllocator final : public SubAllocator
+            {
+            public:
+                static constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+                
+            private:
+                std::size_t maxOrder_;
+                std::vector<std::set<VkDeviceSize>> freeNodes_;
+                std::map<VkDeviceSize, std::size_t> allocations_;
+                
+            public:
+                BuddySubAllocator(VkDeviceSize size);
+                
+                std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment) override;
+                
+                void free(VkDeviceSize offset) override;
+                
+                void addFreeRanges(Statistics& statistics) const noexcept override;
+            };
+            
+#pragma mark - mgo::vk::MemoryAllocator::FreeListSubAllocator
+            class FreeListSubAllocator final : public SubAllocator
+            {
+            private:
+                std::map<VkDeviceSize, VkDeviceSize> freeRanges_;
+                std::map<VkDeviceSize, VkDeviceSize> allocations_;
+                
+            public:
+                FreeListSubAllocator(VkDeviceSize size) noexcept;
+                
+                std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment) override;
+                
+                void free(VkDeviceSize offset) override;
+                
+                void addFreeRanges(Statistics& statistics) const noexcept override;
+            };
+            
+            struct Block
+            {
+                VkDeviceMemory memory_;
+                VkDeviceSize size_;
+                void* pMappedData_;
+                std::unique_ptr<SubAllocator> subAllocator_;
+            };
+            
+            using PoolKey = std::tuple<std::uint32_t, ResourceType, Strategy>;
+            
+            std::map<PoolKey, std::vector<Block>> pools_;
+            mutable std::mutex mutex_;
+            const Strategy defaultStrategy_;
+            const VkDeviceSize blockSize_;
+            const std::uint32_t maxMemoryAllocationCount_;
+            const PhysicalDevice& physicalDevice_;
+            const Device& device_;
+            
+        public:
+            MemoryAllocator(const PhysicalDevice& physicalDevice,
+                            const Device& device,
+                            Strategy defaultStrategy = Strategy::FREE_LIST,
+                            VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+            
+            ~MemoryAllocator() noexcept;
+            
+            Allocation allocate(const VkMemoryRequirements& memoryRequirements,
+                                VkMemoryPropertyFlags memoryPropertyFlags,
+                                ResourceType resourceType,
+                                Strategy strategy = Strategy::DEFAULT);
+            
+            Allocation allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags memoryPropertyFlags, Strategy strategy = Strategy::DEFAULT);
+            
+            Allocation allocateImage(VkImage image, VkMemoryPropertyFlags memoryPropertyFlags, Strategy strategy = Strategy::DEFAULT);
+            
+            void free(const Allocation& allocation) noexcept;
+            
+            Statistics getStatistics() const noexcept;
+            
+            static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) noexcept;
+            
+        private:
+            Block createBlock(std::uint32_t memoryTypeIndex, Strategy strategy, VkDeviceSize minimumSize);
+            
+            void destroyBlock(Block& block) const noexcept;
+            
+            std::size_t getBlockCount() const noexcept;
+        };
+        
 #pragma mark - mgo::vk::Semaphore
         class Semaphore final
         {
@@ -183,23 +450,106 @@ namespace mgo
             const VkSemaphore& get() const noexcept;
         };
         
-#pragma mark - mgo::vk::Fence
-        class Fence final
+#pragma mark - mgo::vk::TimelineSemaphore
+        class TimelineSemaphore final
         {
         private:
-            VkFence fence_;
+            VkSemaphore semaphore_;
             const Device& device_;
             
         public:
-            Fence(const Device& device);
+            TimelineSemaphore(const Device& device, std::uint64_t initialValue = 0);
             
-            ~Fence() noexcept;
+            ~TimelineSemaphore() noexcept;
             
-            const VkFence& get() const noexcept;
+            const VkSemaphore& get() const noexcept;
             
-            void wait() const noexcept;
+            std::uint64_t getValue() const noexcept;
+            
+            bool wait(std::uint64_t value, std::uint64_t timeout = UINT64_MAX) const noexcept;
+            
+            void signal(std::uint64_t value) const;
+        };
+        
+#pragma mark - mgo::vk::QueueTimelines
+        class QueueTimelines final
+        {
+        public:
+            static const std::size_t QUEUE_TYPE_COUNT = 3;
+            
+        private:
+            std::array<std::unique_ptr<TimelineSemaphore>, QUEUE_TYPE_COUNT> semaphores_;
+            std::array<std::atomic<std::uint64_t>, QUEUE_TYPE_COUNT> submittedValues_;
+            mutable std::array<std::atomic<std::uint64_t>, QUEUE_TYPE_COUNT> completedValues_;
+            
+        public:
+            QueueTimelines(const Device& device);
+            
+            std::uint64_t getNextValue(PhysicalDevice::QueueType queueType) const noexcept;
+            
+            std::uint64_t advance(PhysicalDevice::QueueType queueType) noexcept;
             
-            void reset() const noexcept;
+            std::uint64_t getSubmittedValue(PhysicalDevice::QueueType queueType) const noexcept;
+            
+            std::uint64_t getCompletedValue(PhysicalDevice::QueueType queueType) const noexcept;
+            
+            bool isComplete(PhysicalDevice::QueueType queueType, std::uint64_t value) const noexcept;
+            
+            bool wait(PhysicalDevice::QueueType queueType, std::uint64_t value, std::uint64_t timeout = UINT64_MAX) const noexcept;
+            
+            VkSemaphore getSemaphore(PhysicalDevice::QueueType queueType) const noexcept;
+        };
+        
+#pragma mark - mgo::vk::DeletionQueue
+        class DeletionQueue final
+        {
+        private:
+            std::vector<std::pair<std::function<void()>, std::uint64_t>> deletions_;
+            mutable std::mutex mutex_;
+            const QueueTimelines& queueTimelines_;
+            
+        public:
+            DeletionQueue(const QueueTimelines& queueTimelines);
+            
+            ~DeletionQueue() noexcept;
+            
+            void push(std::function<void()> deletion);
+            
+            void push(std::function<void()> deletion, std::uint64_t retireFrame);
+            
+            void release(std::uint64_t completedFrame) noexcept;
+            
+            void collect() noexcept;
+            
+            std::size_t size() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::Buffer
+        class Buffer final
+        {
+        private:
+            VkBuffer buffer_;
+            MemoryAllocator::Allocation allocation_;
+            const VkDeviceSize size_;
+            const Device& device_;
+            MemoryAllocator& memoryAllocator_;
+            DeletionQueue* pDeletionQueue_;
+            
+        public:
+            Buffer(const Device& device,
+                   MemoryAllocator& memoryAllocator,
+                   VkDeviceSize size,
+                   VkBufferUsageFlags usage,
+                   VkMemoryPropertyFlags memoryPropertyFlags,
+                   DeletionQueue* pDeletionQueue = nullptr);
+            
+            ~Buffer() noexcept;
+            
+            const VkBuffer& get() const noexcept;
+            
+            VkDeviceSize size() const noexcept;
+            
+            void* getMappedData() const noexcept;
         };
         
 #pragma mark - mgo::vk::Swapchain
@@ -208,28 +558,55 @@ namespace mgo
         private:
              
             VkSwapchainKHR swapchain_;
+            std::vector<VkImage> images_;
+            std::vector<MemoryAllocator::Allocation> imageAllocations_;
             VkSurfaceCapabilitiesKHR surfaceCapabilities_;
             VkSurfaceFormatKHR surfaceFormat_;
             VkPresentModeKHR presentMode_;
             VkExtent2D extent_;
+            PresentPolicy presentPolicy_;
+            bool outOfDate_;
+            const std::uint32_t requestedImageCount_;
             const Surface& surface_;
             const PhysicalDevice& physicalDevice_;
             const Device& device_;
+            MemoryAllocator& memoryAllocator_;
+            DeletionQueue& deletionQueue_;
             
         public:
-            Swapchain(const Surface& surface, const PhysicalDevice& physicalDevice, const Device& device);
+            Swapchain(const Surface& surface,
+                      const PhysicalDevice& physicalDevice,
+                      const Device& device,
+                      MemoryAllocator& memoryAllocator,
+                      DeletionQueue& deletionQueue,
+                      const PresentPolicy& presentPolicy = PresentPolicy(),
+                      std::uint32_t requestedImageCount = 0);
             
             ~Swapchain() noexcept;
             
         private:
-            void create();
+            void create(VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
+            
+            void createOffscreenImages(std::uint32_t imageCount);
             
             void destory();
             
+            std::uint32_t getMinImageCount() const noexcept;
+            
         public:
-            void recreate();
+            void recreate(std::uint64_t retireFrame);
+            
+            void setPresentPolicy(const PresentPolicy& presentPolicy) noexcept;
+            
+            const PresentPolicy& getPresentPolicy() const noexcept;
+            
+            bool isOutOfDate() const noexcept;
 
             const VkSwapchainKHR& get() const noexcept;
+            
+            const std::vector<VkImage>& getImages() const noexcept;
+            
+            bool isHeadless() const noexcept;
 
             VkSurfaceCapabilitiesKHR getVkSurfaceCapabilitiesKHR() const noexcept;
             
@@ -246,47 +623,58 @@ namespace mgo
         private:
             std::vector<VkImage> images_;
             std::vector<VkImageView> imageViews_;
+            VkFormat format_;
             const Device& device_;
+            DeletionQueue& deletionQueue_;
             
         public:
-            ImageViews(const Device& device, const Swapchain& swapchain);
+            ImageViews(const Device& device, DeletionQueue& deletionQueue, const Swapchain& swapchain);
             
             ~ImageViews() noexcept;
             
         private:
             void create(const Swapchain& swapchain);
             
+            VkImageView createImageView(VkImage image) const;
+            
             void destory();
             
         public:
-            void recreate(const Swapchain& swapchain);
+            void recreate(const Swapchain& swapchain, std::uint64_t retireFrame);
 
             const std::vector<VkImageView>& get() const noexcept;
             
             std::size_t size() const noexcept;
         };
         
+#pragma mark - mgo::vk::RenderPassDescription
+        struct RenderPassDescription
+        {
+            std::vector<VkAttachmentDescription> colorAttachments_;
+            std::optional<VkAttachmentDescription> depthAttachment_;
+        };
+        
 #pragma mark - mgo::vk::RenderPass
         class RenderPass final
         {
         private:
             VkRenderPass renderPass_;
             const Device& device_;
-            const Swapchain& swapchain_;
             
         public:
             RenderPass(const Device& device, const Swapchain& swapchain);
             
+            RenderPass(const Device& device, const RenderPassDescription& renderPassDescription);
+            
             ~RenderPass() noexcept;
             
             const VkRenderPass& get() const noexcept;
             
         private:
-            VkAttachmentDescription getVkAttachmentDescription() const noexcept;
-            
-            VkAttachmentReference getVkAttachmentReference() const noexcept;
+            static RenderPassDescription getRenderPassDescription(const Swapchain& swapchain) noexcept;
             
-            VkSubpassDescription getVkSubpassDescription(const VkAttachmentReference* pColorAttachmentReference) const noexcept;
+            VkSubpassDescription getVkSubpassDescription(const std::vector<VkAttachmentReference>& colorAttachmentReferences,
+                                                         const VkAttachmentReference* pDepthAttachmentReference) const noexcept;
         };
         
 #pragma mark - mgo::vk::Framebuffers
@@ -294,166 +682,1290 @@ namespace mgo
         {
         private:
             std::vector<VkFramebuffer> framebuffers_;
+            std::vector<std::vector<VkImageView>> attachments_;
+            VkExtent2D extent_;
             const Device& device_;
-            ImageViews& imageViews_;
+            DeletionQueue& deletionQueue_;
+            const RenderPass& renderPass_;
             
         public:
-            Framebuffers(const Device& device, const Swapchain& swapchain, ImageViews& imageViews, const RenderPass& renderPass);
+            Framebuffers(const Device& device, DeletionQueue& deletionQueue, const RenderPass& renderPass, const std::vector<std::vector<VkImageView>>& attachments, VkExtent2D extent);
             
             ~Framebuffers() noexcept;
             
         private:
-            void create(const Swapchain& swapchain, const RenderPass& renderPass);
+            VkFramebuffer createFramebuffer(const std::vector<VkImageView>& attachments) const;
             
             void destory();
             
         public:
-            void recreate(const Swapchain& swapchain, const RenderPass& renderPass);
+            void recreate(const std::vector<std::vector<VkImageView>>& attachments, VkExtent2D extent, std::uint64_t retireFrame);
             
             const std::vector<VkFramebuffer>& get() const noexcept;
             
             std::size_t size() const noexcept;
         };
         
-#pragma mark - mgo::vk::PipelineLayout
-        class PipelineLayout
+#pragma mark - mgo::vk::TransientAttachmentPool
+        class TransientAttachmentPool final
         {
-        private:
-            VkPipelineLayout pipelineLayout_;
-            const Device& device_;
-            
         public:
-            PipelineLayout(const Device& device);
+            using Handle = std::size_t;
             
-            ~PipelineLayout() noexcept;
+            struct Statistics
+            {
+                VkDeviceSize requiredBytes_;
+                VkDeviceSize allocatedBytes_;
+                VkDeviceSize lazilyAllocatedBytes_;
+            };
             
-            const VkPipelineLayout& get() const noexcept;
-        };
-        
-#pragma mark - mgo::vk::Pipeline
-        class Pipeline final
-        {
         private:
-#pragma mark - mgo::vk::Pipeline::ShaderModule
-            class ShaderModule final
+            struct TransientAttachment
             {
-            private:
-                VkShaderModule shaderModule_;
-                const Device& device_;
-                
-            public:
-                ShaderModule(const std::string& path, const Device& device);
-                
-                ~ShaderModule() noexcept;
-                
-                const VkShaderModule& get() const noexcept;
+                VkFormat format_;
+                VkExtent2D extent_;
+                VkImageUsageFlags usage_;
+                std::size_t firstUse_;
+                std::size_t lastUse_;
+                bool lazilyAllocated_;
+                VkImage image_;
+                VkImageView imageView_;
+                VkMemoryRequirements memoryRequirements_;
+                VkDeviceSize offset_;
             };
             
-            VkPipeline pipeline_;
+            std::vector<TransientAttachment> transientAttachments_;
+            std::vector<MemoryAllocator::Allocation> allocations_;
+            Statistics statistics_;
+            const PhysicalDevice& physicalDevice_;
             const Device& device_;
-            const RenderPass& renderPass_;
-            const PipelineLayout& pipelineLayout_;
+            MemoryAllocator& memoryAllocator_;
+            DeletionQueue& deletionQueue_;
+            const Swapchain& swapchain_;
             
         public:
-            Pipeline(const Device& device, const RenderPass& renderPass, const PipelineLayout& pipelineLayout);
+            TransientAttachmentPool(const PhysicalDevice& physicalDevice,
+                                    const Device& device,
+                                    MemoryAllocator& memoryAllocator,
+                                    DeletionQueue& deletionQueue,
+                                    const Swapchain& swapchain);
             
-            ~Pipeline() noexcept;
+            ~TransientAttachmentPool() noexcept;
             
-            const VkPipeline& get() const noexcept;
+            Handle add(VkFormat format, VkExtent2D extent, VkImageUsageFlags usage, std::size_t firstUse, std::size_t lastUse);
+            
+            void create();
             
         private:
-            VkPipelineShaderStageCreateInfo getVkPipelineShaderStageCreateInfo(const ShaderModule& shaderModule,
-                                                                               VkShaderStageFlagBits stage) const noexcept;
+            void createImage(TransientAttachment& transientAttachment) const;
             
-            VkPipelineVertexInputStateCreateInfo getVkPipelineVertexInputStateCreateInfo() const noexcept;
+            void createImageView(TransientAttachment& transientAttachment) const;
             
-            VkPipelineInputAssemblyStateCreateInfo getVkPipelineInputAssemblyStateCreateInfo() const noexcept;
+            void allocate(bool lazilyAllocated);
             
-            VkPipelineViewportStateCreateInfo getVkPipelineViewportStateCreateInfo() const noexcept;
+            void allocateAliased(const std::vector<TransientAttachment*>& transientAttachments, bool lazilyAllocated);
             
-            VkPipelineRasterizationStateCreateInfo getVkPipelineRasterizationStateCreateInfo() const noexcept;
+            std::uint32_t getLazilyAllocatedMemoryTypeBits() const noexcept;
             
-            VkPipelineMultisampleStateCreateInfo getVkPipelineMultisampleStateCreateInfo() const noexcept;
+            void destory();
             
-            VkPipelineColorBlendAttachmentState getVkPipelineColorBlendAttachmentState() const noexcept;
+        public:
+            void recreate(std::uint64_t retireFrame);
             
-            VkPipelineColorBlendStateCreateInfo
-            getVkPipelineColorBlendStateCreateInfo(const std::vector<VkPipelineColorBlendAttachmentState>& attachments) const noexcept;
+            VkImage getImage(Handle handle) const noexcept;
             
-            VkPipelineDynamicStateCreateInfo getVkPipelineDynamicStateCreateInfo(const std::vector<VkDynamicState>& dynamicStates) const noexcept;
-        };
-        
-#pragma mark - mgo::vk::CommandPool
-        class CommandPool final
-        {
-        private:
-            VkCommandPool commandPool_;
-            const PhysicalDevice& physicalDevice_;
-            const Device& device_;
+            VkImageView getImageView(Handle handle) const noexcept;
             
-        public:
-            CommandPool(const PhysicalDevice& physicalDevice, const Device& device);
+            bool isLazilyAllocated(Handle handle) const noexcept;
             
-            ~CommandPool() noexcept;
+            std::vector<Handle> getAliases(Handle handle) const;
             
-            const VkCommandPool& get() const noexcept;
+            Statistics getStatistics() const noexcept;
+            
+            std::size_t size() const noexcept;
+            
+            static VkImageAspectFlags getAspectMask(VkFormat format) noexcept;
         };
         
-#pragma mark - mgo::vk::CommandBuffers
-        class CommandBuffers final
+#pragma mark - mgo::vk::BindlessDescriptors
+        class BindlessDescriptors final
         {
         public:
-            static const std::size_t MAX_FRAMES_IN_FLIGHT = 2;
-
+            using Handle = std::uint32_t;
+            
+            enum class Binding : std::uint32_t
+            {
+                SAMPLED_IMAGES,
+                SAMPLERS,
+                STORAGE_BUFFERS
+            };
+            
+            static const std::size_t BINDING_COUNT = 3;
+            static const Handle INVALID_HANDLE = UINT32_MAX;
+            static const std::uint32_t DEFAULT_SAMPLED_IMAGE_COUNT = 16384;
+            static const std::uint32_t DEFAULT_SAMPLER_COUNT = 256;
+            static const std::uint32_t DEFAULT_STORAGE_BUFFER_COUNT = 16384;
+            // Storage buffers every pipeline layout binds besides the bindless array: the per-frame set's dynamic one.
+            static const std::uint32_t RESERVED_STORAGE_BUFFER_COUNT = 1;
+            
         private:
-            std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> commandBuffers_;
-            std::array<Semaphore, MAX_FRAMES_IN_FLIGHT> imageAvailableSemaphores_;
-            std::array<Semaphore, MAX_FRAMES_IN_FLIGHT> renderFinishedSemaphores_;
-            std::array<Fence, MAX_FRAMES_IN_FLIGHT> inFlightFences_;
-            std::uint32_t imageIndex_;
-            std::uint32_t currentFrame_;
-            glfw::Window& window_;
+            struct FreeHandles
+            {
+                std::array<std::vector<Handle>, BINDING_COUNT> handles_;
+                std::mutex mutex_;
+            };
+            
+            VkDescriptorSetLayout descriptorSetLayout_;
+            VkDescriptorPool descriptorPool_;
+            VkDescriptorSet descriptorSet_;
+            std::array<std::uint32_t, BINDING_COUNT> capacities_;
+            std::array<Handle, BINDING_COUNT> nextHandles_;
+            std::shared_ptr<FreeHandles> freeHandles_;
+            std::mutex mutex_;
             const Device& device_;
-            Swapchain& swapchain_;
-            RenderPass& renderPass_;
-            Framebuffers& framebuffers_;
-            const CommandPool& commandPool_;
-            const Pipeline& pipeline_;
+            DeletionQueue& deletionQueue_;
             
         public:
+            BindlessDescriptors(const PhysicalDevice& physicalDevice, const Device& device, DeletionQueue& deletionQueue);
             
-            CommandBuffers(glfw::Window& window,
-                           const Device& device,
-                           Swapchain& swapchain,
-                           RenderPass& renderPass,
-                           Framebuffers& framebuffers,
-                           const Pipeline& pipeline,
-                           const CommandPool& commandPool);
-                        
-            const std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT>& get() const noexcept;
+            ~BindlessDescriptors() noexcept;
             
-            void draw();
-
         private:
-            void getNextImageIndex();
+            void createDescriptorSetLayout();
             
-            void beginCommandBuffer() const;
+            void createDescriptorPool();
             
-            void beginRenderPass() const noexcept;
+            void allocateDescriptorSet();
             
-            void bindPipline() const noexcept;
+            Handle allocateHandle(Binding binding);
             
-            void setViewport() const noexcept;
+            void write(Binding binding, Handle handle, const VkDescriptorImageInfo* pImageInfo, const VkDescriptorBufferInfo* pBufferInfo) noexcept;
             
-            void setScissor() const noexcept;
-
-            void drawImage() const noexcept;
+            static VkDescriptorType getVkDescriptorType(Binding binding) noexcept;
             
-            void endRenderPass() const noexcept;
+        public:
+            Handle addSampledImage(VkImageView imageView, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            
+            Handle addSampler(VkSampler sampler);
+            
+            Handle addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+            
+            Handle addStorageBuffer(const Buffer& buffer);
+            
+            void remove(Binding binding, Handle handle);
+            
+            std::uint32_t getCapacity(Binding binding) const noexcept;
+            
+            const VkDescriptorSetLayout& getLayout() const noexcept;
+            
+            const VkDescriptorSet& get() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::FrameAllocator
+        class FrameAllocator final
+        {
+        public:
+            static constexpr VkDeviceSize DEFAULT_CAPACITY = 4ull * 1024ull * 1024ull;
+            static constexpr VkDeviceSize MAX_UNIFORM_RANGE = 64ull * 1024ull;
+            static const std::size_t BINDING_COUNT = 2;
+            
+            enum class Usage
+            {
+                UNIFORM,
+                STORAGE,
+                VERTEX
+            };
+            
+            struct Allocation
+            {
+                void* pData_;
+                VkDeviceSize size_;
+                std::uint32_t dynamicOffset_;
+            };
+            
+        private:
+            const VkDeviceSize alignment_;
+            const VkDeviceSize capacity_;
+            const VkDeviceSize uniformRange_;
+            const VkDeviceSize storageRange_;
+            Buffer buffer_;
+            VkDescriptorSetLayout descriptorSetLayout_;
+            VkDescriptorPool descriptorPool_;
+            VkDescriptorSet descriptorSet_;
+            std::vector<std::uint64_t> regionValues_;
+            std::size_t currentRegion_;
+            std::atomic<VkDeviceSize> head_;
+            const Device& device_;
+            const QueueTimelines& queueTimelines_;
+            
+        public:
+            FrameAllocator(const PhysicalDevice& physicalDevice,
+                           const Device& device,
+                           MemoryAllocator& memoryAllocator,
+                           const QueueTimelines& queueTimelines,
+                           std::uint32_t framesInFlight,
+                           VkDeviceSize capacity = DEFAULT_CAPACITY);
+            
+            ~FrameAllocator() noexcept;
+            
+        private:
+            static VkDeviceSize getAlignment(const PhysicalDevice& physicalDevice) noexcept;
+            
+            void createDescriptorSetLayout();
+            
+            void createDescriptorPool();
+            
+            void allocateDescriptorSet();
+            
+            void writeDescriptorSet() noexcept;
+            
+        public:
+            Allocation allocate(VkDeviceSize size, Usage usage);
+            
+            template<typename T>
+            Allocation push(const T& value, Usage usage = Usage::UNIFORM)
+            {
+                Allocation allocation = this->allocate(sizeof(T), usage);
+                std::memcpy(allocation.pData_, &value, sizeof(T));
+                return allocation;
+            }
+            
+            void endFrame(std::uint64_t submittedValue) noexcept;
+            
+            VkDeviceSize getUsedBytes() const noexcept;
+            
+            VkDeviceSize getCapacity() const noexcept;
+            
+            VkDeviceSize getUniformRange() const noexcept;
+            
+            const VkBuffer& getBuffer() const noexcept;
+            
+            const VkDescriptorSetLayout& getLayout() const noexcept;
+            
+            const VkDescriptorSet& get() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::PipelineLayout
+        class PipelineLayout
+        {
+        public:
+            // 128 bytes is the smallest maxPushConstantsSize the specification allows.
+            static const std::uint32_t PUSH_CONSTANT_SIZE = 128;
+            static const VkShaderStageFlags PUSH_CONSTANT_STAGES = VK_SHADER_STAGE_ALL;
+            
+        private:
+            VkPipelineLayout pipelineLayout_;
+            const Device& device_;
+            const BindlessDescriptors& bindlessDescriptors_;
+            const FrameAllocator& frameAllocator_;
+            
+        public:
+            PipelineLayout(const Device& device, const BindlessDescriptors& bindlessDescriptors, const FrameAllocator& frameAllocator);
+            
+            ~PipelineLayout() noexcept;
+            
+            const VkPipelineLayout& get() const noexcept;
+            
+            void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint) const noexcept;
+            
+            void bindFrameData(VkCommandBuffer commandBuffer,
+                               VkPipelineBindPoint pipelineBindPoint,
+                               std::uint32_t uniformOffset,
+                               std::uint32_t storageOffset) const noexcept;
+            
+            void pushConstants(VkCommandBuffer commandBuffer, std::uint32_t offset, std::uint32_t size, const void* pValues) const noexcept;
+        };
+        
+#pragma mark - mgo::vk::PipelineCache
+        class PipelineCache final
+        {
+        public:
+            static constexpr std::uint32_t FILE_MAGIC = 0x4350474D;
+            static constexpr std::uint32_t FILE_VERSION = 1;
+            
+            struct FileHeader
+            {
+                std::uint32_t magic_;
+                std::uint32_t version_;
+                std::uint32_t vendorID_;
+                std::uint32_t deviceID_;
+                std::uint32_t driverVersion_;
+                std::uint8_t pipelineCacheUUID_[VK_UUID_SIZE];
+                // Explicit, zeroed padding keeps uninitialised bytes out of the file.
+                std::uint32_t reserved_;
+                std::uint64_t dataSize_;
+                std::uint64_t checksum_;
+            };
+            static_assert(sizeof(FileHeader) == 6 * sizeof(std::uint32_t) + VK_UUID_SIZE + 2 * sizeof(std::uint64_t),
+                          "mgo::vk::PipelineCache::FileHeader must not contain implicit padding");
+            
+        private:
+            VkPipelineCache pipelineCache_;
+            const std::filesystem::path path_;
+            const PhysicalDevice& physicalDevice_;
+            const Device& device_;
+            
+        public:
+            PipelineCache(const PhysicalDevice& physicalDevice, const Device& device, const std::filesystem::path& path);
+            
+            ~PipelineCache() noexcept;
+            
+            const VkPipelineCache& get() const noexcept;
+            
+            void save() const;
+            
+        private:
+            std::vector<char> load() const noexcept;
+            
+            FileHeader getFileHeader(const std::vector<char>& data) const noexcept;
+            
+            bool checkFileHeader(const FileHeader& fileHeader, const std::vector<char>& data) const noexcept;
+        };
+        
+#pragma mark - mgo::vk::ShaderLibrary
+        class ShaderLibrary final
+        {
+        public:
+            static constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+            
+        private:
+#pragma mark - mgo::vk::ShaderLibrary::MappedFile
+            class MappedFile final
+            {
+            private:
+                void* pData_;
+                std::size_t size_;
+                
+            public:
+                MappedFile(const std::string& path);
+                
+                ~MappedFile() noexcept;
+                
+                const void* data() const noexcept;
+                
+                std::size_t size() const noexcept;
+            };
+            
+            struct Module
+            {
+                // The mapping stays open as the module's comparison bytes, so no copy of the SPIR-V is kept.
+                std::shared_ptr<const MappedFile> pMappedFile_;
+                VkShaderModule shaderModule_;
+            };
+            
+            std::map<std::string, VkShaderModule> modulesByPath_;
+            std::unordered_multimap<std::uint64_t, Module> modulesByContent_;
+            mutable std::mutex mutex_;
+            const Device& device_;
+            
+        public:
+            ShaderLibrary(const Device& device);
+            
+            ~ShaderLibrary() noexcept;
+            
+            VkShaderModule load(const std::string& path);
+            
+            std::size_t size() const noexcept;
+            
+        private:
+            VkShaderModule createShaderModule(const std::string& path, const MappedFile& mappedFile) const;
+            
+            VkShaderModule findModule(std::uint64_t contentHash, const MappedFile& mappedFile) const noexcept;
+        };
+        
+#pragma mark - mgo::vk::PipelineDescription
+        struct PipelineDescription
+        {
+            std::string vertexShaderPath_ = "MangosEngine/Vulkan/SPIR-V/vert.spv";
+            std::string fragmentShaderPath_ = "MangosEngine/Vulkan/SPIR-V/frag.spv";
+            VkPrimitiveTopology topology_ = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+            VkPolygonMode polygonMode_ = VK_POLYGON_MODE_FILL;
+            VkCullModeFlags cullMode_ = VK_CULL_MODE_BACK_BIT;
+            bool blendEnable_ = false;
+            VkColorComponentFlags colorWriteMask_ = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            // Unoptimised pipelines compile quickly; fallbacks use them until the optimised build lands.
+            bool optimize_ = true;
+            
+            static PipelineDescription getFallback() noexcept;
+        };
+        
+#pragma mark - mgo::vk::Pipeline
+        class Pipeline final
+        {
+        private:
+            VkPipeline pipeline_;
+            const Device& device_;
+            const RenderPass& renderPass_;
+            const PipelineLayout& pipelineLayout_;
+            const PipelineCache& pipelineCache_;
+            ShaderLibrary& shaderLibrary_;
+            const PipelineDescription description_;
+            
+        public:
+            Pipeline(const Device& device,
+                     const RenderPass& renderPass,
+                     const PipelineLayout& pipelineLayout,
+                     const PipelineCache& pipelineCache,
+                     ShaderLibrary& shaderLibrary,
+                     const PipelineDescription& description = PipelineDescription());
+            
+            ~Pipeline() noexcept;
+            
+            const VkPipeline& get() const noexcept;
+            
+        private:
+            VkPipelineShaderStageCreateInfo getVkPipelineShaderStageCreateInfo(VkShaderModule shaderModule,
+                                                                               VkShaderStageFlagBits stage) const noexcept;
+            
+            VkPipelineVertexInputStateCreateInfo
+            getVkPipelineVertexInputStateCreateInfo(const std::vector<VkVertexInputBindingDescription>& bindings,
+                                                    const std::vector<VkVertexInputAttributeDescription>& attributes) const noexcept;
+            
+            VkPipelineInputAssemblyStateCreateInfo getVkPipelineInputAssemblyStateCreateInfo() const noexcept;
+            
+            VkPipelineViewportStateCreateInfo getVkPipelineViewportStateCreateInfo() const noexcept;
+            
+            VkPipelineRasterizationStateCreateInfo getVkPipelineRasterizationStateCreateInfo() const noexcept;
+            
+            VkPipelineMultisampleStateCreateInfo getVkPipelineMultisampleStateCreateInfo() const noexcept;
+            
+            VkPipelineColorBlendAttachmentState getVkPipelineColorBlendAttachmentState() const noexcept;
+            
+            VkPipelineColorBlendStateCreateInfo
+            getVkPipelineColorBlendStateCreateInfo(const std::vector<VkPipelineColorBlendAttachmentState>& attachments) const noexcept;
+            
+            VkPipelineDynamicStateCreateInfo getVkPipelineDynamicStateCreateInfo(const std::vector<VkDynamicState>& dynamicStates) const noexcept;
+        };
+        
+#pragma mark - mgo::vk::ComputePipeline
+        class ComputePipeline final
+        {
+        private:
+            VkPipeline pipeline_;
+            const Device& device_;
+            const PipelineLayout& pipelineLayout_;
+            
+        public:
+            ComputePipeline(const Device& device,
+                            const PipelineLayout& pipelineLayout,
+                            const PipelineCache& pipelineCache,
+                            ShaderLibrary& shaderLibrary,
+                            const std::string& shaderPath);
+            
+            ~ComputePipeline() noexcept;
+            
+            const VkPipeline& get() const noexcept;
+            
+            void bind(VkCommandBuffer commandBuffer) const noexcept;
+        };
+        
+#pragma mark - mgo::vk::PipelineBuilder
+        class PipelineBuilder final
+        {
+        public:
+            using Future = std::shared_future<std::shared_ptr<Pipeline>>;
+            
+        private:
+            // Counts the builds still queued or running on the job scheduler.
+            jobs::Counter counter_;
+            const Device& device_;
+            const RenderPass& renderPass_;
+            const PipelineLayout& pipelineLayout_;
+            const PipelineCache& pipelineCache_;
+            ShaderLibrary& shaderLibrary_;
+            
+        public:
+            PipelineBuilder(const Device& device,
+                            const RenderPass& renderPass,
+                            const PipelineLayout& pipelineLayout,
+                            const PipelineCache& pipelineCache,
+                            ShaderLibrary& shaderLibrary);
+            
+            ~PipelineBuilder() noexcept;
+            
+            Future build(const PipelineDescription& description);
+            
+            std::vector<Future> build(const std::vector<PipelineDescription>& descriptions);
+        };
+        
+#pragma mark - mgo::vk::AsyncPipeline
+        class AsyncPipeline final
+        {
+        private:
+            // Resolution is shared by recording threads: the mutex guards the future, the atomic publishes the result.
+            mutable std::mutex mutex_;
+            mutable PipelineBuilder::Future future_;
+            mutable std::shared_ptr<Pipeline> pipeline_;
+            mutable std::atomic<const Pipeline*> pResolvedPipeline_;
+            const Pipeline& fallbackPipeline_;
+            
+        public:
+            AsyncPipeline(const PipelineBuilder::Future& future, const Pipeline& fallbackPipeline);
+            
+            AsyncPipeline(const AsyncPipeline&) = delete;
+            
+            AsyncPipeline& operator=(const AsyncPipeline&) = delete;
+            
+            const VkPipeline& get() const noexcept;
+            
+            bool isReady() const noexcept;
+            
+        private:
+            const Pipeline& resolve() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::CommandPool
+        class CommandPool final
+        {
+        private:
+            VkCommandPool commandPool_;
+            const PhysicalDevice::QueueType queueType_;
+            const PhysicalDevice& physicalDevice_;
+            const Device& device_;
+            
+        public:
+            CommandPool(const PhysicalDevice& physicalDevice,
+                        const Device& device,
+                        PhysicalDevice::QueueType queueType = PhysicalDevice::QueueType::GRAPHICS);
+            
+            ~CommandPool() noexcept;
+            
+            const VkCommandPool& get() const noexcept;
+            
+            const VkQueue& getQueue() const noexcept;
+            
+            PhysicalDevice::QueueType getQueueType() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::StagingRing
+        class StagingRing final
+        {
+        public:
+            static const std::size_t MAX_BATCHES_IN_FLIGHT = 4;
+            static constexpr VkDeviceSize DEFAULT_CAPACITY = 16ull * 1024ull * 1024ull;
+            static constexpr VkDeviceSize COPY_ALIGNMENT = 16;
+            static constexpr VkPipelineStageFlags WAIT_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                                                                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                                                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                                                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            
+        private:
+            Buffer buffer_;
+            std::array<VkCommandBuffer, MAX_BATCHES_IN_FLIGHT> commandBuffers_;
+            std::array<std::uint64_t, MAX_BATCHES_IN_FLIGHT> batchValues_;
+            std::array<VkDeviceSize, MAX_BATCHES_IN_FLIGHT> batchBytes_;
+            std::map<VkBuffer, std::vector<VkBufferCopy>> pendingCopies_;
+            VkDeviceSize head_;
+            VkDeviceSize usedBytes_;
+            VkDeviceSize pendingBytes_;
+            std::size_t oldestBatch_;
+            std::size_t batchesInFlight_;
+            const Device& device_;
+            const CommandPool& commandPool_;
+            QueueTimelines& queueTimelines_;
+            
+        public:
+            StagingRing(const Device& device,
+                        MemoryAllocator& memoryAllocator,
+                        const CommandPool& commandPool,
+                        QueueTimelines& queueTimelines,
+                        VkDeviceSize capacity = DEFAULT_CAPACITY);
+            
+            ~StagingRing() noexcept;
+            
+            void upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+            
+            std::uint64_t flush();
+            
+            void collect() noexcept;
+            
+            PhysicalDevice::QueueType getQueueType() const noexcept;
+            
+        private:
+            std::uint64_t submitBatch();
+            
+            VkDeviceSize reserve(VkDeviceSize size);
+            
+            void waitForOldestBatch() noexcept;
+            
+            void retireOldestBatch() noexcept;
+        };
+        
+#pragma mark - mgo::vk::AsyncCompute
+        class AsyncCompute final
+        {
+        public:
+            static const std::size_t MAX_BATCHES_IN_FLIGHT = 4;
+            
+            using RecordFunction = std::function<void(VkCommandBuffer commandBuffer)>;
+            
+        private:
+            std::array<VkCommandBuffer, MAX_BATCHES_IN_FLIGHT> commandBuffers_;
+            std::array<std::uint64_t, MAX_BATCHES_IN_FLIGHT> batchValues_;
+            std::size_t nextBatch_;
+            std::mutex mutex_;
+            const Device& device_;
+            const CommandPool& commandPool_;
+            QueueTimelines& queueTimelines_;
+            
+        public:
+            AsyncCompute(const Device& device, const CommandPool& commandPool, QueueTimelines& queueTimelines);
+            
+            ~AsyncCompute() noexcept;
+            
+            std::uint64_t submit(const RecordFunction& record);
+            
+            PhysicalDevice::QueueType getQueueType() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::Vertex
+        struct Vertex
+        {
+            std::array<float, 2> position_;
+            std::array<float, 3> color_;
+            
+            static std::vector<VkVertexInputBindingDescription> getVkVertexInputBindingDescriptions() noexcept;
+            
+            static std::vector<VkVertexInputAttributeDescription> getVkVertexInputAttributeDescriptions() noexcept;
+        };
+        
+#pragma mark - mgo::vk::InstanceData
+        struct InstanceData
+        {
+            std::array<float, 16> transform_;
+            std::array<float, 4> color_;
+            // Selects the bindless sampled image and sampler at that slot; INVALID_HANDLE draws untextured.
+            std::uint32_t materialIndex_ = BindlessDescriptors::INVALID_HANDLE;
+            
+            static std::vector<VkVertexInputBindingDescription> getVkVertexInputBindingDescriptions() noexcept;
+            
+            static std::vector<VkVertexInputAttributeDescription> getVkVertexInputAttributeDescriptions() noexcept;
+        };
+        
+#pragma mark - mgo::vk::VertexBuffer
+        class VertexBuffer final
+        {
+        private:
+            Buffer buffer_;
+            const std::uint32_t vertexCount_;
+            
+        public:
+            VertexBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<Vertex>& vertices);
+            
+            const VkBuffer& get() const noexcept;
+            
+            std::uint32_t size() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::InstanceBuffer
+        class InstanceBuffer final
+        {
+        private:
+            Buffer buffer_;
+            const std::uint32_t instanceCount_;
+            
+        public:
+            InstanceBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<InstanceData>& instances);
+            
+            const VkBuffer& get() const noexcept;
+            
+            std::uint32_t size() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::IndexBuffer
+        class IndexBuffer final
+        {
+        private:
+            Buffer buffer_;
+            const std::uint32_t indexCount_;
+            const VkIndexType indexType_;
+            
+        public:
+            IndexBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<std::uint16_t>& indices);
+            
+            IndexBuffer(const Device& device, MemoryAllocator& memoryAllocator, StagingRing& stagingRing, const std::vector<std::uint32_t>& indices);
+            
+            const VkBuffer& get() const noexcept;
+            
+            std::uint32_t size() const noexcept;
+            
+            VkIndexType getVkIndexType() const noexcept;
+        };
+        
+#pragma mark - mgo::vk::IndirectRenderer
+        class IndirectRenderer final
+        {
+        public:
+            static const std::uint32_t WORKGROUP_SIZE = 64;
+            static const std::size_t FRUSTUM_PLANE_COUNT = 6;
+            inline static const std::string CULL_SHADER_PATH = "MangosEngine/Vulkan/SPIR-V/cull.spv";
+            
+            // Matches MgoObject in mgo_cull.comp; firstInstance_ selects the object's entry in the static instance stream.
+            struct Object
+            {
+                std::array<float, 4> boundingSphere_;
+                std::uint32_t indexCount_;
+                std::uint32_t firstIndex_;
+                std::int32_t vertexOffset_;
+                std::uint32_t firstInstance_;
+            };
+            
+            // Plane equations (xyz normal pointing inwards, w distance) in the space of the bounding spheres.
+            using Frustum = std::array<std::array<float, 4>, FRUSTUM_PLANE_COUNT>;
+            
+        private:
+            struct CullConstants
+            {
+                std::array<std::uint32_t, 4> resourceIndices_;
+                Frustum frustum_;
+                std::uint32_t compact_;
+            };
+            
+            std::unique_ptr<Buffer> objectBuffer_;
+            std::unique_ptr<Buffer> drawBuffer_;
+            Buffer countBuffer_;
+            BindlessDescriptors::Handle objectHandle_;
+            BindlessDescriptors::Handle drawHandle_;
+            BindlessDescriptors::Handle countHandle_;
+            std::uint32_t objectCount_;
+            Frustum frustum_;
+            PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCount_;
+            bool multiDrawSupported_;
+            bool supported_;
+            const Device& device_;
+            MemoryAllocator& memoryAllocator_;
+            DeletionQueue& deletionQueue_;
+            StagingRing& stagingRing_;
+            BindlessDescriptors& bindlessDescriptors_;
+            const PipelineLayout& pipelineLayout_;
+            const ComputePipeline& cullPipeline_;
+            
+        public:
+            IndirectRenderer(const Device& device,
+                             MemoryAllocator& memoryAllocator,
+                             DeletionQueue& deletionQueue,
+                             StagingRing& stagingRing,
+                             BindlessDescriptors& bindlessDescriptors,
+                             const PipelineLayout& pipelineLayout,
+                             const ComputePipeline& cullPipeline);
+            
+            ~IndirectRenderer() noexcept;
+            
+            void setObjects(const std::vector<Object>& objects);
+            
+            void setFrustum(const Frustum& frustum) noexcept;
+            
+            void cull(VkCommandBuffer commandBuffer) const noexcept;
+            
+            void draw(VkCommandBuffer commandBuffer, VkPipeline pipeline, std::uint32_t uniformOffset) const noexcept;
+            
+            std::uint32_t getObjectCount() const noexcept;
+            
+            bool isCompacting() const noexcept;
+            
+            bool isSupported() const noexcept;
+            
+        private:
+            void releaseBuffers() noexcept;
+            
+            static void recordBarrier(VkCommandBuffer commandBuffer,
+                                      VkPipelineStageFlags srcStageMask,
+                                      VkAccessFlags srcAccessMask,
+                                      VkPipelineStageFlags dstStageMask,
+                                      VkAccessFlags dstAccessMask) noexcept;
+        };
+        
+#pragma mark - mgo::vk::GpuProfiler
+        class GpuProfiler final
+        {
+        public:
+            static const std::uint32_t DEFAULT_MAX_SCOPES = 32;
+            static const std::size_t HISTORY_SIZE = 256;
+            static const std::uint32_t PIPELINE_STATISTICS_COUNT = 6;
+            static const VkQueryPipelineStatisticFlags PIPELINE_STATISTICS = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+                                                                             VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+                                                                             VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                                                                             VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+                                                                             VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                                                                             VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+            inline static const std::string FRAME_SCOPE = "Frame";
+            
+            struct Statistics
+            {
+                double lastMilliseconds_;
+                double averageMilliseconds_;
+                double p50Milliseconds_;
+                double p95Milliseconds_;
+                double p99Milliseconds_;
+                std::size_t sampleCount_;
+                std::uint64_t totalSampleCount_;
+                // Ordered as the bits of PIPELINE_STATISTICS, from the last frame the scope was recorded in.
+                std::array<std::uint64_t, PIPELINE_STATISTICS_COUNT> pipelineStatistics_;
+            };
+            
+            class Scope final
+            {
+            private:
+                GpuProfiler& gpuProfiler_;
+                VkCommandBuffer commandBuffer_;
+                
+            public:
+                Scope(GpuProfiler& gpuProfiler, VkCommandBuffer commandBuffer, const std::string& name);
+                
+                ~Scope() noexcept;
+            };
+            
+        private:
+            struct FrameScope
+            {
+                std::string name_;
+                std::uint32_t timestampQuery_;
+                std::optional<std::uint32_t> statisticsQuery_;
+            };
+            
+            struct History
+            {
+                std::vector<double> samples_;
+                std::size_t next_;
+                std::uint64_t totalSampleCount_;
+                std::array<std::uint64_t, PIPELINE_STATISTICS_COUNT> pipelineStatistics_;
+            };
+            
+            std::vector<VkQueryPool> timestampQueryPools_;
+            std::vector<VkQueryPool> statisticsQueryPools_;
+            std::vector<std::vector<FrameScope>> frameScopes_;
+            std::vector<bool> frameRecorded_;
+            std::vector<std::size_t> openScopes_;
+            std::map<std::string, History> histories_;
+            std::optional<std::size_t> statisticsScope_;
+            std::vector<std::uint32_t> statisticsQueryCounts_;
+            std::uint32_t currentFrame_;
+            double timestampPeriod_;
+            std::uint64_t timestampMask_;
+            bool timestampsSupported_;
+            bool statisticsSupported_;
+            const std::uint32_t maxScopes_;
+            const Device& device_;
+            
+        public:
+            GpuProfiler(const Device& device, std::uint32_t framesInFlight, std::uint32_t maxScopes = DEFAULT_MAX_SCOPES);
+            
+            ~GpuProfiler() noexcept;
+            
+            void beginFrame(VkCommandBuffer commandBuffer, std::uint32_t frame);
+            
+            void endFrame(VkCommandBuffer commandBuffer) noexcept;
+            
+            void beginScope(VkCommandBuffer commandBuffer, const std::string& name);
+            
+            void endScope(VkCommandBuffer commandBuffer) noexcept;
+            
+            std::optional<Statistics> getStatistics(const std::string& name) const;
+            
+            std::vector<std::string> getScopeNames() const;
+            
+            VkQueryPipelineStatisticFlags getInheritedPipelineStatistics() const noexcept;
+            
+            bool isEnabled() const noexcept;
+            
+        private:
+            void collect(std::uint32_t frame);
+            
+            void addSample(const std::string& name, std::uint64_t beginTimestamp, std::uint64_t endTimestamp, const std::uint64_t* pPipelineStatistics);
+        };
+        
+#pragma mark - mgo::vk::RenderGraph
+        class RenderGraph final
+        {
+        public:
+            using ResourceHandle = std::uint32_t;
+            
+            // The swapchain image of the current frame, imported into every graph.
+            static const ResourceHandle BACKBUFFER = 0;
+            
+            struct AttachmentDescription
+            {
+                VkFormat format_;
+                // An extent of {0, 0} follows the swapchain.
+                VkExtent2D extent_ = {0, 0};
+                VkImageUsageFlags usage_ = 0;
+            };
+            
+            struct Attachment
+            {
+                ResourceHandle resource_;
+                VkAttachmentLoadOp loadOp_ = VK_ATTACHMENT_LOAD_OP_CLEAR;
+                VkClearValue clearValue_{};
+            };
+            
+            struct PassContext
+            {
+                VkCommandBuffer commandBuffer_;
+                VkRenderPass renderPass_;
+                VkFramebuffer framebuffer_;
+                VkExtent2D extent_;
+            };
+            
+            struct PassDescription
+            {
+                std::vector<Attachment> colorAttachments_;
+                std::optional<Attachment> depthAttachment_;
+                std::vector<ResourceHandle> sampledImages_;
+                VkSubpassContents subpassContents_ = VK_SUBPASS_CONTENTS_INLINE;
+                // Recorded before the render pass begins, for transfers and dispatches the pass consumes.
+                std::function<void(VkCommandBuffer commandBuffer)> prepare_;
+                std::function<void(const PassContext& passContext)> execute_;
+            };
+            
+        private:
+            static const VkAccessFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT |
+                                                      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                                      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                                      VK_ACCESS_TRANSFER_WRITE_BIT |
+                                                      VK_ACCESS_HOST_WRITE_BIT |
+                                                      VK_ACCESS_MEMORY_WRITE_BIT;
+            
+            struct ResourceState
+            {
+                VkImageLayout layout_;
+                VkAccessFlags access_;
+                VkPipelineStageFlags stages_;
+            };
+            
+            struct Resource
+            {
+                std::string name_;
+                AttachmentDescription description_;
+                VkImageUsageFlags usage_;
+                std::optional<TransientAttachmentPool::Handle> transientAttachment_;
+                std::size_t firstUse_;
+                std::size_t lastUse_;
+            };
+            
+            struct Barrier
+            {
+                ResourceHandle resource_;
+                ResourceState oldState_;
+                ResourceState newState_;
+            };
+            
+            struct Pass
+            {
+                std::string name_;
+                PassDescription description_;
+                std::unique_ptr<RenderPass> renderPass_;
+                std::unique_ptr<Framebuffers> framebuffers_;
+                std::vector<VkClearValue> clearValues_;
+                std::vector<Barrier> barriers_;
+            };
+            
+            std::vector<Resource> resources_;
+            std::vector<Pass> passes_;
+            std::vector<ResourceHandle> outputs_;
+            std::vector<std::size_t> executionOrder_;
+            TransientAttachmentPool transientAttachmentPool_;
+            std::vector<Barrier> finalBarriers_;
+            std::size_t barrierCount_;
+            bool compiled_;
+            const Device& device_;
+            DeletionQueue& deletionQueue_;
+            const Swapchain& swapchain_;
+            ImageViews& imageViews_;
+            
+        public:
+            RenderGraph(const PhysicalDevice& physicalDevice,
+                        const Device& device,
+                        MemoryAllocator& memoryAllocator,
+                        DeletionQueue& deletionQueue,
+                        const Swapchain& swapchain,
+                        ImageViews& imageViews);
+            
+            ResourceHandle createAttachment(const std::string& name, const AttachmentDescription& attachmentDescription);
+            
+            void addPass(const std::string& name, const PassDescription& passDescription);
+            
+            void setOutput(ResourceHandle resource);
+            
+            void compile();
+            
+            void execute(VkCommandBuffer commandBuffer, std::uint32_t imageIndex, GpuProfiler* pGpuProfiler = nullptr);
+            
+            void recreate(std::uint64_t retireFrame);
+            
+            const RenderPass& getRenderPass(const std::string& passName);
+            
+            std::vector<std::string> getExecutionOrder() const;
+            
+            std::size_t getBarrierCount() const noexcept;
+            
+            const TransientAttachmentPool& getTransientAttachmentPool() const noexcept;
+            
+        private:
+            std::vector<std::vector<std::size_t>> getDependencies() const;
+            
+            void cull(const std::vector<std::vector<std::size_t>>& dependencies);
+            
+            void assignTransientAttachments();
+            
+            void scheduleBarriers();
+            
+            void createRenderPasses();
+            
+            VkAttachmentStoreOp getStoreOp(ResourceHandle resource, std::size_t position) const noexcept;
+            
+            std::vector<std::vector<VkImageView>> getFramebufferAttachments(const Pass& pass) const;
+            
+            VkExtent2D getExtent(ResourceHandle resource) const noexcept;
+            
+            VkExtent2D getExtent(const PassDescription& passDescription) const noexcept;
+            
+            VkImageLayout getPresentLayout() const noexcept;
+            
+            bool isPresentedByRenderPass() const noexcept;
+            
+            VkImage getImage(ResourceHandle resource, std::uint32_t imageIndex) const noexcept;
+            
+            VkImageView getImageView(ResourceHandle resource, std::uint32_t imageIndex) const noexcept;
+            
+            void recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers, std::uint32_t imageIndex) const noexcept;
+            
+            static std::vector<const Attachment*> getAttachments(const PassDescription& passDescription);
+        };
+        
+#pragma mark - mgo::vk::FrameData
+        // Matches the MgoFrame block of mgo_frame.glsl.
+        struct FrameData
+        {
+            std::array<float, 16> viewProjection_ = {1.0f, 0.0f, 0.0f, 0.0f,
+                                                     0.0f, 1.0f, 0.0f, 0.0f,
+                                                     0.0f, 0.0f, 1.0f, 0.0f,
+                                                     0.0f, 0.0f, 0.0f, 1.0f};
+        };
+        
+#pragma mark - mgo::vk::DrawCommand
+        struct DrawCommand
+        {
+            // Binds the frame's FrameData; a draw's own uniform slice must also start with a FrameData.
+            static const std::uint32_t FRAME_UNIFORM_OFFSET = std::numeric_limits<std::uint32_t>::max();
+            
+            std::uint32_t indexCount_;
+            std::uint32_t instanceCount_;
+            std::uint32_t firstIndex_;
+            std::int32_t vertexOffset_;
+            std::uint32_t firstInstance_;
+            const AsyncPipeline* pPipeline_ = nullptr;
+            std::array<BindlessDescriptors::Handle, 4> resourceIndices_ = {};
+            std::uint32_t uniformOffset_ = FRAME_UNIFORM_OFFSET;
+            std::uint32_t storageOffset_ = 0;
+            // Without a buffer the draw reads the static instance stream.
+            VkBuffer instanceBuffer_ = VK_NULL_HANDLE;
+            VkDeviceSize instanceOffset_ = 0;
+            // Draws are ordered by pass, then by state, then front to back by depth in [0, 1].
+            std::uint32_t pass_ = 0;
+            float depth_ = 0.0f;
+        };
+        
+#pragma mark - mgo::vk::RenderQueue
+        class RenderQueue final
+        {
+        public:
+            using SortKey = std::uint64_t;
+            
+            // Key layout from the most significant bit: pass, pipeline, material, mesh, depth.
+            static const std::uint32_t PASS_BITS = 4;
+            static const std::uint32_t PIPELINE_BITS = 12;
+            static const std::uint32_t MATERIAL_BITS = 16;
+            static const std::uint32_t MESH_BITS = 16;
+            static const std::uint32_t DEPTH_BITS = 16;
+            static const std::uint32_t RADIX_BITS = 8;
+            static const std::size_t RADIX_SIZE = std::size_t(1) << RADIX_BITS;
+            static const std::size_t MIN_KEYS_PER_THREAD = 16384;
+            
+        private:
+            std::vector<SortKey> keys_;
+            std::vector<SortKey> scratchKeys_;
+            std::vector<std::uint32_t> order_;
+            std::vector<std::uint32_t> scratchOrder_;
+            std::vector<std::array<std::size_t, RADIX_SIZE>> histograms_;
+            bool skipDigit_;
+            const std::uint32_t threadCount_;
+            
+        public:
+            RenderQueue(std::uint32_t threadCount = 0);
+            
+            static SortKey makeKey(std::uint32_t pass, std::uint32_t pipeline, std::uint32_t material, std::uint32_t mesh, float depth) noexcept;
+            
+            void clear() noexcept;
+            
+            void push(SortKey key);
+            
+            void sort();
+            
+            const std::vector<std::uint32_t>& getOrder() const noexcept;
+            
+            std::size_t size() const noexcept;
+            
+        private:
+            void computeOffsets() noexcept;
+        };
+        
+#pragma mark - mgo::vk::ParallelRecorder
+        class ParallelRecorder final
+        {
+        public:
+            static const std::size_t MIN_DRAWS_PER_WORKER = 256;
+            
+            using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, std::size_t firstDraw, std::size_t lastDraw)>;
+            
+        private:
+            std::vector<std::vector<VkCommandPool>> commandPools_;
+            std::vector<std::vector<VkCommandBuffer>> commandBuffers_;
+            std::mutex mutex_;
+            const RecordFunction* pRecordFunction_;
+            VkCommandBufferInheritanceInfo inheritanceInfo_;
+            std::uint32_t frame_;
+            std::size_t drawCount_;
+            std::size_t chunkCount_;
+            std::exception_ptr exception_;
+            const std::uint32_t workerCount_;
+            const Device& device_;
+            
+        public:
+            ParallelRecorder(const Device& device, std::uint32_t framesInFlight, std::uint32_t workerCount = 0);
+            
+            ~ParallelRecorder() noexcept;
+            
+            void reset(std::uint32_t frame) const noexcept;
+            
+            std::vector<VkCommandBuffer> record(std::uint32_t frame,
+                                                const VkCommandBufferInheritanceInfo& inheritanceInfo,
+                                                std::size_t drawCount,
+                                                const RecordFunction& recordFunction);
+            
+            std::uint32_t getWorkerCount() const noexcept;
+            
+        private:
+            void recordChunk(std::uint32_t workerIndex) noexcept;
+        };
+        
+#pragma mark - mgo::vk::CommandBuffers
+        class CommandBuffers final
+        {
+        public:
+            static const std::uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+        private:
+            std::vector<VkCommandBuffer> commandBuffers_;
+            std::vector<std::unique_ptr<Semaphore>> imageAvailableSemaphores_;
+            std::vector<std::unique_ptr<Semaphore>> renderFinishedSemaphores_;
+            std::vector<std::uint64_t> imagesInFlight_;
+            std::vector<std::uint64_t> slotFrames_;
+            std::uint64_t submittedFrames_;
+            std::uint64_t completedFrame_;
+            std::vector<VkSemaphore> waitSemaphores_;
+            std::vector<VkPipelineStageFlags> waitStages_;
+            std::vector<std::uint64_t> waitValues_;
+            std::vector<DrawCommand> drawCommands_;
+            std::vector<VkPipeline> drawPipelines_;
+            std::unordered_map<VkPipeline, std::uint32_t> pipelineIds_;
+            std::map<std::array<BindlessDescriptors::Handle, 4>, std::uint32_t> materialIds_;
+            std::map<std::pair<VkBuffer, VkDeviceSize>, std::uint32_t> meshIds_;
+            const IndirectRenderer* pIndirectRenderer_;
+            VkPipeline indirectPipeline_;
+            std::uint32_t frameUniformOffset_;
+            ParallelRecorder parallelRecorder_;
+            RenderQueue renderQueue_;
+            GpuProfiler gpuProfiler_;
+            std::uint32_t imageIndex_;
+            std::uint32_t currentFrame_;
+            const std::uint32_t framesInFlight_;
+            glfw::Window& window_;
+            const Device& device_;
+            QueueTimelines& queueTimelines_;
+            DeletionQueue& deletionQueue_;
+            Swapchain& swapchain_;
+            RenderGraph& renderGraph_;
+            const CommandPool& commandPool_;
+            const PipelineLayout& pipelineLayout_;
+            const AsyncPipeline& pipeline_;
+            const VertexBuffer& vertexBuffer_;
+            const IndexBuffer& indexBuffer_;
+            const InstanceBuffer& instanceBuffer_;
+            
+        public:
+            
+            CommandBuffers(glfw::Window& window,
+                           const Device& device,
+                           QueueTimelines& queueTimelines,
+                           DeletionQueue& deletionQueue,
+                           Swapchain& swapchain,
+                           RenderGraph& renderGraph,
+                           const PipelineLayout& pipelineLayout,
+                           const AsyncPipeline& pipeline,
+                           const CommandPool& commandPool,
+                           const VertexBuffer& vertexBuffer,
+                           const IndexBuffer& indexBuffer,
+                           const InstanceBuffer& instanceBuffer,
+                           std::uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT,
+                           std::uint32_t recordingThreadCount = 0);
+                        
+            const std::vector<VkCommandBuffer>& get() const noexcept;
+            
+            std::uint32_t getFramesInFlight() const noexcept;
+            
+            void draw();
+            
+            void waitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage);
+            
+            void waitTimeline(PhysicalDevice::QueueType queueType, std::uint64_t value, VkPipelineStageFlags waitStage);
+            
+            void setDrawCommands(const std::vector<DrawCommand>& drawCommands);
+            
+            void setIndirectRenderer(const IndirectRenderer* pIndirectRenderer) noexcept;
+            
+            void setFrameUniformOffset(std::uint32_t frameUniformOffset) noexcept;
+            
+            void recordScene(const RenderGraph::PassContext& passContext);
+            
+            GpuProfiler& getGpuProfiler() noexcept;
+            
+            const GpuProfiler& getGpuProfiler() const noexcept;
+
+        private:
+            bool getNextImageIndex();
+            
+            void waitForImageInFlight();
+            
+            void recreateSwapchain();
+            
+            void releaseRetired() noexcept;
+            
+            void beginCommandBuffer() const;
+            
+            void resolvePipelines();
+            
+            void sortDraws();
+            
+            void recordDraws(VkCommandBuffer commandBuffer, std::size_t firstDraw, std::size_t lastDraw) const noexcept;
+            
+            void bindPipline(VkCommandBuffer commandBuffer, VkPipeline pipeline) const noexcept;
+            
+            void bindVertexBuffers(VkCommandBuffer commandBuffer) const noexcept;
+            
+            void bindInstanceBuffer(VkCommandBuffer commandBuffer, VkBuffer instanceBuffer, VkDeviceSize instanceOffset) const noexcept;
+            
+            void bindIndexBuffer(VkCommandBuffer commandBuffer) const noexcept;
+            
+            void setViewport(VkCommandBuffer commandBuffer) const noexcept;
+            
+            void setScissor(VkCommandBuffer commandBuffer) const noexcept;
+
+            void drawImage(VkCommandBuffer commandBuffer, std::size_t firstDraw, std::size_t lastDraw) const noexcept;
             
             void endCommandBuffer() const;
             
-            void submitImage() const;
+            void submitImage(std::uint64_t signalValue) const;
             
             void presentImage();
         };
@@ -1,10 +1,90 @@
 #include "mgo_application.hpp"
-int main()
+#include <string_view>
+int main(int argc, char** argv)
 {
     try
     {
-        mgo::Application application;
-        application.run();
+        mgo::ApplicationSettings settings;
+        std::uint64_t frameCount = 0;
+        bool gpuProfile = false;
+        std::string tracePath;
+        std::string traceDumpPath;
+        
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view argument(argv[i]);
+            if (argument == "--headless")
+            {
+                settings.headless_ = true;
+                settings.allowCpuDevice_ = true;
+            }
+            else if (argument == "--gpu-profile")
+                gpuProfile = true;
+            else if (argument == "--trace" && i + 1 < argc)
+                tracePath = argv[++i];
+            else if (argument == "--trace-dump" && i + 1 < argc)
+                traceDumpPath = argv[++i];
+            else if (argument == "--allow-cpu-device")
+                settings.allowCpuDevice_ = true;
+            else if (argument == "--frames" && i + 1 < argc)
+                frameCount = std::stoull(argv[++i]);
+            else if (argument == "--frames-in-flight" && i + 1 < argc)
+                settings.framesInFlight_ = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            else if (argument == "--swapchain-images" && i + 1 < argc)
+                settings.swapchainImageCount_ = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            else if (argument == "--recording-threads" && i + 1 < argc)
+                settings.recordingThreadCount_ = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            else if (argument == "--render-snapshots" && i + 1 < argc)
+                settings.renderSnapshotCount_ = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            else if (argument == "--pipeline-cache" && i + 1 < argc)
+                settings.pipelineCachePath_ = argv[++i];
+            else if (argument == "--present-mode" && i + 1 < argc)
+            {
+                std::string_view presentMode(argv[++i]);
+                if (presentMode == "uncapped")
+                    settings.presentPolicy_ = mgo::vk::PresentPolicy(mgo::vk::PresentPolicy::Mode::UNCAPPED);
+                else if (presentMode == "vsync")
+                    settings.presentPolicy_ = mgo::vk::PresentPolicy(mgo::vk::PresentPolicy::Mode::VSYNC);
+                else if (presentMode == "relaxed-vsync")
+                    settings.presentPolicy_ = mgo::vk::PresentPolicy(mgo::vk::PresentPolicy::Mode::RELAXED_VSYNC);
+                else if (presentMode == "mailbox")
+                    settings.presentPolicy_ = mgo::vk::PresentPolicy(mgo::vk::PresentPolicy::Mode::MAILBOX);
+                else
+                    throw std::runtime_error("Unknown present mode: " + std::string(presentMode));
+            }
+            else
+                throw std::runtime_error("Unknown argument: " + std::string(argument));
+        }
+        
+        if (settings.headless_ && frameCount == 0)
+            throw std::runtime_error("--headless requires --frames <count>!");
+        
+        mgo::trace::Tracer::get().setThreadName("Main");
+        if (!traceDumpPath.empty())
+            mgo::trace::Tracer::get().setEnabled(true);
+        if (!tracePath.empty())
+            mgo::trace::Tracer::get().startStreaming(tracePath);
+        
+        mgo::Application application(settings);
+        if (frameCount == 0)
+            application.run();
+        else
+            application.run(frameCount);
+        
+        if (!traceDumpPath.empty())
+            mgo::trace::Tracer::get().writeChromeTrace(traceDumpPath);
+        mgo::trace::Tracer::get().stopStreaming();
+        
+        if (gpuProfile)
+            for (const std::string& scopeName : application.getGpuProfiler().getScopeNames())
+            {
+                mgo::vk::GpuProfiler::Statistics statistics = application.getGpuProfiler().getStatistics(scopeName).value();
+                MGO_LOG_MESSAGE(scopeName << ": avg " << statistics.averageMilliseconds_
+                                << " ms, p50 " << statistics.p50Milliseconds_
+                                << " ms, p95 " << statistics.p95Milliseconds_
+                                << " ms, p99 " << statistics.p99Milliseconds_
+                                << " ms, fragment invocations " << statistics.pipelineStatistics_[5]);
+            }
     }
     catch (const std::exception& errorMessage)
     {